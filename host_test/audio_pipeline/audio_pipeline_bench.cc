@@ -0,0 +1,524 @@
+/*
+ * Replay benchmark for AudioService on a Linux host.
+ *
+ * The microphone is a PCM file (or a synthetic signal) read through FileAudioCodec. Encoded
+ * packets are sent by the firmware's AudioSender to a loopback protocol, delayed by a simulated
+ * network and pushed back into the decode queue, so one run exercises
+ * AudioInputTask -> OpusCodecTask (encode) -> send queue -> AudioSender -> network ->
+ * jitter buffer -> OpusCodecTask (decode) -> AudioOutputTask.
+ *
+ * A reduced Application main loop runs the injected slow tasks (--main-loop-task). With
+ * --send-from-main-loop it also sends the uplink, as the firmware did before AudioSender.
+ *
+ * The per-stage latency percentiles and queue depths come from AudioProfiler, the benchmark adds
+ * the end-to-end throughput of every stage and the time uplink packets wait to be sent.
+ */
+#include "../../main/audio_sender.h"
+#include "../../main/main_task_scheduler.h"
+#include "audio_service.h"
+#include "board.h"
+#include "file_audio_codec.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TAG "AudioPipelineBench"
+
+struct BenchOptions {
+    std::string input_path;
+    std::string output_path;
+    int input_sample_rate = 16000;
+    int output_sample_rate = 24000;
+    int seconds = 10;
+    int report_interval_seconds = 2;
+    double speed = 1.0;
+    int network_delay_ms = 40;
+    int network_jitter_ms = 20;
+    int network_loss_percent = 0;
+    int uplink_frame_duration_ms = 60;
+    int uplink_bitrate = 0;
+    bool sequenced = true;
+    // Fail the run when the jitter buffer reports more underruns, -1 disables the check
+    int max_underruns = -1;
+    // A main-loop task of this many ms is scheduled every main_loop_period_ms, 0 = none
+    int main_loop_task_ms = 0;
+    int main_loop_period_ms = 1000;
+    bool send_from_main_loop = false;
+    // Every SendAudio blocks this long, like a slow socket
+    int send_delay_ms = 0;
+    // Fail the run when an uplink packet waited longer to be sent, or a protocol reset took longer, -1 disables
+    int max_send_latency_ms = -1;
+    int max_reset_ms = -1;
+};
+
+class HostBoard : public Board {
+public:
+    explicit HostBoard(const BenchOptions& options)
+        : codec_(options.input_sample_rate, options.output_sample_rate, options.input_path, options.output_path,
+            options.speed) {
+    }
+
+    virtual std::string GetBoardType() override {
+        return "host";
+    }
+
+    virtual AudioCodec* GetAudioCodec() override {
+        return &codec_;
+    }
+
+    FileAudioCodec* codec() {
+        return &codec_;
+    }
+
+private:
+    FileAudioCodec codec_;
+};
+
+static BenchOptions bench_options;
+
+void* create_board() {
+    return new HostBoard(bench_options);
+}
+
+/*
+ * Stands in for the server: every uplink packet comes back as a downlink packet after
+ * delay + uniform(0, jitter) ms, or is dropped with the configured probability.
+ */
+class LoopbackNetwork {
+public:
+    LoopbackNetwork(AudioService& audio_service, const BenchOptions& options)
+        : audio_service_(audio_service), options_(options), random_(12345) {
+        thread_ = std::thread([this]() { DeliveryLoop(); });
+    }
+
+    ~LoopbackNetwork() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        condition_variable_.notify_all();
+        thread_.join();
+    }
+
+    void Send(std::unique_ptr<AudioStreamPacket> packet) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packets_sent_++;
+        bytes_sent_ += packet->PayloadSize();
+        // Like the UDP transport, a sequence number lets the jitter buffer reorder the packets and see the lost ones
+        packet->sequence = options_.sequenced ? ++last_sequence_ : 0;
+        if (std::uniform_int_distribution<int>(0, 99)(random_) < options_.network_loss_percent) {
+            packets_dropped_++;
+            return;
+        }
+        int delay_ms = options_.network_delay_ms;
+        if (options_.network_jitter_ms > 0) {
+            delay_ms += std::uniform_int_distribution<int>(0, options_.network_jitter_ms)(random_);
+        }
+        // The network runs on the same clock as the codec, an unpaced run delivers at once
+        auto delay = options_.speed > 0 ? std::chrono::microseconds((int64_t)(delay_ms * 1000 / options_.speed)) :
+            std::chrono::microseconds(0);
+        auto due = std::chrono::steady_clock::now() + delay;
+        in_flight_.push(InFlightPacket { due, order_++, std::move(packet) });
+        condition_variable_.notify_all();
+    }
+
+    void PrintStatistics(double elapsed_seconds) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ESP_LOGI(TAG, "network: sent=%llu (%.1f/s, %.1f kbps) dropped=%llu delivered=%llu rejected=%llu in_flight=%zu",
+            (unsigned long long)packets_sent_, packets_sent_ / elapsed_seconds,
+            bytes_sent_ * 8 / elapsed_seconds / 1000, (unsigned long long)packets_dropped_,
+            (unsigned long long)packets_delivered_, (unsigned long long)packets_rejected_, in_flight_.size());
+    }
+
+private:
+    struct InFlightPacket {
+        std::chrono::steady_clock::time_point due;
+        uint64_t order;
+        // Mutable so the packet can be moved out of the priority queue's top()
+        mutable std::unique_ptr<AudioStreamPacket> packet;
+
+        bool operator>(const InFlightPacket& other) const {
+            return due != other.due ? due > other.due : order > other.order;
+        }
+    };
+
+    AudioService& audio_service_;
+    const BenchOptions& options_;
+    std::mt19937 random_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::priority_queue<InFlightPacket, std::vector<InFlightPacket>, std::greater<InFlightPacket>> in_flight_;
+    uint64_t order_ = 0;
+    uint32_t last_sequence_ = 0;
+    uint64_t packets_sent_ = 0;
+    uint64_t bytes_sent_ = 0;
+    uint64_t packets_dropped_ = 0;
+    uint64_t packets_delivered_ = 0;
+    uint64_t packets_rejected_ = 0;
+    bool stopped_ = false;
+
+    void DeliveryLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_) {
+            if (in_flight_.empty()) {
+                condition_variable_.wait(lock);
+                continue;
+            }
+            auto due = in_flight_.top().due;
+            if (std::chrono::steady_clock::now() < due) {
+                condition_variable_.wait_until(lock, due);
+                continue;
+            }
+            auto packet = std::move(in_flight_.top().packet);
+            in_flight_.pop();
+
+            lock.unlock();
+            bool pushed = audio_service_.PushPacketToDecodeQueue(std::move(packet));
+            lock.lock();
+            if (pushed) {
+                packets_delivered_++;
+            } else {
+                packets_rejected_++;
+            }
+        }
+    }
+};
+
+/*
+ * The protocol AudioSender sends to. Records how long each packet waited in the send queue: the
+ * encoder calls on_send_queue_available once per pushed packet, and the queue is FIFO.
+ */
+class LoopbackProtocol : public Protocol {
+public:
+    LoopbackProtocol(LoopbackNetwork& network, const BenchOptions& options) : network_(network), options_(options) {
+    }
+
+    // Called from on_send_queue_available
+    void OnPacketQueued() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_times_us_.push_back(esp_timer_get_time());
+    }
+
+    virtual bool Start() override { return true; }
+    virtual bool OpenAudioChannel() override { return true; }
+    virtual void CloseAudioChannel(bool send_goodbye = true) override {}
+    virtual bool IsAudioChannelOpened() const override { return true; }
+
+    virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!queued_times_us_.empty()) {
+                send_latencies_us_.push_back(esp_timer_get_time() - queued_times_us_.front());
+                queued_times_us_.pop_front();
+            }
+        }
+        if (options_.send_delay_ms > 0) {
+            sending_ = true;
+            vTaskDelay(pdMS_TO_TICKS(options_.send_delay_ms));
+            sending_ = false;
+        }
+        network_.Send(std::move(packet));
+        return true;
+    }
+
+    bool sending() const { return sending_; }
+
+    // Returns the maximum
+    int64_t PrintSendLatency() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (send_latencies_us_.empty()) {
+            return 0;
+        }
+        auto sorted = send_latencies_us_;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](int percent) { return sorted[(sorted.size() - 1) * percent / 100] / 1000.0; };
+        ESP_LOGI(TAG, "uplink: %zu packets waited p50=%.1fms p99=%.1fms max=%.1fms to be sent", sorted.size(),
+            percentile(50), percentile(99), sorted.back() / 1000.0);
+        return sorted.back();
+    }
+
+private:
+    LoopbackNetwork& network_;
+    const BenchOptions& options_;
+    std::mutex mutex_;
+    std::deque<int64_t> queued_times_us_;
+    std::vector<int64_t> send_latencies_us_;
+    std::atomic<bool> sending_ = false;
+
+    virtual bool SendText(const std::string& text) override { return true; }
+};
+
+#define MAIN_EVENT_SCHEDULE (1 << 0)
+#define MAIN_EVENT_SEND_AUDIO (1 << 1)
+
+/*
+ * Application::Run reduced to the events the uplink competes with: scheduled tasks, and with
+ * --send-from-main-loop the MAIN_EVENT_SEND_AUDIO drain that AudioSender replaced.
+ */
+class MainLoop {
+public:
+    MainLoop(AudioService& audio_service, Protocol& protocol) : audio_service_(audio_service), protocol_(protocol) {
+        event_group_ = xEventGroupCreate();
+        xTaskCreate([](void* arg) {
+            static_cast<MainLoop*>(arg)->Run();
+        }, "main", 4096 * 2, this, 10, nullptr);
+    }
+
+    template <typename F>
+    void Schedule(F&& callback, SchedulePriority priority) {
+        scheduler_.Push(priority, MainTask(std::forward<F>(callback)));
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
+
+    void NotifySendAudio() {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+    }
+
+private:
+    AudioService& audio_service_;
+    Protocol& protocol_;
+    MainTaskScheduler scheduler_;
+    EventGroupHandle_t event_group_;
+
+    void Run() {
+        while (true) {
+            auto bits = xEventGroupWaitBits(event_group_, MAIN_EVENT_SCHEDULE | MAIN_EVENT_SEND_AUDIO, pdTRUE, pdFALSE,
+                portMAX_DELAY);
+            if (bits & MAIN_EVENT_SEND_AUDIO) {
+                while (auto packet = audio_service_.PopPacketFromSendQueue()) {
+                    if (!protocol_.SendAudio(std::move(packet))) {
+                        break;
+                    }
+                }
+            }
+            if (bits & MAIN_EVENT_SCHEDULE) {
+                if (scheduler_.RunPending()) {
+                    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+                }
+            }
+        }
+    }
+};
+
+static AudioService* audio_service = nullptr;
+static LoopbackNetwork* network = nullptr;
+static std::shared_ptr<LoopbackProtocol> loopback_protocol;
+static MainLoop* main_loop = nullptr;
+static AudioSender* audio_sender = nullptr;
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --input FILE           16-bit mono PCM at the input sample rate (default: synthetic signal)\n"
+        "  --output FILE          write the played PCM at the output sample rate\n"
+        "  --input-rate HZ        codec input sample rate (default 16000)\n"
+        "  --output-rate HZ       codec output sample rate (default 24000)\n"
+        "  --seconds N            run time (default 10)\n"
+        "  --report N             seconds between reports (default 2)\n"
+        "  --speed X              codec pacing relative to real time, 0 = unpaced (default 1)\n"
+        "  --delay MS             network delay, scaled by --speed (default 40)\n"
+        "  --jitter MS            extra uniform network delay, scaled by --speed (default 20)\n"
+        "  --loss PERCENT         network packet loss (default 0)\n"
+        "  --frame-duration MS    uplink frame duration, 20/40/60 (default 60)\n"
+        "  --bitrate BPS          uplink bitrate, 0 = encoder default (default 0)\n"
+        "  --unsequenced          no sequence numbers, packets bypass the jitter buffer\n"
+        "  --max-underruns N      exit with an error when the jitter buffer underruns more often\n"
+        "  --main-loop-task MS    schedule a main-loop task that runs this long (default 0 = none)\n"
+        "  --main-loop-period MS  time between those tasks (default 1000)\n"
+        "  --send-from-main-loop  send the uplink from the main loop instead of AudioSender\n"
+        "  --send-delay MS        every send blocks this long, like a slow socket (default 0)\n"
+        "  --max-send-latency MS  exit with an error when an uplink packet waited longer to be sent\n"
+        "  --max-reset MS         exit with an error when resetting the protocol during a send takes longer\n",
+        program);
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+        const char* v = nullptr;
+        if (arg == "--unsequenced") {
+            options.sequenced = false;
+            continue;
+        }
+        if (arg == "--send-from-main-loop") {
+            options.send_from_main_loop = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || (v = value()) == nullptr) {
+            return false;
+        }
+        if (arg == "--input") {
+            options.input_path = v;
+        } else if (arg == "--output") {
+            options.output_path = v;
+        } else if (arg == "--input-rate") {
+            options.input_sample_rate = atoi(v);
+        } else if (arg == "--output-rate") {
+            options.output_sample_rate = atoi(v);
+        } else if (arg == "--seconds") {
+            options.seconds = atoi(v);
+        } else if (arg == "--report") {
+            options.report_interval_seconds = atoi(v);
+        } else if (arg == "--speed") {
+            options.speed = atof(v);
+        } else if (arg == "--delay") {
+            options.network_delay_ms = atoi(v);
+        } else if (arg == "--jitter") {
+            options.network_jitter_ms = atoi(v);
+        } else if (arg == "--loss") {
+            options.network_loss_percent = atoi(v);
+        } else if (arg == "--frame-duration") {
+            options.uplink_frame_duration_ms = atoi(v);
+        } else if (arg == "--bitrate") {
+            options.uplink_bitrate = atoi(v);
+        } else if (arg == "--max-underruns") {
+            options.max_underruns = atoi(v);
+        } else if (arg == "--main-loop-task") {
+            options.main_loop_task_ms = atoi(v);
+        } else if (arg == "--main-loop-period") {
+            options.main_loop_period_ms = atoi(v);
+        } else if (arg == "--send-delay") {
+            options.send_delay_ms = atoi(v);
+        } else if (arg == "--max-send-latency") {
+            options.max_send_latency_ms = atoi(v);
+        } else if (arg == "--max-reset") {
+            options.max_reset_ms = atoi(v);
+        } else {
+            return false;
+        }
+    }
+    return options.input_sample_rate > 0 && options.output_sample_rate > 0 && options.seconds > 0 &&
+        options.report_interval_seconds > 0 && options.main_loop_period_ms > 0;
+}
+
+static void PrintThroughput(FileAudioCodec* codec, double elapsed_seconds) {
+    auto& options = bench_options;
+    ESP_LOGI(TAG, "codec: captured=%.2fs played=%.2fs in %.2fs (x%.2f real time)",
+        (double)codec->samples_read() / options.input_sample_rate,
+        (double)codec->samples_written() / options.output_sample_rate, elapsed_seconds,
+        codec->samples_read() / (double)options.input_sample_rate / elapsed_seconds);
+    network->PrintStatistics(elapsed_seconds);
+}
+
+// A slow MCP tool or display update keeps the main loop busy
+static void InjectMainLoopTasks(void* arg) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(bench_options.main_loop_period_ms));
+        int task_ms = bench_options.main_loop_task_ms;
+        main_loop->Schedule([task_ms]() { vTaskDelay(pdMS_TO_TICKS(task_ms)); }, kSchedulePriorityMcp);
+    }
+}
+
+// Times AudioSender::SetProtocol(nullptr) while a packet is being sent, returns -1 without --send-delay
+static int64_t MeasureProtocolReset() {
+    if (bench_options.send_delay_ms <= 0) {
+        return -1;
+    }
+    int64_t deadline = esp_timer_get_time() + 1000000;
+    while (!loopback_protocol->sending() && esp_timer_get_time() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    int64_t start = esp_timer_get_time();
+    audio_sender->SetProtocol(nullptr);
+    int64_t reset_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "protocol reset during a send took %.2fms", reset_us / 1000.0);
+    return reset_us;
+}
+
+int main(int argc, char** argv) {
+    if (!ParseOptions(argc, argv, bench_options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    auto& board = static_cast<HostBoard&>(Board::GetInstance());
+    auto codec = board.codec();
+
+    audio_service = new AudioService();
+    audio_service->Initialize(codec);
+    audio_service->SetUplinkAudioParams(bench_options.uplink_frame_duration_ms, bench_options.uplink_bitrate);
+    network = new LoopbackNetwork(*audio_service, bench_options);
+    loopback_protocol = std::make_shared<LoopbackProtocol>(*network, bench_options);
+    main_loop = new MainLoop(*audio_service, *loopback_protocol);
+    audio_sender = new AudioSender(*audio_service);
+    audio_sender->SetProtocol(loopback_protocol);
+    audio_sender->Start(7, tskNO_AFFINITY);
+    if (bench_options.main_loop_task_ms > 0) {
+        xTaskCreate(InjectMainLoopTasks, "inject", 4096, nullptr, 1, nullptr);
+    }
+
+    AudioServiceCallbacks callbacks;
+    callbacks.on_send_queue_available = []() {
+        loopback_protocol->OnPacketQueued();
+        if (bench_options.send_from_main_loop) {
+            main_loop->NotifySendAudio();
+        } else {
+            audio_sender->Notify();
+        }
+    };
+    audio_service->SetCallbacks(callbacks);
+
+    audio_service->Start();
+    audio_service->EnableVoiceProcessing(true);
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (int elapsed = 0; elapsed < bench_options.seconds;) {
+        int interval = std::min(bench_options.report_interval_seconds, bench_options.seconds - elapsed);
+        std::this_thread::sleep_for(std::chrono::seconds(interval));
+        elapsed += interval;
+
+        double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        audio_service->PrintDebugStatistics();
+        PrintThroughput(codec, elapsed_seconds);
+    }
+
+    int exit_code = 0;
+    int64_t max_send_latency_us = loopback_protocol->PrintSendLatency();
+    if (bench_options.max_send_latency_ms >= 0 && max_send_latency_us > bench_options.max_send_latency_ms * 1000LL) {
+        ESP_LOGE(TAG, "FAILED: an uplink packet waited %.1fms to be sent, at most %dms expected",
+            max_send_latency_us / 1000.0, bench_options.max_send_latency_ms);
+        exit_code = 1;
+    }
+    int64_t reset_us = bench_options.send_from_main_loop ? -1 : MeasureProtocolReset();
+    if (bench_options.max_reset_ms >= 0 && reset_us > bench_options.max_reset_ms * 1000LL) {
+        ESP_LOGE(TAG, "FAILED: the protocol reset took %.2fms, at most %dms expected", reset_us / 1000.0,
+            bench_options.max_reset_ms);
+        exit_code = 1;
+    }
+
+    JitterBufferStatistics statistics;
+    if (bench_options.max_underruns >= 0 && audio_service->GetJitterBufferStatistics(statistics) &&
+        statistics.underruns > (uint32_t)bench_options.max_underruns) {
+        ESP_LOGE(TAG, "FAILED: %lu jitter buffer underruns, at most %d expected", (unsigned long)statistics.underruns,
+            bench_options.max_underruns);
+        exit_code = 1;
+    }
+
+    audio_service->EnableVoiceProcessing(false);
+    audio_service->Stop();
+    fflush(stdout);
+    fflush(stderr);
+    // The tasks block forever like on the device, leave without running the static destructors under them
+    std::quick_exit(exit_code);
+}
@@ -0,0 +1,107 @@
+#include "file_audio_codec.h"
+
+#include <esp_log.h>
+#include <cmath>
+#include <thread>
+
+#define TAG "FileAudioCodec"
+
+FileAudioCodec::FileAudioCodec(int input_sample_rate, int output_sample_rate, const std::string& input_path,
+    const std::string& output_path, double speed) : speed_(speed) {
+    duplex_ = true;
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+
+    if (!input_path.empty()) {
+        input_file_ = fopen(input_path.c_str(), "rb");
+        if (input_file_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to open %s, using the synthetic input", input_path.c_str());
+        }
+    }
+    if (!output_path.empty()) {
+        output_file_ = fopen(output_path.c_str(), "wb");
+        if (output_file_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to open %s, output is discarded", output_path.c_str());
+        }
+    }
+    input_end_time_ = output_end_time_ = std::chrono::steady_clock::now();
+}
+
+FileAudioCodec::~FileAudioCodec() {
+    if (input_file_ != nullptr) {
+        fclose(input_file_);
+    }
+    if (output_file_ != nullptr) {
+        fclose(output_file_);
+    }
+}
+
+std::chrono::microseconds FileAudioCodec::Duration(int samples, int sample_rate) const {
+    return std::chrono::microseconds((int64_t)(samples * 1000000.0 / sample_rate / speed_));
+}
+
+void FileAudioCodec::PaceInput(int samples) {
+    if (speed_ <= 0) {
+        return;
+    }
+    // Samples are captured in real time, when the reader falls further behind than the DMA ring the oldest are lost
+    auto now = std::chrono::steady_clock::now();
+    if (now - input_end_time_ > Duration(AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM, input_sample_rate_)) {
+        input_end_time_ = now;
+    }
+    input_end_time_ += Duration(samples, input_sample_rate_);
+    std::this_thread::sleep_until(input_end_time_);
+}
+
+void FileAudioCodec::PaceOutput(int samples) {
+    if (speed_ <= 0) {
+        return;
+    }
+    // An empty DMA ring plays silence, so the new samples start now. Writing blocks while the ring is full.
+    auto now = std::chrono::steady_clock::now();
+    if (output_end_time_ < now) {
+        output_end_time_ = now;
+    }
+    output_end_time_ += Duration(samples, output_sample_rate_);
+    std::this_thread::sleep_until(output_end_time_ -
+        Duration(AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM, output_sample_rate_));
+}
+
+int FileAudioCodec::Read(int16_t* dest, int samples) {
+    PaceInput(samples);
+
+    int filled = 0;
+    if (input_file_ != nullptr) {
+        while (filled < samples) {
+            size_t n = fread(dest + filled, sizeof(int16_t), samples - filled, input_file_);
+            if (n == 0) {
+                rewind(input_file_);
+                if (fread(dest + filled, sizeof(int16_t), 1, input_file_) == 0) {
+                    break;  // Empty file
+                }
+                n = 1;
+            }
+            filled += n;
+        }
+    }
+
+    // 300 Hz tone in 1.2 s talk spurts with 0.8 s pauses, so DTX and VAD see both speech and silence
+    for (; filled < samples; filled++, synthetic_position_++) {
+        uint64_t period_position = synthetic_position_ % (input_sample_rate_ * 2);
+        bool talking = period_position < (uint64_t)input_sample_rate_ * 6 / 5;
+        double phase = 2.0 * M_PI * 300.0 * synthetic_position_ / input_sample_rate_;
+        dest[filled] = talking ? (int16_t)(8000.0 * std::sin(phase)) : 0;
+    }
+
+    samples_read_ += samples;
+    return samples;
+}
+
+int FileAudioCodec::Write(const int16_t* data, int samples) {
+    PaceOutput(samples);
+    if (output_file_ != nullptr) {
+        fwrite(data, sizeof(int16_t), samples, output_file_);
+    }
+    samples_written_ += samples;
+    return samples;
+}
@@ -0,0 +1,47 @@
+#ifndef FILE_AUDIO_CODEC_H
+#define FILE_AUDIO_CODEC_H
+
+#include "audio_codec.h"
+
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <string>
+
+/*
+ * An AudioCodec backed by files instead of I2S.
+ *
+ * Read() returns 16-bit mono PCM from the input file (looped), or a synthetic talk-spurt signal
+ * when there is no file. Write() appends to the output file when one is given. Both sides are
+ * paced like an I2S channel with a DMA ring of AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM
+ * samples, at `speed` times real time. A speed of 0 disables pacing.
+ */
+class FileAudioCodec : public AudioCodec {
+public:
+    FileAudioCodec(int input_sample_rate, int output_sample_rate, const std::string& input_path,
+        const std::string& output_path, double speed);
+    virtual ~FileAudioCodec();
+
+    uint64_t samples_read() const { return samples_read_; }
+    uint64_t samples_written() const { return samples_written_; }
+
+private:
+    FILE* input_file_ = nullptr;
+    FILE* output_file_ = nullptr;
+    double speed_;
+    uint64_t synthetic_position_ = 0;
+    // When the samples read so far were captured, and when the samples written so far finish playing
+    std::chrono::steady_clock::time_point input_end_time_;
+    std::chrono::steady_clock::time_point output_end_time_;
+    std::atomic<uint64_t> samples_read_ = 0;
+    std::atomic<uint64_t> samples_written_ = 0;
+
+    std::chrono::microseconds Duration(int samples, int sample_rate) const;
+    void PaceInput(int samples);
+    void PaceOutput(int samples);
+
+    virtual int Read(int16_t* dest, int samples) override;
+    virtual int Write(const int16_t* data, int samples) override;
+};
+
+#endif // FILE_AUDIO_CODEC_H
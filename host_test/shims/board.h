@@ -0,0 +1,28 @@
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <string>
+
+// The host board only provides the audio codec, create_board() is defined by the benchmark
+void* create_board();
+class AudioCodec;
+class Board {
+private:
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
+
+protected:
+    Board() = default;
+
+public:
+    static Board& GetInstance() {
+        static Board* instance = static_cast<Board*>(create_board());
+        return *instance;
+    }
+
+    virtual ~Board() = default;
+    virtual std::string GetBoardType() = 0;
+    virtual AudioCodec* GetAudioCodec() = 0;
+};
+
+#endif // HOST_BOARD_H
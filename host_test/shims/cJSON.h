@@ -0,0 +1,50 @@
+#ifndef HOST_CJSON_H
+#define HOST_CJSON_H
+
+#include <cstddef>
+
+/*
+ * The numbers Protocol reads and writes in the audio params, and a parser that builds the
+ * same tree as cJSON (one node per value, keys and strings copied through the hooks) so the
+ * unit tests can compare JsonReader with it. The parser is strict RFC 8259 and member lookup
+ * is case-sensitive, the real cJSON is more lenient in both.
+ */
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+typedef struct cJSON_Hooks {
+    void* (*malloc_fn)(size_t size);
+    void (*free_fn)(void* pointer);
+} cJSON_Hooks;
+
+#define cJSON_False (1 << 0)
+#define cJSON_True (1 << 1)
+#define cJSON_NULL (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array (1 << 5)
+#define cJSON_Object (1 << 6)
+
+#define CJSON_NESTING_LIMIT 1000
+
+// nullptr restores malloc/free
+void cJSON_InitHooks(cJSON_Hooks* hooks);
+
+cJSON* cJSON_ParseWithLength(const char* value, size_t length);
+cJSON* cJSON_CreateObject();
+void cJSON_Delete(cJSON* item);
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number);
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* name);
+bool cJSON_IsNumber(const cJSON* item);
+bool cJSON_IsString(const cJSON* item);
+bool cJSON_IsObject(const cJSON* item);
+
+#endif // HOST_CJSON_H
@@ -0,0 +1,351 @@
+#include "cJSON.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static cJSON_Hooks hooks = { malloc, free };
+
+void cJSON_InitHooks(cJSON_Hooks* new_hooks) {
+    hooks = new_hooks != nullptr ? *new_hooks : cJSON_Hooks{ malloc, free };
+}
+
+static cJSON* NewItem(int type) {
+    auto item = (cJSON*)hooks.malloc_fn(sizeof(cJSON));
+    if (item != nullptr) {
+        memset(item, 0, sizeof(cJSON));
+        item->type = type;
+    }
+    return item;
+}
+
+static char* CopyString(const char* data, size_t length) {
+    auto copy = (char*)hooks.malloc_fn(length + 1);
+    if (copy != nullptr) {
+        memcpy(copy, data, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+namespace {
+
+// Recursive descent like cJSON, limited to CJSON_NESTING_LIMIT levels
+class Parser {
+public:
+    Parser(const char* data, size_t length) : p_(data), end_(data + length) {}
+
+    cJSON* ParseValue() {
+        SkipWhitespace();
+        if (p_ >= end_) {
+            return nullptr;
+        }
+        switch (*p_) {
+            case '{': return ParseContainer(cJSON_Object, '}');
+            case '[': return ParseContainer(cJSON_Array, ']');
+            case '"': return ParseStringItem();
+            case 't': return ParseLiteral("true", cJSON_True);
+            case 'f': return ParseLiteral("false", cJSON_False);
+            case 'n': return ParseLiteral("null", cJSON_NULL);
+            default: return ParseNumber();
+        }
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    int depth_ = 0;
+
+    void SkipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            p_++;
+        }
+    }
+
+    cJSON* ParseLiteral(const char* literal, int type) {
+        size_t length = strlen(literal);
+        if ((size_t)(end_ - p_) < length || memcmp(p_, literal, length) != 0) {
+            return nullptr;
+        }
+        p_ += length;
+        cJSON* item = NewItem(type);
+        if (item != nullptr && type == cJSON_True) {
+            item->valueint = 1;
+        }
+        return item;
+    }
+
+    size_t Digits() {
+        const char* start = p_;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            p_++;
+        }
+        return p_ - start;
+    }
+
+    cJSON* ParseNumber() {
+        const char* start = p_;
+        if (p_ < end_ && *p_ == '-') {
+            p_++;
+        }
+        if (p_ < end_ && *p_ == '0') {
+            p_++;
+        } else if (Digits() == 0) {
+            return nullptr;
+        }
+        if (p_ < end_ && *p_ == '.') {
+            p_++;
+            if (Digits() == 0) {
+                return nullptr;
+            }
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            p_++;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                p_++;
+            }
+            if (Digits() == 0) {
+                return nullptr;
+            }
+        }
+        cJSON* item = NewItem(cJSON_Number);
+        if (item != nullptr) {
+            item->valuedouble = strtod(std::string(start, p_ - start).c_str(), nullptr);
+            item->valueint = (int)item->valuedouble;
+        }
+        return item;
+    }
+
+    int Hex4() {
+        if (end_ - p_ < 4) {
+            return -1;
+        }
+        int value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = p_[i];
+            int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (digit < 0) {
+                return -1;
+            }
+            value = value * 16 + digit;
+        }
+        p_ += 4;
+        return value;
+    }
+
+    static void AppendUtf8(std::string& out, uint32_t code_point) {
+        if (code_point < 0x80) {
+            out += (char)code_point;
+        } else if (code_point < 0x800) {
+            out += (char)(0xC0 | (code_point >> 6));
+            out += (char)(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            out += (char)(0xE0 | (code_point >> 12));
+            out += (char)(0x80 | ((code_point >> 6) & 0x3F));
+            out += (char)(0x80 | (code_point & 0x3F));
+        } else {
+            out += (char)(0xF0 | (code_point >> 18));
+            out += (char)(0x80 | ((code_point >> 12) & 0x3F));
+            out += (char)(0x80 | ((code_point >> 6) & 0x3F));
+            out += (char)(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    // Decoded into a copy made with the hooks, a lone surrogate becomes U+FFFD
+    char* ParseString() {
+        p_++;
+        std::string out;
+        while (p_ < end_ && *p_ != '"') {
+            char c = *p_++;
+            if ((unsigned char)c < 0x20) {
+                return nullptr;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (p_ >= end_) {
+                return nullptr;
+            }
+            switch (*p_++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    int code_point = Hex4();
+                    if (code_point < 0) {
+                        return nullptr;
+                    }
+                    if (code_point >= 0xD800 && code_point < 0xDC00) {
+                        const char* after_high = p_;
+                        int low = -1;
+                        if (end_ - p_ >= 2 && p_[0] == '\\' && p_[1] == 'u') {
+                            p_ += 2;
+                            low = Hex4();
+                        }
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            p_ = after_high;
+                            code_point = 0xFFFD;
+                        }
+                    } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+                        code_point = 0xFFFD;
+                    }
+                    AppendUtf8(out, code_point);
+                    break;
+                }
+                default:
+                    return nullptr;
+            }
+        }
+        if (p_ >= end_) {
+            return nullptr;
+        }
+        p_++;
+        return CopyString(out.data(), out.size());
+    }
+
+    cJSON* ParseStringItem() {
+        char* value = ParseString();
+        if (value == nullptr) {
+            return nullptr;
+        }
+        cJSON* item = NewItem(cJSON_String);
+        if (item == nullptr) {
+            hooks.free_fn(value);
+            return nullptr;
+        }
+        item->valuestring = value;
+        return item;
+    }
+
+    cJSON* ParseContainer(int type, char close) {
+        if (++depth_ > CJSON_NESTING_LIMIT) {
+            return nullptr;
+        }
+        p_++;
+        cJSON* container = NewItem(type);
+        if (container == nullptr) {
+            return nullptr;
+        }
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == close) {
+            p_++;
+            depth_--;
+            return container;
+        }
+        cJSON** tail = &container->child;
+        while (true) {
+            char* key = nullptr;
+            if (type == cJSON_Object) {
+                SkipWhitespace();
+                if (p_ >= end_ || *p_ != '"' || (key = ParseString()) == nullptr) {
+                    break;
+                }
+                SkipWhitespace();
+                if (p_ >= end_ || *p_ != ':') {
+                    hooks.free_fn(key);
+                    break;
+                }
+                p_++;
+            }
+            cJSON* item = ParseValue();
+            if (item == nullptr) {
+                if (key != nullptr) {
+                    hooks.free_fn(key);
+                }
+                break;
+            }
+            item->string = key;
+            *tail = item;
+            tail = &item->next;
+
+            SkipWhitespace();
+            if (p_ < end_ && *p_ == ',') {
+                p_++;
+                continue;
+            }
+            if (p_ < end_ && *p_ == close) {
+                p_++;
+                depth_--;
+                return container;
+            }
+            break;
+        }
+        cJSON_Delete(container);
+        return nullptr;
+    }
+};
+
+} // namespace
+
+cJSON* cJSON_ParseWithLength(const char* value, size_t length) {
+    if (value == nullptr) {
+        return nullptr;
+    }
+    return Parser(value, length).ParseValue();
+}
+
+cJSON* cJSON_CreateObject() {
+    return NewItem(cJSON_Object);
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        if (item->valuestring != nullptr) {
+            hooks.free_fn(item->valuestring);
+        }
+        if (item->string != nullptr) {
+            hooks.free_fn(item->string);
+        }
+        hooks.free_fn(item);
+        item = next;
+    }
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number) {
+    cJSON* item = NewItem(cJSON_Number);
+    item->valuedouble = number;
+    item->valueint = (int)number;
+    item->string = CopyString(name, strlen(name));
+
+    cJSON** tail = &object->child;
+    while (*tail != nullptr) {
+        tail = &(*tail)->next;
+    }
+    *tail = item;
+    return item;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* name) {
+    if (object == nullptr) {
+        return nullptr;
+    }
+    for (cJSON* item = object->child; item != nullptr; item = item->next) {
+        if (item->string != nullptr && strcmp(item->string, name) == 0) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+bool cJSON_IsNumber(const cJSON* item) {
+    return item != nullptr && (item->type & cJSON_Number) != 0;
+}
+
+bool cJSON_IsString(const cJSON* item) {
+    return item != nullptr && (item->type & cJSON_String) != 0;
+}
+
+bool cJSON_IsObject(const cJSON* item) {
+    return item != nullptr && (item->type & cJSON_Object) != 0;
+}
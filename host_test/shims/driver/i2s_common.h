@@ -0,0 +1,12 @@
+#ifndef HOST_DRIVER_I2S_COMMON_H
+#define HOST_DRIVER_I2S_COMMON_H
+
+#include "esp_err.h"
+
+// There is no I2S on the host, codecs read and write files instead (see FileAudioCodec)
+typedef struct i2s_channel_obj_t* i2s_chan_handle_t;
+
+inline esp_err_t i2s_channel_enable(i2s_chan_handle_t handle) { (void)handle; return ESP_OK; }
+inline esp_err_t i2s_channel_disable(i2s_chan_handle_t handle) { (void)handle; return ESP_OK; }
+
+#endif // HOST_DRIVER_I2S_COMMON_H
@@ -0,0 +1,70 @@
+#include "esp_ae_rate_cvt.h"
+
+#include <cstring>
+
+struct HostRateConverter {
+    esp_ae_rate_cvt_cfg_t config;
+    // Position of the next output sample in input samples, in 1/dest_rate units
+    uint64_t phase = 0;
+    int16_t last[8] = {};
+};
+
+esp_ae_err_t esp_ae_rate_cvt_open(esp_ae_rate_cvt_cfg_t* cfg, esp_ae_rate_cvt_handle_t* handle) {
+    if (cfg == nullptr || handle == nullptr || cfg->src_rate == 0 || cfg->dest_rate == 0 ||
+        cfg->channel == 0 || cfg->channel > 8 || cfg->bits_per_sample != ESP_AUDIO_BIT16) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+    auto converter = new HostRateConverter();
+    converter->config = *cfg;
+    *handle = converter;
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_ae_err_t esp_ae_rate_cvt_get_max_out_sample_num(esp_ae_rate_cvt_handle_t handle, uint32_t in_sample_num,
+    uint32_t* out_sample_num) {
+    auto converter = (HostRateConverter*)handle;
+    *out_sample_num = (uint64_t)in_sample_num * converter->config.dest_rate / converter->config.src_rate + 2;
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_ae_err_t esp_ae_rate_cvt_process(esp_ae_rate_cvt_handle_t handle, esp_ae_sample_t in_samples, uint32_t in_sample_num,
+    esp_ae_sample_t out_samples, uint32_t* out_sample_num) {
+    auto converter = (HostRateConverter*)handle;
+    auto in = (const int16_t*)in_samples;
+    auto out = (int16_t*)out_samples;
+    const int channels = converter->config.channel;
+    const uint64_t src = converter->config.src_rate;
+    const uint64_t dest = converter->config.dest_rate;
+
+    // Input sample i is at phase i * dest, the sample before the block is the last one of the previous block
+    uint32_t produced = 0;
+    uint64_t end = (uint64_t)in_sample_num * dest;
+    while (converter->phase < end && produced < *out_sample_num) {
+        uint64_t index = converter->phase / dest;
+        uint64_t fraction = converter->phase % dest;
+        for (int c = 0; c < channels; c++) {
+            int32_t a = index == 0 ? converter->last[c] : in[(index - 1) * channels + c];
+            int32_t b = in[index * channels + c];
+            out[produced * channels + c] = (int16_t)(a + (b - a) * (int64_t)fraction / (int64_t)dest);
+        }
+        produced++;
+        converter->phase += src;
+    }
+    converter->phase -= end;
+    if (in_sample_num > 0) {
+        memcpy(converter->last, in + (in_sample_num - 1) * channels, channels * sizeof(int16_t));
+    }
+    *out_sample_num = produced;
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_ae_err_t esp_ae_rate_cvt_reset(esp_ae_rate_cvt_handle_t handle) {
+    auto converter = (HostRateConverter*)handle;
+    converter->phase = 0;
+    memset(converter->last, 0, sizeof(converter->last));
+    return ESP_AUDIO_ERR_OK;
+}
+
+void esp_ae_rate_cvt_close(esp_ae_rate_cvt_handle_t handle) {
+    delete (HostRateConverter*)handle;
+}
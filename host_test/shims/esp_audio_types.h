@@ -0,0 +1,24 @@
+#ifndef HOST_ESP_AUDIO_TYPES_H
+#define HOST_ESP_AUDIO_TYPES_H
+
+#include <cstdint>
+
+/*
+ * The part of esp_audio_codec used by AudioService. With libopus the encoder and decoder are
+ * real, without it they copy PCM through so the pipeline timing can still be measured.
+ */
+
+typedef enum {
+    ESP_AUDIO_ERR_OK = 0,
+    ESP_AUDIO_ERR_FAIL = -1,
+    ESP_AUDIO_ERR_MEM_LACK = -2,
+    ESP_AUDIO_ERR_INVALID_PARAMETER = -4,
+    ESP_AUDIO_ERR_BUFF_NOT_ENOUGH = -6,
+} esp_audio_err_t;
+
+#define ESP_AUDIO_SAMPLE_RATE_16K 16000
+#define ESP_AUDIO_MONO 1
+#define ESP_AUDIO_DUAL 2
+#define ESP_AUDIO_BIT16 16
+
+#endif // HOST_ESP_AUDIO_TYPES_H
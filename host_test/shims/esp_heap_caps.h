@@ -0,0 +1,44 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/*
+ * heap_caps on malloc. Every capability is served by the same heap, the PSRAM size that
+ * heap_caps_get_total_size reports is host_psram_size (8 MB unless a test changes it).
+ */
+
+#define MALLOC_CAP_DEFAULT (1 << 12)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline size_t host_psram_size = 8 * 1024 * 1024;
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+inline void* heap_caps_calloc(size_t count, size_t size, uint32_t caps) {
+    (void)caps;
+    return calloc(count, size);
+}
+
+inline void* heap_caps_calloc_prefer(size_t count, size_t size, size_t num, ...) {
+    (void)num;
+    return calloc(count, size);
+}
+
+inline void heap_caps_free(void* pointer) {
+    free(pointer);
+}
+
+inline size_t heap_caps_get_total_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? host_psram_size : 512 * 1024;
+}
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,199 @@
+#include "esp_http_client.h"
+
+#include <netdb.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct esp_http_client {
+    std::string host;
+    std::string port;
+    std::string path;
+    esp_http_client_method_t method;
+    int timeout_ms;
+    bool keep_alive;
+    std::vector<std::pair<std::string, std::string>> headers;
+    const char* post_data = nullptr;
+    int post_len = 0;
+    int fd = -1;
+    int status_code = 0;
+    int64_t content_length = 0;
+};
+
+static void CloseConnection(esp_http_client_handle_t client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+static bool Connect(esp_http_client_handle_t client) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(client->host.c_str(), client->port.c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+    for (addrinfo* address = addresses; address != nullptr && client->fd < 0; address = address->ai_next) {
+        int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            continue;
+        }
+        timeval timeout = { client->timeout_ms / 1000, (client->timeout_ms % 1000) * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        client->fd = fd;
+    }
+    freeaddrinfo(addresses);
+    return client->fd >= 0;
+}
+
+static bool SendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+// Reads the status line, the headers and a Content-Length body, returns false on a timeout or EOF
+static bool ReadResponse(esp_http_client_handle_t client, bool& server_closes) {
+    std::string response;
+    char buffer[1024];
+    size_t header_end;
+    while ((header_end = response.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t received = recv(client->fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return false;
+        }
+        response.append(buffer, received);
+    }
+    if (sscanf(response.c_str(), "HTTP/1.%*d %d", &client->status_code) != 1) {
+        return false;
+    }
+    client->content_length = 0;
+    server_closes = false;
+    size_t line = response.find("\r\n") + 2;
+    while (line < header_end) {
+        size_t line_end = response.find("\r\n", line);
+        std::string header = response.substr(line, line_end - line);
+        if (strncasecmp(header.c_str(), "Content-Length:", 15) == 0) {
+            client->content_length = atoll(header.c_str() + 15);
+        } else if (strncasecmp(header.c_str(), "Connection:", 11) == 0 && header.find("close") != std::string::npos) {
+            server_closes = true;
+        }
+        line = line_end + 2;
+    }
+    int64_t body = (int64_t)(response.size() - header_end - 4);
+    while (body < client->content_length) {
+        ssize_t received = recv(client->fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return false;
+        }
+        body += received;
+    }
+    return true;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config) {
+    std::string url = config->url != nullptr ? config->url : "";
+    if (url.compare(0, 7, "http://") != 0) {
+        return nullptr;
+    }
+    auto client = new esp_http_client();
+    size_t path_start = url.find('/', 7);
+    std::string authority = url.substr(7, path_start == std::string::npos ? std::string::npos : path_start - 7);
+    client->path = path_start == std::string::npos ? "/" : url.substr(path_start);
+    size_t colon = authority.rfind(':');
+    client->host = authority.substr(0, colon);
+    client->port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+    client->method = config->method;
+    client->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 5000;
+    client->keep_alive = config->keep_alive_enable;
+    client->headers.emplace_back("User-Agent", config->user_agent != nullptr ? config->user_agent : "ESP32 HTTP Client/1.0");
+    return client;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    CloseConnection(client);
+    delete client;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char* key, const char* value) {
+    for (auto& header : client->headers) {
+        if (strcasecmp(header.first.c_str(), key) == 0) {
+            header.second = value;
+            return ESP_OK;
+        }
+    }
+    client->headers.emplace_back(key, value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char* data, int len) {
+    client->post_data = data;
+    client->post_len = len;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client) {
+    client->status_code = 0;
+    client->content_length = 0;
+    if (client->fd < 0 && !Connect(client)) {
+        return ESP_ERR_HTTP_CONNECT;
+    }
+
+    std::string request = std::string(client->method == HTTP_METHOD_POST ? "POST " : "GET ") + client->path + " HTTP/1.1\r\n";
+    request += "Host: " + client->host + "\r\n";
+    for (const auto& header : client->headers) {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    if (client->method == HTTP_METHOD_POST) {
+        request += "Content-Length: " + std::to_string(client->post_len) + "\r\n";
+    }
+    if (!client->keep_alive) {
+        request += "Connection: close\r\n";
+    }
+    request += "\r\n";
+    if (client->method == HTTP_METHOD_POST && client->post_len > 0) {
+        request.append(client->post_data, client->post_len);
+    }
+    if (!SendAll(client->fd, request.data(), request.size())) {
+        CloseConnection(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+
+    bool server_closes = false;
+    if (!ReadResponse(client, server_closes)) {
+        CloseConnection(client);
+        return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+    if (server_closes || !client->keep_alive) {
+        CloseConnection(client);
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->status_code;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client) {
+    return client->content_length;
+}
@@ -0,0 +1,31 @@
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <cstdio>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+// Log levels as in ESP-IDF, the host build prints INFO and above unless HOST_LOG_LEVEL is set
+#define HOST_LOG_ERROR 1
+#define HOST_LOG_WARN 2
+#define HOST_LOG_INFO 3
+#define HOST_LOG_DEBUG 4
+#define HOST_LOG_VERBOSE 5
+
+#ifndef HOST_LOG_LEVEL
+#define HOST_LOG_LEVEL HOST_LOG_INFO
+#endif
+
+#define HOST_LOG(level, letter, tag, format, ...) do {                                  \
+        if (level <= HOST_LOG_LEVEL) {                                                  \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);           \
+        }                                                                               \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(HOST_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(HOST_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(HOST_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(HOST_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(HOST_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,201 @@
+#include "esp_opus_enc.h"
+#include "esp_opus_dec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if HOST_HAVE_OPUS
+#include <opus.h>
+#endif
+
+static int FrameDurationUs(int duration) {
+    static const int kDurationsUs[] = { 2500, 5000, 10000, 20000, 40000, 60000, 80000, 100000, 120000 };
+    if (duration < 0 || duration >= (int)(sizeof(kDurationsUs) / sizeof(kDurationsUs[0]))) {
+        return -1;
+    }
+    return kDurationsUs[duration];
+}
+
+struct HostOpusEncoder {
+    esp_opus_enc_config_t config;
+    int frame_samples;
+#if HOST_HAVE_OPUS
+    OpusEncoder* encoder;
+#endif
+};
+
+struct HostOpusDecoder {
+    esp_opus_dec_cfg_t config;
+    int frame_samples;
+#if HOST_HAVE_OPUS
+    OpusDecoder* decoder;
+#endif
+};
+
+esp_audio_err_t esp_opus_enc_open(void* cfg, uint32_t cfg_sz, void** enc_hd) {
+    if (cfg == nullptr || cfg_sz != sizeof(esp_opus_enc_config_t) || enc_hd == nullptr) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+    auto config = (esp_opus_enc_config_t*)cfg;
+    int duration_us = FrameDurationUs(config->frame_duration);
+    if (duration_us < 0) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+    auto encoder = new HostOpusEncoder();
+    encoder->config = *config;
+    encoder->frame_samples = (int)((int64_t)config->sample_rate * duration_us / 1000000) * config->channel;
+#if HOST_HAVE_OPUS
+    int error = 0;
+    int application = config->application_mode == ESP_OPUS_ENC_APPLICATION_VOIP ? OPUS_APPLICATION_VOIP :
+        config->application_mode == ESP_OPUS_ENC_APPLICATION_LOWDELAY ? OPUS_APPLICATION_RESTRICTED_LOWDELAY :
+        OPUS_APPLICATION_AUDIO;
+    encoder->encoder = opus_encoder_create(config->sample_rate, config->channel, application, &error);
+    if (encoder->encoder == nullptr) {
+        delete encoder;
+        return ESP_AUDIO_ERR_FAIL;
+    }
+    opus_encoder_ctl(encoder->encoder, OPUS_SET_BITRATE(config->bitrate == ESP_OPUS_BITRATE_AUTO ? OPUS_AUTO : config->bitrate));
+    opus_encoder_ctl(encoder->encoder, OPUS_SET_COMPLEXITY(config->complexity));
+    opus_encoder_ctl(encoder->encoder, OPUS_SET_INBAND_FEC(config->enable_fec ? 1 : 0));
+    opus_encoder_ctl(encoder->encoder, OPUS_SET_DTX(config->enable_dtx ? 1 : 0));
+    opus_encoder_ctl(encoder->encoder, OPUS_SET_VBR(config->enable_vbr ? 1 : 0));
+#endif
+    *enc_hd = encoder;
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_enc_get_frame_size(void* enc_hd, int* in_size, int* out_size) {
+    auto encoder = (HostOpusEncoder*)enc_hd;
+    *in_size = encoder->frame_samples * sizeof(int16_t);
+#if HOST_HAVE_OPUS
+    *out_size = 1276 * 3;
+#else
+    *out_size = *in_size;
+#endif
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_enc_set_bitrate(void* enc_hd, int bitrate) {
+    auto encoder = (HostOpusEncoder*)enc_hd;
+    encoder->config.bitrate = bitrate;
+#if HOST_HAVE_OPUS
+    if (opus_encoder_ctl(encoder->encoder, OPUS_SET_BITRATE(bitrate)) != OPUS_OK) {
+        return ESP_AUDIO_ERR_FAIL;
+    }
+#endif
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_enc_process(void* enc_hd, esp_audio_enc_in_frame_t* in_frame, esp_audio_enc_out_frame_t* out_frame) {
+    auto encoder = (HostOpusEncoder*)enc_hd;
+    if (in_frame->len != encoder->frame_samples * sizeof(int16_t)) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+#if HOST_HAVE_OPUS
+    int frame_size = encoder->frame_samples / encoder->config.channel;
+    int bytes = opus_encode(encoder->encoder, (const opus_int16*)in_frame->buffer, frame_size,
+        out_frame->buffer, out_frame->len);
+    if (bytes < 0) {
+        return ESP_AUDIO_ERR_FAIL;
+    }
+    out_frame->encoded_bytes = bytes;
+#else
+    // Pass-through: the "packet" is the PCM frame itself
+    if (out_frame->len < in_frame->len) {
+        return ESP_AUDIO_ERR_BUFF_NOT_ENOUGH;
+    }
+    memcpy(out_frame->buffer, in_frame->buffer, in_frame->len);
+    out_frame->encoded_bytes = in_frame->len;
+#endif
+    return ESP_AUDIO_ERR_OK;
+}
+
+void esp_opus_enc_close(void* enc_hd) {
+    auto encoder = (HostOpusEncoder*)enc_hd;
+#if HOST_HAVE_OPUS
+    opus_encoder_destroy(encoder->encoder);
+#endif
+    delete encoder;
+}
+
+esp_audio_err_t esp_opus_dec_open(void* cfg, uint32_t cfg_sz, void** dec_handle) {
+    if (cfg == nullptr || cfg_sz != sizeof(esp_opus_dec_cfg_t) || dec_handle == nullptr) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+    auto config = (esp_opus_dec_cfg_t*)cfg;
+    int duration_us = FrameDurationUs(config->frame_duration);
+    if (duration_us < 0) {
+        return ESP_AUDIO_ERR_INVALID_PARAMETER;
+    }
+    auto decoder = new HostOpusDecoder();
+    decoder->config = *config;
+    decoder->frame_samples = (int)((int64_t)config->sample_rate * duration_us / 1000000) * config->channel;
+#if HOST_HAVE_OPUS
+    int error = 0;
+    decoder->decoder = opus_decoder_create(config->sample_rate, config->channel, &error);
+    if (decoder->decoder == nullptr) {
+        delete decoder;
+        return ESP_AUDIO_ERR_FAIL;
+    }
+#endif
+    *dec_handle = decoder;
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_dec_decode(void* dec_handle, esp_audio_dec_in_raw_t* raw, esp_audio_dec_out_frame_t* frame,
+    esp_audio_dec_info_t* dec_info) {
+    auto decoder = (HostOpusDecoder*)dec_handle;
+    uint32_t frame_bytes = decoder->frame_samples * sizeof(int16_t);
+    if (frame->len < frame_bytes) {
+        frame->needed_size = frame_bytes;
+        return ESP_AUDIO_ERR_BUFF_NOT_ENOUGH;
+    }
+#if HOST_HAVE_OPUS
+    int frame_size = decoder->frame_samples / decoder->config.channel;
+    int samples;
+    if (raw->frame_recover == ESP_AUDIO_DEC_RECOVERY_PLC) {
+        samples = opus_decode(decoder->decoder, nullptr, 0, (opus_int16*)frame->buffer, frame_size, 0);
+    } else {
+        samples = opus_decode(decoder->decoder, raw->buffer, raw->len, (opus_int16*)frame->buffer, frame_size,
+            raw->frame_recover == ESP_AUDIO_DEC_RECOVERY_FEC ? 1 : 0);
+    }
+    if (samples < 0) {
+        return ESP_AUDIO_ERR_FAIL;
+    }
+    frame->decoded_size = samples * decoder->config.channel * sizeof(int16_t);
+#else
+    // Pass-through: packets produced by the host encoder are PCM, anything else plays as silence
+    uint32_t copy = raw->frame_recover == ESP_AUDIO_DEC_RECOVERY_PLC ? 0 : std::min(raw->len, frame_bytes);
+    if (copy > 0) {
+        memcpy(frame->buffer, raw->buffer, copy);
+    }
+    memset(frame->buffer + copy, 0, frame_bytes - copy);
+    frame->decoded_size = frame_bytes;
+#endif
+    raw->consumed = raw->len;
+    if (dec_info != nullptr) {
+        dec_info->sample_rate = decoder->config.sample_rate;
+        dec_info->channel = decoder->config.channel;
+        dec_info->bits_per_sample = ESP_AUDIO_BIT16;
+    }
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_dec_reset(void* dec_handle) {
+#if HOST_HAVE_OPUS
+    auto decoder = (HostOpusDecoder*)dec_handle;
+    opus_decoder_ctl(decoder->decoder, OPUS_RESET_STATE);
+#else
+    (void)dec_handle;
+#endif
+    return ESP_AUDIO_ERR_OK;
+}
+
+esp_audio_err_t esp_opus_dec_close(void* dec_handle) {
+    auto decoder = (HostOpusDecoder*)dec_handle;
+#if HOST_HAVE_OPUS
+    opus_decoder_destroy(decoder->decoder);
+#endif
+    delete decoder;
+    return ESP_AUDIO_ERR_OK;
+}
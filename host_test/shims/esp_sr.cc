@@ -0,0 +1,23 @@
+#include "model_path.h"
+#include "esp_wn_models.h"
+
+srmodel_list_t* esp_srmodel_init(const char* partition_label) {
+    (void)partition_label;
+    return nullptr;
+}
+
+void esp_srmodel_deinit(srmodel_list_t* models) {
+    (void)models;
+}
+
+char* esp_srmodel_filter(srmodel_list_t* models, const char* keyword1, const char* keyword2) {
+    (void)models;
+    (void)keyword1;
+    (void)keyword2;
+    return nullptr;
+}
+
+const esp_wn_iface_t* esp_wn_handle_from_name(const char* model_name) {
+    (void)model_name;
+    return nullptr;
+}
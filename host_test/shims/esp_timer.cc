@@ -0,0 +1,153 @@
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::microseconds period{0};
+    bool armed = false;
+};
+
+// The esp_timer task: one thread runs the callbacks of every timer in deadline order, so a
+// callback that blocks delays all the others like on the device. Never destroyed, the thread
+// may still wait for a deadline while the process exits.
+struct TimerTask {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<esp_timer*> timers;
+    esp_timer* running = nullptr;
+    std::thread::id thread_id;
+};
+
+static const auto start_time = std::chrono::steady_clock::now();
+static std::atomic<int64_t> time_offset_us = 0;
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count() +
+        time_offset_us;
+}
+
+void host_advance_time(int64_t us) {
+    time_offset_us += us;
+}
+
+static void TimerTaskLoop(TimerTask* task) {
+    std::unique_lock<std::mutex> lock(task->mutex);
+    while (true) {
+        esp_timer* timer = nullptr;
+        for (auto candidate : task->timers) {
+            if (candidate->armed && (timer == nullptr || candidate->deadline < timer->deadline)) {
+                timer = candidate;
+            }
+        }
+        if (timer == nullptr) {
+            task->cv.wait(lock);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() < timer->deadline) {
+            // Arm, stop and delete wake the task to pick the next timer again, the timer may be
+            // freed while the task waits
+            auto deadline = timer->deadline;
+            task->cv.wait_until(lock, deadline);
+            continue;
+        }
+        if (timer->period.count() > 0) {
+            timer->deadline += timer->period;
+            // Like skip_unhandled_events, a late periodic timer fires once and does not catch up
+            auto now = std::chrono::steady_clock::now();
+            if (timer->args.skip_unhandled_events && timer->deadline < now) {
+                timer->deadline = now + timer->period;
+            }
+        } else {
+            timer->armed = false;
+        }
+        // The callback may delete its own timer, so the timer is not touched after it returns
+        auto callback = timer->args.callback;
+        void* arg = timer->args.arg;
+        task->running = timer;
+        lock.unlock();
+        callback(arg);
+        lock.lock();
+        task->running = nullptr;
+        task->cv.notify_all();
+    }
+}
+
+static TimerTask& GetTimerTask() {
+    static TimerTask* task = []() {
+        auto task = new TimerTask();
+        std::thread thread(TimerTaskLoop, task);
+        task->thread_id = thread.get_id();
+        thread.detach();
+        return task;
+    }();
+    return *task;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    auto& task = GetTimerTask();
+    auto timer = new esp_timer();
+    timer->args = *create_args;
+    std::lock_guard<std::mutex> lock(task.mutex);
+    task.timers.push_back(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t Arm(esp_timer_handle_t timer, uint64_t timeout_us, bool periodic) {
+    auto& task = GetTimerTask();
+    {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        if (timer->armed) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        timer->armed = true;
+        timer->period = std::chrono::microseconds(periodic ? timeout_us : 0);
+        timer->deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us);
+    }
+    task.cv.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return Arm(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return Arm(timer, period, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    auto& task = GetTimerTask();
+    {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        if (!timer->armed) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        timer->armed = false;
+    }
+    task.cv.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    auto& task = GetTimerTask();
+    {
+        std::unique_lock<std::mutex> lock(task.mutex);
+        task.timers.erase(std::find(task.timers.begin(), task.timers.end(), timer));
+        // A callback in progress on the timer task finishes before its timer is freed
+        if (std::this_thread::get_id() != task.thread_id) {
+            task.cv.wait(lock, [&task, timer]() { return task.running != timer; });
+        }
+    }
+    task.cv.notify_all();
+    delete timer;
+    return ESP_OK;
+}
@@ -0,0 +1,267 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HostTask {
+    std::string name;
+    TaskFunction_t function;
+    void* arg;
+    uint32_t stack_depth;
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notification = 0;
+    bool pending = false;
+};
+
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t length;
+    size_t item_size;
+    std::vector<uint8_t> items;
+    size_t head = 0;
+    size_t count = 0;
+};
+
+struct HostEventGroup {
+    std::mutex mutex;
+    std::condition_variable cv;
+    EventBits_t bits = 0;
+};
+
+static thread_local HostTask* current_task = nullptr;
+
+// Wait on a condition variable for the given number of ticks (1 tick = 1 ms)
+template <typename Predicate>
+static bool WaitTicks(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Predicate predicate) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, predicate);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), predicate);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+    UBaseType_t priority, TaskHandle_t* created_task) {
+    (void)priority;
+    // The handle is freed when the task function returns, like after vTaskDelete(NULL)
+    auto task = new HostTask();
+    task->name = name;
+    task->function = function;
+    task->arg = arg;
+    task->stack_depth = stack_depth;
+    if (created_task != nullptr) {
+        *created_task = task;
+    }
+    std::thread([task]() {
+        current_task = task;
+        task->function(task->arg);
+        current_task = nullptr;
+        delete task;
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+    UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id) {
+    (void)core_id;
+    return xTaskCreate(function, name, stack_depth, arg, priority, created_task);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return current_task;
+}
+
+TickType_t xTaskGetTickCount() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = current_task;
+    }
+    return task != nullptr ? task->stack_depth : 0;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        switch (action) {
+        case eSetBits: task->notification |= value; break;
+        case eIncrement: task->notification++; break;
+        case eSetValueWithOverwrite: task->notification = value; break;
+        case eNoAction: break;
+        }
+        task->pending = true;
+    }
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    HostTask* task = current_task;
+    std::unique_lock<std::mutex> lock(task->mutex);
+    WaitTicks(task->cv, lock, ticks_to_wait, [task]() { return task->notification != 0; });
+    uint32_t value = task->notification;
+    if (value != 0) {
+        task->notification = clear_on_exit ? 0 : value - 1;
+    }
+    task->pending = false;
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit,
+    uint32_t* notification_value, TickType_t ticks_to_wait) {
+    HostTask* task = current_task;
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if (!task->pending) {
+        task->notification &= ~bits_to_clear_on_entry;
+    }
+    bool notified = WaitTicks(task->cv, lock, ticks_to_wait, [task]() { return task->pending; });
+    if (notification_value != nullptr) {
+        *notification_value = task->notification;
+    }
+    if (notified) {
+        task->notification &= ~bits_to_clear_on_exit;
+        task->pending = false;
+    }
+    return notified ? pdTRUE : pdFALSE;
+}
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new HostEventGroup();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t value;
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->bits |= bits;
+        value = group->bits;
+    }
+    group->cv.notify_all();
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+    return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+    BaseType_t wait_for_all, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(group->mutex);
+    auto satisfied = [group, bits, wait_for_all]() {
+        return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool ok = WaitTicks(group->cv, lock, ticks_to_wait, satisfied);
+    EventBits_t value = group->bits;
+    if (ok && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    auto queue = new HostQueue();
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->items.resize(length * item_size);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (!WaitTicks(queue->cv, lock, ticks_to_wait, [queue]() { return queue->count < queue->length; })) {
+            return pdFALSE;
+        }
+        size_t tail = (queue->head + queue->count) % queue->length;
+        if (queue->item_size > 0) {
+            memcpy(queue->items.data() + tail * queue->item_size, item, queue->item_size);
+        }
+        queue->count++;
+    }
+    queue->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait) {
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (!WaitTicks(queue->cv, lock, ticks_to_wait, [queue]() { return queue->count > 0; })) {
+            return pdFALSE;
+        }
+        if (queue->item_size > 0) {
+            memcpy(item, queue->items.data() + queue->head * queue->item_size, queue->item_size);
+        }
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+    }
+    queue->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->head = 0;
+        queue->count = 0;
+    }
+    queue->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+// A mutex is a semaphore that starts given
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t semaphore = xSemaphoreCreateBinary();
+    xSemaphoreGive(semaphore);
+    return semaphore;
+}
@@ -0,0 +1,16 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/queue.h"
+
+// Semaphores are queues of empty items, as in FreeRTOS
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+#define xSemaphoreGive(semaphore) xQueueSend(semaphore, nullptr, 0)
+#define xSemaphoreTake(semaphore, ticks_to_wait) xQueueReceive(semaphore, nullptr, ticks_to_wait)
+
+#endif // HOST_FREERTOS_SEMPHR_H
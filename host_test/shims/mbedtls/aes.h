@@ -0,0 +1,27 @@
+#ifndef HOST_MBEDTLS_AES_H
+#define HOST_MBEDTLS_AES_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * The part of mbedtls/aes.h the firmware uses, for linking against the system libmbedcrypto when
+ * its headers are not installed. The context has the layout of mbedtls 2.28; 3.x replaced the
+ * round key pointer by an offset of the same size.
+ */
+
+typedef struct mbedtls_aes_context {
+    int nr;
+    uint32_t* rk;
+    uint32_t buf[68];
+} mbedtls_aes_context;
+
+extern "C" {
+void mbedtls_aes_init(mbedtls_aes_context* ctx);
+void mbedtls_aes_free(mbedtls_aes_context* ctx);
+int mbedtls_aes_setkey_enc(mbedtls_aes_context* ctx, const unsigned char* key, unsigned int keybits);
+int mbedtls_aes_crypt_ctr(mbedtls_aes_context* ctx, size_t length, size_t* nc_off, unsigned char nonce_counter[16],
+    unsigned char stream_block[16], const unsigned char* input, unsigned char* output);
+}
+
+#endif // HOST_MBEDTLS_AES_H
@@ -0,0 +1,19 @@
+#ifndef HOST_MODEL_PATH_H
+#define HOST_MODEL_PATH_H
+
+// esp-sr model list, the host build has no models so wake word detection stays off
+typedef struct {
+    char** model_name;
+    char** model_info;
+    int num;
+    void* partition;
+} srmodel_list_t;
+
+#define ESP_WN_PREFIX "wn"
+#define ESP_MN_PREFIX "mn"
+
+srmodel_list_t* esp_srmodel_init(const char* partition_label);
+void esp_srmodel_deinit(srmodel_list_t* models);
+char* esp_srmodel_filter(srmodel_list_t* models, const char* keyword1, const char* keyword2);
+
+#endif // HOST_MODEL_PATH_H
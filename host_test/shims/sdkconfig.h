@@ -0,0 +1,11 @@
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+// The subset of the firmware configuration used by the host build, with the Kconfig defaults
+#define CONFIG_USE_AUDIO_PROFILER 1
+#define CONFIG_USE_AUDIO_JITTER_BUFFER 1
+#define CONFIG_USE_OPUS_ADAPTIVE_BITRATE 1
+#define CONFIG_OPUS_UPLINK_FRAME_DURATION 60
+#define CONFIG_OPUS_UPLINK_BITRATE 0
+
+#endif // HOST_SDKCONFIG_H
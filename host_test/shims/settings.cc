@@ -0,0 +1,78 @@
+#include "settings.h"
+
+#include <map>
+#include <mutex>
+
+static std::mutex settings_mutex;
+static std::map<std::string, std::string> settings_values;
+
+static std::string Key(const std::string& ns, const std::string& key) {
+    return ns + "/" + key;
+}
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    std::lock_guard<std::mutex> lock(settings_mutex);
+    auto it = settings_values.find(Key(ns_, key));
+    return it == settings_values.end() ? default_value : it->second;
+}
+
+void Settings::SetString(const std::string& key, const std::string& value) {
+    if (!read_write_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(settings_mutex);
+    settings_values[Key(ns_, key)] = value;
+}
+
+int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
+    std::string value = GetString(key);
+    return value.empty() ? default_value : (int32_t)std::stol(value);
+}
+
+void Settings::SetInt(const std::string& key, int32_t value) {
+    SetString(key, std::to_string(value));
+}
+
+bool Settings::GetBool(const std::string& key, bool default_value) {
+    std::string value = GetString(key);
+    return value.empty() ? default_value : value == "1";
+}
+
+void Settings::SetBool(const std::string& key, bool value) {
+    SetString(key, value ? "1" : "0");
+}
+
+std::vector<uint8_t> Settings::GetBlob(const std::string& key) {
+    std::string value = GetString(key);
+    return std::vector<uint8_t>(value.begin(), value.end());
+}
+
+bool Settings::SetBlob(const std::string& key, const void* data, size_t size) {
+    if (!read_write_) {
+        return false;
+    }
+    SetString(key, std::string((const char*)data, size));
+    return true;
+}
+
+void Settings::EraseKey(const std::string& key) {
+    if (!read_write_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(settings_mutex);
+    settings_values.erase(Key(ns_, key));
+}
+
+void Settings::EraseAll() {
+    if (!read_write_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(settings_mutex);
+    std::string prefix = ns_ + "/";
+    for (auto it = settings_values.begin(); it != settings_values.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? settings_values.erase(it) : std::next(it);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_SETTINGS_H
+#define HOST_SETTINGS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// NVS settings kept in memory for the lifetime of the process
+class Settings {
+public:
+    Settings(const std::string& ns, bool read_write = false);
+    ~Settings() = default;
+
+    std::string GetString(const std::string& key, const std::string& default_value = "");
+    void SetString(const std::string& key, const std::string& value);
+    int32_t GetInt(const std::string& key, int32_t default_value = 0);
+    void SetInt(const std::string& key, int32_t value);
+    bool GetBool(const std::string& key, bool default_value = false);
+    void SetBool(const std::string& key, bool value);
+    std::vector<uint8_t> GetBlob(const std::string& key);
+    bool SetBlob(const std::string& key, const void* data, size_t size);
+    void EraseKey(const std::string& key);
+    void EraseAll();
+
+private:
+    std::string ns_;
+    bool read_write_;
+};
+
+#endif // HOST_SETTINGS_H
@@ -0,0 +1,54 @@
+#ifndef HOST_ALLOC_COUNTER_H
+#define HOST_ALLOC_COUNTER_H
+
+/*
+ * Counts the calls to operator new of the whole process and of each thread, for tests that
+ * check a code path does not allocate. It replaces the global operator new/delete, so include
+ * it from exactly one file of a test executable.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<size_t>& AllocationCount() {
+    static std::atomic<size_t> count{0};
+    return count;
+}
+
+// The calls made by the calling thread
+inline size_t& ThreadAllocationCount() {
+    static thread_local size_t count = 0;
+    return count;
+}
+
+void* operator new(size_t size) {
+    AllocationCount().fetch_add(1, std::memory_order_relaxed);
+    ThreadAllocationCount()++;
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+#endif // HOST_ALLOC_COUNTER_H
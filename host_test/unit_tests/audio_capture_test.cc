@@ -0,0 +1,145 @@
+/*
+ * The capture path of AudioService with a synthetic codec: AudioInputTask reads from the codec,
+ * resamples to 16 kHz when the codec runs at another rate, feeds the audio processor, which drops
+ * the right channel of a stereo codec, and queues the joined frames for the encoder. Once the
+ * buffers have grown to the frame size none of this may allocate, and the codec must be read
+ * into the same buffer every time. The allocations are counted on the input task only, the
+ * encoder and the send queue are covered by audio_pool_test.
+ */
+#include "alloc_counter.h"
+#include "audio_service.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+// AudioService calls Board::GetInstance() only when the codec changes, never in this test
+void* create_board() {
+    return nullptr;
+}
+
+static constexpr int kWarmUpFrames = 50;
+static constexpr int kMaxBuffers = 8;
+
+// Reads a sine at 10 times real time and counts what the input task allocated between two reads
+class SyntheticCodec : public AudioCodec {
+public:
+    SyntheticCodec(int input_sample_rate, int input_channels) {
+        duplex_ = true;
+        input_sample_rate_ = input_sample_rate;
+        output_sample_rate_ = 24000;
+        input_channels_ = input_channels;
+    }
+
+    uint32_t frames() const { return frames_; }
+    size_t allocations() const { return allocations_; }
+    int buffers() const { return buffers_; }
+
+private:
+    std::atomic<uint32_t> frames_ = 0;
+    std::atomic<size_t> allocations_ = 0;
+    size_t last_thread_allocations_ = 0;
+    // The distinct buffers read into after the warm-up, in a fixed array because a set allocates
+    const int16_t* buffer_addresses_[kMaxBuffers] = {};
+    std::atomic<int> buffers_ = 0;
+    uint64_t position_ = 0;
+
+    virtual int Read(int16_t* dest, int samples) override {
+        // Everything since the previous read happened on the input task for one captured frame
+        size_t thread_allocations = ThreadAllocationCount();
+        if (frames_ > kWarmUpFrames) {
+            allocations_ += thread_allocations - last_thread_allocations_;
+            RecordBuffer(dest);
+        }
+        for (int i = 0; i < samples; i += input_channels_) {
+            int16_t sample = (int16_t)(8000 * sin(2 * M_PI * 440 * position_++ / input_sample_rate_));
+            for (int channel = 0; channel < input_channels_; channel++) {
+                dest[i + channel] = sample;
+            }
+        }
+        frames_++;
+        std::this_thread::sleep_for(std::chrono::microseconds(samples * 100000LL / input_channels_ / input_sample_rate_));
+        last_thread_allocations_ = ThreadAllocationCount();
+        return samples;
+    }
+
+    virtual int Write(const int16_t* data, int samples) override {
+        return samples;
+    }
+
+    void RecordBuffer(const int16_t* dest) {
+        int count = buffers_;
+        for (int i = 0; i < count; i++) {
+            if (buffer_addresses_[i] == dest) {
+                return;
+            }
+        }
+        if (count < kMaxBuffers) {
+            buffer_addresses_[count] = dest;
+        }
+        buffers_ = count + 1;
+    }
+};
+
+static int input_sample_rate = 16000;
+static int input_channels = 1;
+static int frames = 500;
+// The tasks block forever like on the device, the service is never destroyed
+static AudioService audio_service;
+
+static void TestCaptureAllocations() {
+    // Outlives the test, the input task may still be reading when it returns
+    static SyntheticCodec codec(input_sample_rate, input_channels);
+    audio_service.Initialize(&codec);
+    audio_service.Start();
+    audio_service.EnableVoiceProcessing(true);
+
+    // The uplink drains the send queue like AudioSender, the packets go back to the pool
+    std::atomic<uint32_t> packets = 0;
+    std::atomic<bool> stopping = false;
+    std::thread sender([&]() {
+        while (!stopping) {
+            while (audio_service.PopPacketFromSendQueue() != nullptr) {
+                packets++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+    while (codec.frames() < (uint32_t)(kWarmUpFrames + frames)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stopping = true;
+    sender.join();
+
+    uint32_t measured = codec.frames() - kWarmUpFrames - 1;
+    CHECK(packets > 0);
+    CHECK_EQ(codec.allocations(), 0);
+    CHECK_EQ(codec.buffers(), 1);
+    printf("%d Hz, %d channel(s): %u frames, %.2f allocations per frame on the input task, %d capture buffer(s), %u packets\n",
+        input_sample_rate, input_channels, measured, (double)codec.allocations() / measured, codec.buffers(),
+        packets.load());
+    audio_service.EnableVoiceProcessing(false);
+    audio_service.Stop();
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--input-rate") == 0) {
+            input_sample_rate = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--channels") == 0) {
+            input_channels = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        }
+    }
+    if (input_sample_rate <= 0 || input_channels < 1 || input_channels > 2 || frames <= 0) {
+        fprintf(stderr, "Usage: %s [--input-rate HZ] [--channels 1|2] [--frames N]\n", argv[0]);
+        return 1;
+    }
+    RUN_TEST(TestCaptureAllocations);
+    fflush(stdout);
+    std::quick_exit(TEST_RESULT());
+}
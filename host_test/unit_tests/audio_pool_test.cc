@@ -0,0 +1,227 @@
+/*
+ * AudioStreamPacket and AudioTask pools on a simulated conversation: 100k frames go through the
+ * same per-frame steps as OpusCodecTask (encode and decode), the send queue, the WebSocket
+ * receive path and the jitter buffer, and none of them may allocate once the pools are warm,
+ * also not while a stalled uplink keeps the send queue full.
+ */
+#include "alloc_counter.h"
+#include "audio_service.h"
+#include "jitter_buffer.h"
+#include "spsc_ring.h"
+#include "test.h"
+
+#include <random>
+#include <vector>
+
+// AudioService calls Board::GetInstance() only when the codec changes, never in this test
+void* create_board() {
+    return nullptr;
+}
+
+static constexpr int kFrames = 100000;
+static constexpr int kFrameMs = OPUS_FRAME_DURATION_MS;
+static constexpr int kInputFrameSamples = 16000 / 1000 * kFrameMs;
+static constexpr int kOutputFrameSamples = 24000 / 1000 * kFrameMs;
+// The encoder output size esp_opus_enc_get_frame_size reports, three maximum-size Opus packets
+static constexpr size_t kEncoderOutbufSize = 1276 * 3;
+static constexpr int kNetworkDelayFrames = 3;
+static constexpr int kLossPercent = 2;
+
+// Fill every pooled object to its largest size once, like the first seconds of a conversation do
+static void WarmUpPools() {
+    std::vector<std::unique_ptr<AudioStreamPacket>> packets;
+    for (int i = 0; i < AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE; i++) {
+        packets.push_back(AudioStreamPacket::Acquire(kAudioStreamPacketPoolDownlink));
+        packets.back()->payload.resize(AUDIO_STREAM_PACKET_HEADROOM + kEncoderOutbufSize);
+    }
+    for (int i = 0; i < AUDIO_STREAM_UPLINK_PACKET_POOL_SIZE; i++) {
+        packets.push_back(AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink));
+        packets.back()->payload.resize(AUDIO_STREAM_PACKET_HEADROOM + kEncoderOutbufSize);
+    }
+    std::vector<std::unique_ptr<AudioTask>> tasks;
+    for (int i = 0; i < AUDIO_TASK_POOL_SIZE; i++) {
+        tasks.push_back(AudioTask::Acquire());
+        tasks.back()->pcm.resize(kOutputFrameSamples);
+    }
+}
+
+class Conversation {
+public:
+    // Runs `frames` frames and returns the operator new calls made meanwhile
+    size_t Run(int frames) {
+        size_t allocations_before = AllocationCount();
+        for (int i = 0; i < frames; i++) {
+            RunFrame();
+        }
+        return AllocationCount() - allocations_before;
+    }
+
+    // A stalled uplink keeps its packets in the send queue, like AudioSender behind a slow socket
+    void set_uplink_stalled(bool stalled) { uplink_stalled_ = stalled; }
+    size_t send_queue_size() { return send_queue_.Size(); }
+    uint32_t sent() const { return sent_; }
+    uint32_t dropped() const { return dropped_; }
+    uint32_t played() const { return played_; }
+    uint32_t concealed() const { return concealed_; }
+
+private:
+    // A TTS frame on its way from the server
+    struct ServerFrame {
+        uint32_t sequence;
+        size_t size;
+    };
+
+    std::mt19937 random_{3};
+    int64_t now_us_ = 0;
+    bool uplink_stalled_ = false;
+    uint32_t sequence_ = 0;
+    uint32_t sent_ = 0;
+    uint32_t dropped_ = 0;
+    uint32_t played_ = 0;
+    uint32_t concealed_ = 0;
+    uint8_t server_payload_[400] = {};
+    SpscRing<std::unique_ptr<AudioTask>, MAX_ENCODE_TASKS_IN_QUEUE> encode_queue_;
+    SpscRing<std::unique_ptr<AudioStreamPacket>, MAX_SEND_PACKETS_IN_QUEUE> send_queue_;
+    SpscRing<ServerFrame, kNetworkDelayFrames + 1> network_;
+    JitterBuffer jitter_buffer_;
+    SpscRing<std::unique_ptr<AudioTask>, MAX_PLAYBACK_TASKS_IN_QUEUE> playback_queue_;
+
+    void RunFrame() {
+        // AudioInputTask
+        auto task = AudioTask::Acquire();
+        task->type = kAudioTaskTypeEncodeToSendQueue;
+        task->pcm.resize(kInputFrameSamples);
+        task->timestamp = (uint32_t)(now_us_ / 1000);
+        CHECK(encode_queue_.Push(std::move(task)));
+
+        // OpusCodecTask, encode. A full send queue drops the packet, which goes back to the pool.
+        CHECK(encode_queue_.Pop(task));
+        auto packet = AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink);
+        packet->sample_rate = 16000;
+        packet->frame_duration = kFrameMs;
+        packet->timestamp = task->timestamp;
+        packet->headroom = AUDIO_STREAM_PACKET_HEADROOM;
+        packet->payload.resize(packet->headroom + kEncoderOutbufSize);
+        packet->payload.resize(packet->headroom + 20 + random_() % 300);
+        task.reset();
+        if (!send_queue_.Push(std::move(packet))) {
+            dropped_++;
+            packet.reset();
+        }
+
+        // AudioSender
+        while (!uplink_stalled_ && send_queue_.Pop(packet)) {
+            sent_++;
+            packet.reset();
+        }
+
+        // The server sends one TTS frame per frame time, it arrives a few frames later or is lost
+        if ((int)(random_() % 100) >= kLossPercent) {
+            CHECK(network_.Push({ ++sequence_, 20 + random_() % 300 }));
+        } else {
+            ++sequence_;
+        }
+        ServerFrame frame;
+        if (network_.Size() > kNetworkDelayFrames && network_.Pop(frame)) {
+            // WebsocketProtocol copies the received frame into a pooled packet
+            auto received = AudioStreamPacket::Acquire();
+            received->sample_rate = 24000;
+            received->frame_duration = kFrameMs;
+            received->sequence = frame.sequence;
+            received->payload.assign(server_payload_, server_payload_ + frame.size);
+            jitter_buffer_.Put(std::move(received), now_us_);
+        }
+
+        // OpusCodecTask, decode
+        while (playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
+            auto result = jitter_buffer_.Pop(packet, now_us_, playback_queue_.Empty());
+            if (result == kJitterBufferEmpty) {
+                break;
+            }
+            concealed_ += result != kJitterBufferFrame;
+            task = AudioTask::Acquire();
+            task->type = kAudioTaskTypeDecodeToPlaybackQueue;
+            task->pcm.resize(kOutputFrameSamples);
+            packet.reset();
+            CHECK(playback_queue_.Push(std::move(task)));
+        }
+
+        // AudioOutputTask plays one frame per frame time
+        if (playback_queue_.Pop(task)) {
+            played_++;
+        }
+        now_us_ += kFrameMs * 1000;
+    }
+};
+
+static void TestSteadyStateAllocations() {
+    WarmUpPools();
+    Conversation conversation;
+    conversation.Run(1000);
+    uint32_t played_before = conversation.played();
+
+    size_t allocations = conversation.Run(kFrames);
+    CHECK_EQ(allocations, 0);
+
+    // The frames really went all the way through, lost ones concealed
+    CHECK(conversation.played() - played_before >= kFrames - 10);
+    CHECK(conversation.concealed() > 0);
+    printf("%d frames: %zu allocations, %u played, %u concealed\n", kFrames, allocations,
+        conversation.played() - played_before, conversation.concealed());
+}
+
+// While the uplink is stalled the send queue fills up and stays full, and the downlink goes on
+// playing from its own pool without touching the heap
+static void TestSendQueueFull() {
+    WarmUpPools();
+    Conversation conversation;
+    conversation.Run(1000);
+    uint32_t played_before = conversation.played();
+
+    conversation.set_uplink_stalled(true);
+    size_t allocations = conversation.Run(10000);
+    CHECK_EQ(allocations, 0);
+    CHECK_EQ(conversation.send_queue_size(), MAX_SEND_PACKETS_IN_QUEUE);
+    CHECK_EQ(conversation.dropped(), 10000 - MAX_SEND_PACKETS_IN_QUEUE);
+    CHECK(conversation.played() - played_before >= 10000 - 10);
+
+    // The queued packets are sent once the uplink recovers, the frame encoded before the send
+    // task runs again still finds the queue full
+    uint32_t sent_before = conversation.sent();
+    conversation.set_uplink_stalled(false);
+    CHECK_EQ(conversation.Run(1000), 0);
+    CHECK_EQ(conversation.sent() - sent_before, MAX_SEND_PACKETS_IN_QUEUE + 1000 - 1);
+    printf("stalled uplink: %zu allocations, %u packets dropped\n", allocations, conversation.dropped());
+}
+
+// More packets than the pool holds come from the heap and are freed, not put into the slab
+static void TestPoolExhaustion() {
+    std::vector<std::unique_ptr<AudioStreamPacket>> packets;
+    packets.reserve(AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE + 3);
+    size_t allocations_before = AllocationCount();
+    for (int i = 0; i < AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE; i++) {
+        packets.push_back(AudioStreamPacket::Acquire());
+    }
+    CHECK_EQ(AllocationCount() - allocations_before, 0);
+    for (int i = 0; i < 3; i++) {
+        packets.push_back(AudioStreamPacket::Acquire());
+        packets.back()->payload.resize(AUDIO_STREAM_PACKET_HEADROOM + kEncoderOutbufSize);
+    }
+    // One packet and one payload for each of the extra packets
+    CHECK_EQ(AllocationCount() - allocations_before, 3 * 2);
+    packets.clear();
+
+    // A recycled packet is reset but keeps the payload capacity from the warm-up
+    auto packet = AudioStreamPacket::Acquire();
+    CHECK_EQ(packet->sequence, 0);
+    CHECK_EQ(packet->headroom, 0);
+    CHECK(packet->payload.empty());
+    CHECK(packet->payload.capacity() >= AUDIO_STREAM_PACKET_HEADROOM + kEncoderOutbufSize);
+}
+
+int main() {
+    RUN_TEST(TestSteadyStateAllocations);
+    RUN_TEST(TestSendQueueFull);
+    RUN_TEST(TestPoolExhaustion);
+    return TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/*
+ * Contention benchmark for the AudioService queues.
+ *
+ * A source paced like the codec pushes frames through three stages (encode, send, playback),
+ * each stage running in its own thread, with the queues built two ways:
+ *   - shared: std::deque queues behind one mutex and one condition variable that calls
+ *     notify_all() on every push and pop (AudioService before the SPSC rings);
+ *   - spsc:   one SpscRing per queue, the producer wakes only the consumer of that queue.
+ * It prints the consumer wakeups per frame and the source-to-sink latency percentiles.
+ */
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kStages = 3;
+static constexpr size_t kQueueCapacity = 40;
+
+struct BenchResult {
+    double wakeups_per_frame;
+    int64_t p50_us;
+    int64_t p99_us;
+    int64_t max_us;
+};
+
+static BenchResult Summarize(std::vector<int64_t>& latencies, uint64_t wakeups) {
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double q) {
+        return latencies[std::min(latencies.size() - 1, (size_t)(q * latencies.size()))];
+    };
+    return { (double)wakeups / latencies.size(), at(0.5), at(0.99), latencies.back() };
+}
+
+static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static BenchResult RunShared(int frames, int interval_us) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<int64_t> queues[kStages];
+    std::vector<int64_t> latencies;
+    latencies.reserve(frames);
+    std::atomic<uint64_t> wakeups = 0;
+
+    std::vector<std::thread> stages;
+    for (int stage = 0; stage < kStages; stage++) {
+        stages.emplace_back([&, stage]() {
+            for (int n = 0; n < frames; n++) {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (queues[stage].empty()) {
+                    cv.wait(lock);
+                    wakeups++;
+                }
+                int64_t frame = queues[stage].front();
+                queues[stage].pop_front();
+                cv.notify_all();
+                if (stage + 1 < kStages) {
+                    while (queues[stage + 1].size() >= kQueueCapacity) {
+                        cv.wait(lock);
+                        wakeups++;
+                    }
+                    queues[stage + 1].push_back(frame);
+                    cv.notify_all();
+                } else {
+                    latencies.push_back(Now() - frame);
+                }
+            }
+        });
+    }
+
+    auto next = Clock::now();
+    for (int n = 0; n < frames; n++) {
+        std::this_thread::sleep_until(next);
+        next += std::chrono::microseconds(interval_us);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (queues[0].size() >= kQueueCapacity) {
+            cv.wait(lock);
+        }
+        queues[0].push_back(Now());
+        cv.notify_all();
+    }
+    for (auto& thread : stages) {
+        thread.join();
+    }
+    return Summarize(latencies, wakeups);
+}
+
+static BenchResult RunSpsc(int frames, int interval_us) {
+    SpscRing<int64_t, kQueueCapacity> queues[kStages];
+    // Stand-ins for the FreeRTOS task notifications: one per consumer, and one per producer for a full queue
+    std::binary_semaphore data_ready[kStages] = { std::binary_semaphore(0), std::binary_semaphore(0), std::binary_semaphore(0) };
+    std::binary_semaphore space_ready[kStages] = { std::binary_semaphore(0), std::binary_semaphore(0), std::binary_semaphore(0) };
+    std::vector<int64_t> latencies;
+    latencies.reserve(frames);
+    std::atomic<uint64_t> wakeups = 0;
+
+    std::vector<std::thread> stages;
+    for (int stage = 0; stage < kStages; stage++) {
+        stages.emplace_back([&, stage]() {
+            for (int n = 0; n < frames; n++) {
+                int64_t frame;
+                while (!queues[stage].Pop(frame)) {
+                    data_ready[stage].acquire();
+                    wakeups++;
+                }
+                space_ready[stage].release();
+                if (stage + 1 < kStages) {
+                    while (!queues[stage + 1].Push(std::move(frame))) {
+                        space_ready[stage + 1].acquire();
+                        wakeups++;
+                    }
+                    data_ready[stage + 1].release();
+                } else {
+                    latencies.push_back(Now() - frame);
+                }
+            }
+        });
+    }
+
+    auto next = Clock::now();
+    for (int n = 0; n < frames; n++) {
+        std::this_thread::sleep_until(next);
+        next += std::chrono::microseconds(interval_us);
+        int64_t frame = Now();
+        while (!queues[0].Push(std::move(frame))) {
+            space_ready[0].acquire();
+        }
+        data_ready[0].release();
+    }
+    for (auto& thread : stages) {
+        thread.join();
+    }
+    return Summarize(latencies, wakeups);
+}
+
+int main(int argc, char** argv) {
+    int frames = 2000;
+    int interval_us = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--interval-us") == 0) {
+            interval_us = atoi(argv[i + 1]);
+        }
+    }
+    if (frames <= 0 || interval_us < 0) {
+        fprintf(stderr, "Usage: %s [--frames N] [--interval-us US]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d frames, one every %d us, %d stages\n", frames, interval_us, kStages);
+    printf("%-8s %16s %10s %10s %10s\n", "queues", "wakeups/frame", "p50 us", "p99 us", "max us");
+    auto shared = RunShared(frames, interval_us);
+    printf("%-8s %16.2f %10lld %10lld %10lld\n", "shared", shared.wakeups_per_frame, (long long)shared.p50_us,
+        (long long)shared.p99_us, (long long)shared.max_us);
+    auto spsc = RunSpsc(frames, interval_us);
+    printf("%-8s %16.2f %10lld %10lld %10lld\n", "spsc", spsc.wakeups_per_frame, (long long)spsc.p50_us,
+        (long long)spsc.p99_us, (long long)spsc.max_us);
+    return 0;
+}
@@ -0,0 +1,200 @@
+#ifndef HTTP_STAND_IN_H
+#define HTTP_STAND_IN_H
+
+/*
+ * A local HTTP/1.1 server on 127.0.0.1 standing in for the sensor data receivers. Every
+ * connection is served by its own thread, which answers each POST with the configured status
+ * after the configured stall. Counts connections (TCP handshakes), requests and bytes, and keeps
+ * the request bodies and the last Authorization header and path for the checks.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class HttpStandIn {
+public:
+    HttpStandIn() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd_, (sockaddr*)&address, sizeof(address));
+        listen(listen_fd_, 16);
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd_, (sockaddr*)&address, &length);
+        port_ = ntohs(address.sin_port);
+        accept_thread_ = std::thread([this]() { AcceptLoop(); });
+    }
+
+    ~HttpStandIn() {
+        stopping_ = true;
+        accept_thread_.join();
+        close(listen_fd_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& thread : connection_threads_) {
+            thread.join();
+        }
+    }
+
+    std::string url(const char* path = "/api/sensor-data") const {
+        return "http://127.0.0.1:" + std::to_string(port_) + path;
+    }
+
+    // Each response is sent this long after its request arrived
+    void set_stall_ms(int stall_ms) { stall_ms_ = stall_ms; }
+    void set_status(int status) { status_ = status; }
+    // Close the connection after every response, like a server without keep-alive
+    void set_close_after_response(bool close_after_response) { close_after_response_ = close_after_response; }
+
+    uint32_t connections() const { return connections_; }
+    uint32_t requests() const { return requests_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+    uint64_t bytes_sent() const { return bytes_sent_; }
+
+    std::vector<std::string> bodies() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bodies_;
+    }
+
+    std::string last_authorization() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_authorization_;
+    }
+
+    std::string last_path() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_path_;
+    }
+
+private:
+    int listen_fd_;
+    int port_;
+    std::thread accept_thread_;
+    std::atomic<bool> stopping_ = false;
+    std::atomic<int> stall_ms_ = 0;
+    std::atomic<int> status_ = 200;
+    std::atomic<bool> close_after_response_ = false;
+    std::atomic<uint32_t> connections_ = 0;
+    std::atomic<uint32_t> requests_ = 0;
+    std::atomic<uint64_t> bytes_received_ = 0;
+    std::atomic<uint64_t> bytes_sent_ = 0;
+    std::mutex mutex_;
+    std::vector<std::thread> connection_threads_;
+    std::vector<std::string> bodies_;
+    std::string last_authorization_;
+    std::string last_path_;
+
+    // Waits up to 50 ms for the socket to become readable, so the threads notice stopping_
+    bool WaitReadable(int fd) {
+        pollfd poll_fd = { fd, POLLIN, 0 };
+        return poll(&poll_fd, 1, 50) > 0;
+    }
+
+    void AcceptLoop() {
+        while (!stopping_) {
+            if (!WaitReadable(listen_fd_)) {
+                continue;
+            }
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            connections_++;
+            std::lock_guard<std::mutex> lock(mutex_);
+            connection_threads_.emplace_back([this, fd]() { Serve(fd); });
+        }
+    }
+
+    void Serve(int fd) {
+        std::string buffer;
+        char chunk[2048];
+        while (!stopping_) {
+            size_t header_end = buffer.find("\r\n\r\n");
+            if (header_end == std::string::npos) {
+                if (!WaitReadable(fd)) {
+                    continue;
+                }
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    break;
+                }
+                bytes_received_ += received;
+                buffer.append(chunk, received);
+                continue;
+            }
+
+            size_t content_length = 0;
+            bool client_closes = false;
+            std::string authorization;
+            size_t line = buffer.find("\r\n") + 2;
+            while (line < header_end) {
+                size_t line_end = buffer.find("\r\n", line);
+                std::string header = buffer.substr(line, line_end - line);
+                if (strncasecmp(header.c_str(), "Content-Length:", 15) == 0) {
+                    content_length = strtoul(header.c_str() + 15, nullptr, 10);
+                } else if (strncasecmp(header.c_str(), "Connection:", 11) == 0 && header.find("close") != std::string::npos) {
+                    client_closes = true;
+                } else if (strncasecmp(header.c_str(), "Authorization: ", 15) == 0) {
+                    authorization = header.substr(15);
+                }
+                line = line_end + 2;
+            }
+            while (buffer.size() < header_end + 4 + content_length && !stopping_) {
+                if (!WaitReadable(fd)) {
+                    continue;
+                }
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    close(fd);
+                    return;
+                }
+                bytes_received_ += received;
+                buffer.append(chunk, received);
+            }
+            size_t path_start = buffer.find(' ') + 1;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                last_path_ = buffer.substr(path_start, buffer.find(' ', path_start) - path_start);
+                last_authorization_ = authorization;
+                bodies_.push_back(buffer.substr(header_end + 4, content_length));
+            }
+            buffer.erase(0, header_end + 4 + content_length);
+            requests_++;
+
+            auto respond_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(stall_ms_);
+            while (std::chrono::steady_clock::now() < respond_at && !stopping_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            bool closes = client_closes || close_after_response_;
+            int status = status_;
+            std::string response = "HTTP/1.1 " + std::to_string(status) + (status < 300 ? " OK" : " Error") +
+                "\r\nContent-Type: application/json\r\nContent-Length: 11\r\n" +
+                (closes ? "Connection: close\r\n" : "") + "\r\n{\"ok\":true}";
+            // The client may have given up on a stalled response and closed the connection
+            ssize_t sent = send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                bytes_sent_ += sent;
+            }
+            if (sent <= 0 || closes) {
+                break;
+            }
+        }
+        close(fd);
+    }
+};
+
+#endif // HTTP_STAND_IN_H
@@ -0,0 +1,142 @@
+/*
+ * JitterBuffer on a simulated clock: sequence restarts, the end of an utterance and lost frames.
+ */
+#include "jitter_buffer.h"
+#include "test.h"
+
+#include <vector>
+
+static constexpr int kFrameMs = 60;
+static constexpr int64_t kFrameUs = kFrameMs * 1000;
+
+static std::unique_ptr<AudioStreamPacket> MakePacket(uint32_t sequence) {
+    auto packet = AudioStreamPacket::Acquire();
+    packet->sample_rate = 24000;
+    packet->frame_duration = kFrameMs;
+    packet->sequence = sequence;
+    packet->timestamp = sequence;
+    packet->payload.assign(4, (uint8_t)sequence);
+    return packet;
+}
+
+// Pops everything that is due at `now_us` with an empty playback queue, returns the popped results
+static std::vector<JitterBufferResult> PopDue(JitterBuffer& buffer, int64_t now_us, std::vector<uint32_t>* played = nullptr) {
+    std::vector<JitterBufferResult> results;
+    while (true) {
+        std::unique_ptr<AudioStreamPacket> packet;
+        auto result = buffer.Pop(packet, now_us, true);
+        if (result == kJitterBufferEmpty) {
+            return results;
+        }
+        if (result == kJitterBufferFrame && played) {
+            played->push_back(packet->sequence);
+        }
+        results.push_back(result);
+    }
+}
+
+// Packets arrive one frame apart and are played as they become due
+static int64_t Stream(JitterBuffer& buffer, uint32_t first, int count, int64_t now_us, std::vector<uint32_t>& played) {
+    for (int i = 0; i < count; i++) {
+        buffer.Put(MakePacket(first + i), now_us);
+        PopDue(buffer, now_us, &played);
+        now_us += kFrameUs;
+    }
+    return now_us;
+}
+
+static int64_t Drain(JitterBuffer& buffer, int64_t now_us, std::vector<uint32_t>& played) {
+    for (int i = 0; i < 2 * JITTER_BUFFER_MAX_FRAMES + 2 && buffer.Active(); i++) {
+        PopDue(buffer, now_us, &played);
+        now_us += kFrameUs;
+    }
+    return now_us;
+}
+
+static void TestSequenceRestart() {
+    JitterBuffer buffer;
+    std::vector<uint32_t> played;
+    int64_t now_us = Stream(buffer, 5000, 100, 0, played);
+    // The server starts a new session with its sequence numbers back at 1
+    now_us = Stream(buffer, 1, 2 * JITTER_BUFFER_SLOTS + 10, now_us, played);
+    now_us = Drain(buffer, now_us, played);
+
+    CHECK_EQ(played.size(), 100 + 2 * JITTER_BUFFER_SLOTS + 10);
+    for (int i = 0; i < 2 * JITTER_BUFFER_SLOTS + 10; i++) {
+        CHECK_EQ(played[100 + i], i + 1);
+    }
+    auto statistics = buffer.GetStatistics();
+    CHECK_EQ(statistics.duplicated, 0);
+    CHECK_EQ(statistics.late, 0);
+    CHECK_EQ(statistics.lost, 0);
+    CHECK(buffer.Empty());
+    CHECK(!buffer.Active());
+}
+
+static void TestEndOfUtteranceIsNotConcealed() {
+    JitterBuffer buffer;
+    std::vector<uint32_t> played;
+    int64_t now_us = Stream(buffer, 1, 20, 0, played);
+    // Nothing follows the last frame
+    int concealed = 0;
+    for (int i = 0; i < 2 * JITTER_BUFFER_MAX_FRAMES + 2; i++) {
+        for (auto result : PopDue(buffer, now_us, &played)) {
+            concealed += result != kJitterBufferFrame;
+        }
+        now_us += kFrameUs;
+    }
+    CHECK_EQ(played.size(), 20);
+    CHECK_EQ(concealed, 0);
+    auto statistics = buffer.GetStatistics();
+    CHECK_EQ(statistics.underruns, 0);
+    CHECK_EQ(statistics.lost, 0);
+    CHECK(!buffer.Active());
+
+    // The next utterance goes on with the following sequence numbers after a pause
+    Stream(buffer, 21, 10, now_us + 2000000, played);
+    Drain(buffer, now_us + 2000000 + 10 * kFrameUs, played);
+    CHECK_EQ(played.size(), 30);
+    CHECK_EQ(buffer.GetStatistics().underruns, 0);
+}
+
+static void TestLateFrameAtTheEndStillPlays() {
+    JitterBuffer buffer;
+    std::vector<uint32_t> played;
+    int64_t now_us = Stream(buffer, 1, 10, 0, played);
+    // Frame 11 is half a frame late, no later frame is buffered
+    PopDue(buffer, now_us, &played);
+    buffer.Put(MakePacket(11), now_us + kFrameUs / 2);
+    PopDue(buffer, now_us + kFrameUs / 2, &played);
+    CHECK_EQ(played.size(), 11);
+    CHECK_EQ(buffer.GetStatistics().lost, 0);
+    CHECK_EQ(buffer.GetStatistics().underruns, 0);
+}
+
+static void TestLostFrameIsConcealed() {
+    JitterBuffer buffer;
+    std::vector<uint32_t> played;
+    int64_t now_us = Stream(buffer, 1, 10, 0, played);
+    // Frame 11 is lost, 12 and 13 arrive on time
+    buffer.Put(MakePacket(12), now_us + kFrameUs);
+    buffer.Put(MakePacket(13), now_us + 2 * kFrameUs);
+    std::vector<JitterBufferResult> results;
+    for (int i = 0; i < 4; i++) {
+        for (auto result : PopDue(buffer, now_us + i * kFrameUs, &played)) {
+            results.push_back(result);
+        }
+    }
+    CHECK_EQ(played.size(), 12);
+    CHECK_EQ(played.back(), 13);
+    CHECK_EQ(results.size(), 3);
+    CHECK_EQ(results[0], kJitterBufferFec);
+    CHECK_EQ(buffer.GetStatistics().lost, 1);
+    CHECK_EQ(buffer.GetStatistics().underruns, 0);
+}
+
+int main() {
+    RUN_TEST(TestSequenceRestart);
+    RUN_TEST(TestEndOfUtteranceIsNotConcealed);
+    RUN_TEST(TestLateFrameAtTheEndStillPlays);
+    RUN_TEST(TestLostFrameIsConcealed);
+    return TEST_RESULT();
+}
@@ -0,0 +1,267 @@
+/*
+ * ParseIncomingMessage (JsonReader) against the host cJSON tree parser: a corpus of server
+ * messages, invalid documents, and a fuzz run of mutated messages where both must accept the
+ * same inputs and extract the same strings. Ends with the time and heap per message of both.
+ */
+#include "alloc_counter.h"
+#include "incoming_message.h"
+#include "test.h"
+
+#include <cJSON.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Server messages as recorded from a conversation, plus escapes and unusual spacing
+static const char* const kCorpus[] = {
+    R"({"type":"hello","transport":"websocket","session_id":"7f3c9b2a","audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})",
+    R"({"type":"hello","transport":"udp","session_id":"a1","udp":{"server":"120.24.1.2","port":8884,"key":"0123456789abcdef","nonce":"00000000000000000000000000000000"},"audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})",
+    R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"7f3c9b2a"})",
+    R"({"type":"tts","state":"sentence_start","text":"你好，我是小智。今天天气不错！","session_id":"7f3c9b2a"})",
+    R"({"type":"tts","state":"sentence_end","text":"你好 \"quoted\" \\ back\/slash\n\ttab 😀","session_id":"7f3c9b2a"})",
+    R"({"type":"tts","state":"stop","session_id":"7f3c9b2a"})",
+    R"({"type":"stt","text":"现在几点了","session_id":"7f3c9b2a"})",
+    R"({"type":"llm","text":"😀","emotion":"happy","session_id":"7f3c9b2a"})",
+    R"({"type":"mcp","session_id":"7f3c9b2a","payload":{"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":80}}}})",
+    R"({"type":"mcp","payload":{"jsonrpc":"2.0","id":1,"method":"tools/list","params":{"cursor":""}}})",
+    R"({"type":"system","command":"reboot"})",
+    R"({"type":"alert","status":"Warning","message":"Battery low","emotion":"sad"})",
+    R"({"type":"custom","payload":{"action":"blink","times":[1,2,3.5e2,-0.25,true,false,null]}})",
+    R"({"type":"goodbye","session_id":"7f3c9b2a"})",
+    " \r\n\t{ \"type\" : \"tts\" , \"state\" : \"start\" , \"text\" : 12 , \"extra\" : [ { } , [ ] , \"}\" ] } ",
+    R"({"type":"tts","type":"stt","text":null,"text":"second","state":"start"})",
+    R"({"type":"unknown_type","payload":"string payload"})",
+    R"({})",
+};
+
+static const char* const kStringKeys[] = { "type", "state", "text", "emotion", "command", "status", "message", "session_id" };
+
+static const JsonString& Field(const IncomingMessage& message, int index) {
+    const JsonString* fields[] = { &message.type_name, &message.state, &message.text, &message.emotion,
+        &message.command, &message.status, &message.message, &message.session_id };
+    return *fields[index];
+}
+
+// cJSON strings end at the first NUL
+static std::string CString(const JsonString& value) {
+    std::string text = value.ToString();
+    return text.substr(0, text.find('\0'));
+}
+
+// Both parsers accept the input or both reject it, and they extract the same members
+static bool MatchesCJson(const char* data, size_t size, std::string* difference) {
+    IncomingMessage message;
+    bool accepted = ParseIncomingMessage(data, size, &message);
+    cJSON* root = cJSON_ParseWithLength(data, size);
+    bool expected = cJSON_IsObject(root);
+
+    bool match = accepted == expected;
+    if (!match) {
+        *difference = accepted ? "accepted, cJSON rejected" : "rejected, cJSON accepted";
+    }
+    for (int i = 0; match && expected && i < (int)std::size(kStringKeys); i++) {
+        cJSON* item = cJSON_GetObjectItem(root, kStringKeys[i]);
+        const JsonString& field = Field(message, i);
+        if (cJSON_IsString(item) ? !field.present() || CString(field) != item->valuestring : field.present()) {
+            match = false;
+            *difference = std::string("member \"") + kStringKeys[i] + "\" differs";
+        }
+    }
+    if (match && expected && (cJSON_GetObjectItem(root, "payload") != nullptr) == message.payload.empty()) {
+        match = false;
+        *difference = "payload differs";
+    }
+    cJSON_Delete(root);
+    return match;
+}
+
+static void TestCorpus() {
+    for (const char* json : kCorpus) {
+        std::string difference;
+        bool match = MatchesCJson(json, strlen(json), &difference);
+        if (!match) {
+            fprintf(stderr, "%s: %s\n", difference.c_str(), json);
+        }
+        CHECK(match);
+    }
+
+    IncomingMessage message;
+    CHECK(ParseIncomingMessage(kCorpus[3], strlen(kCorpus[3]), &message));
+    CHECK_EQ(message.type, kIncomingMessageTts);
+    CHECK_EQ(message.tts_state, kTtsStateSentenceStart);
+
+    CHECK(ParseIncomingMessage(kCorpus[8], strlen(kCorpus[8]), &message));
+    CHECK_EQ(message.type, kIncomingMessageMcp);
+    CHECK(message.payload_is_object());
+    cJSON* payload = cJSON_ParseWithLength(message.payload.data(), message.payload.size());
+    CHECK(cJSON_IsObject(payload));
+    cJSON_Delete(payload);
+
+    // The first of duplicate members wins, a non-string member counts as missing
+    const char* duplicates = kCorpus[15];
+    CHECK(ParseIncomingMessage(duplicates, strlen(duplicates), &message));
+    CHECK_EQ(message.type, kIncomingMessageTts);
+    CHECK(!message.text.present());
+}
+
+static void TestInvalid() {
+    static const char* const invalid[] = {
+        R"({"a":{]})",
+        R"({"a":[}})",
+        R"({"a":[{]}})",
+        R"({"a":{"b":1]})",
+        "{\"text\":\"line\nbreak\"}",
+        "{\"a\":[\"tab\there\"]}",
+        R"({"a":tru})",
+        R"({"a":nul})",
+        R"({"a":01})",
+        R"({"a":1.})",
+        R"({"a":-})",
+        R"({"a":1e})",
+        R"({"a":[1 2]})",
+        R"({"a":[1,]})",
+        R"({"a":{"b"}})",
+        R"({"a":{"b":1,}})",
+        R"({"a":{1:2}})",
+        R"({"a":"\x"})",
+        R"({"a":"\u12"})",
+        R"({"a":[)",
+        R"({"a":1)",
+        R"({"a" 1})",
+        R"([1,2])",
+        "",
+    };
+    for (const char* json : invalid) {
+        IncomingMessage message;
+        bool parsed = ParseIncomingMessage(json, strlen(json), &message);
+        if (parsed) {
+            fprintf(stderr, "accepted invalid JSON: %s\n", json);
+        }
+        CHECK(!parsed);
+        std::string difference;
+        CHECK(MatchesCJson(json, strlen(json), &difference));
+    }
+
+    // Nesting beyond JSON_READER_MAX_DEPTH is rejected without recursion
+    std::string deep = "{\"a\":" + std::string(100000, '[') + std::string(100000, ']') + "}";
+    IncomingMessage message;
+    CHECK(!ParseIncomingMessage(deep.data(), deep.size(), &message));
+    std::string nested = "{\"a\":" + std::string(500, '[') + std::string(500, ']') + ",\"type\":\"stt\"}";
+    CHECK(ParseIncomingMessage(nested.data(), nested.size(), &message));
+    CHECK_EQ(message.type, kIncomingMessageStt);
+}
+
+static std::mt19937 random_engine(7);
+
+// Corpus messages with bytes replaced, inserted, dropped or duplicated, biased towards the
+// characters that change the structure
+static std::string Mutate(const char* json) {
+    static const char structural[] = "{}[]\",:\\ \n0-.eEtfnu\x01\x1f";
+    std::string text = json;
+    for (int mutations = 1 + random_engine() % 3; mutations > 0 && !text.empty(); mutations--) {
+        size_t position = random_engine() % text.size();
+        char c = random_engine() % 4 == 0 ? (char)random_engine() : structural[random_engine() % (sizeof(structural) - 1)];
+        switch (random_engine() % 4) {
+            case 0: text[position] = c; break;
+            case 1: text.insert(position, 1, c); break;
+            case 2: text.erase(position, 1); break;
+            default: text.insert(position, text.substr(position, random_engine() % 8)); break;
+        }
+    }
+    return text;
+}
+
+static void TestFuzz() {
+    int accepted = 0;
+    int mismatches = 0;
+    for (int round = 0; round < 300000; round++) {
+        std::string json = Mutate(kCorpus[random_engine() % std::size(kCorpus)]);
+        std::string difference;
+        if (!MatchesCJson(json.data(), json.size(), &difference)) {
+            if (mismatches++ < 10) {
+                fprintf(stderr, "%s: %s\n", difference.c_str(), json.c_str());
+            }
+            continue;
+        }
+        IncomingMessage message;
+        accepted += ParseIncomingMessage(json.data(), json.size(), &message);
+    }
+    CHECK_EQ(mismatches, 0);
+    printf("fuzz: %d of 300000 mutated messages still valid\n", accepted);
+}
+
+// Heap used by cJSON through its hooks, each block remembers its size in front of it
+static size_t heap_in_use = 0;
+static size_t heap_peak = 0;
+static size_t heap_allocations = 0;
+
+static void* CountingMalloc(size_t size) {
+    auto block = (size_t*)malloc(sizeof(size_t) * 2 + size);
+    block[0] = size;
+    heap_in_use += size;
+    heap_peak = std::max(heap_peak, heap_in_use);
+    heap_allocations++;
+    return block + 2;
+}
+
+static void CountingFree(void* pointer) {
+    auto block = (size_t*)pointer - 2;
+    heap_in_use -= block[0];
+    free(block);
+}
+
+static void BenchmarkCorpus() {
+    constexpr int kRounds = 20000;
+    const size_t messages = kRounds * std::size(kCorpus);
+
+    size_t allocations_before = AllocationCount();
+    int types = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (const char* json : kCorpus) {
+            IncomingMessage message;
+            if (ParseIncomingMessage(json, strlen(json), &message)) {
+                types += message.type;
+            }
+        }
+    }
+    double reader_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK_EQ(AllocationCount() - allocations_before, 0);
+
+    cJSON_Hooks hooks = { CountingMalloc, CountingFree };
+    cJSON_InitHooks(&hooks);
+    int cjson_types = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (const char* json : kCorpus) {
+            // What OnIncomingJson did before: parse the tree and compare the type and state
+            cJSON* root = cJSON_ParseWithLength(json, strlen(json));
+            cJSON* type = cJSON_GetObjectItem(root, "type");
+            cJSON* state = cJSON_GetObjectItem(root, "state");
+            if (cJSON_IsString(type)) {
+                cjson_types += strcmp(type->valuestring, "tts") == 0 && cJSON_IsString(state) && strcmp(state->valuestring, "stop") == 0;
+            }
+            cJSON_Delete(root);
+        }
+    }
+    double cjson_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    cJSON_InitHooks(nullptr);
+    CHECK(types > 0 && cjson_types > 0);
+    CHECK_EQ(heap_in_use, 0);
+
+    printf("JsonReader: %.0f ns per message, 0 allocations\n", reader_ns / messages);
+    printf("cJSON:      %.0f ns per message, %.1f allocations per message, peak heap %zu bytes\n", cjson_ns / messages,
+        (double)heap_allocations / messages, heap_peak);
+}
+
+int main() {
+    RUN_TEST(TestCorpus);
+    RUN_TEST(TestInvalid);
+    RUN_TEST(TestFuzz);
+    RUN_TEST(BenchmarkCorpus);
+    return TEST_RESULT();
+}
@@ -0,0 +1,213 @@
+/*
+ * MainTaskScheduler with a burst of 1,000 tasks pushed from several threads: every task runs
+ * once, classes run by priority and FIFO within a class, the budgets let lower classes through,
+ * and the statistics add up. Ends with the burst cost against the old std::function deque.
+ */
+#include "../../main/main_task_scheduler.h"
+#include "alloc_counter.h"
+#include "test.h"
+
+#include <esp_timer.h>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static constexpr int kBurstTasks = 1000;
+static constexpr int kProducers = 4;
+
+struct RunRecord {
+    SchedulePriority priority;
+    int producer;
+    int index;
+};
+
+static void BusyWait(int64_t duration_us) {
+    int64_t end = esp_timer_get_time() + duration_us;
+    while (esp_timer_get_time() < end) {
+    }
+}
+
+// Every producer pushes its share of the burst with random classes, then the main task runs it
+static void TestBurst() {
+    MainTaskScheduler scheduler;
+    std::vector<RunRecord> runs;
+    runs.reserve(kBurstTasks);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; producer++) {
+        producers.emplace_back([&scheduler, &runs, producer]() {
+            std::mt19937 random(producer);
+            for (int index = 0; index < kBurstTasks / kProducers; index++) {
+                auto priority = (SchedulePriority)(random() % kSchedulePriorityCount);
+                // Like the Application::Schedule callers, the closure captures a few pointers and values
+                scheduler.Push(priority, [&runs, priority, producer, index]() {
+                    runs.push_back({priority, producer, index});
+                });
+            }
+        });
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+
+    size_t waiting = 0;
+    for (int i = 0; i < kSchedulePriorityCount; i++) {
+        auto statistics = scheduler.GetStatistics((SchedulePriority)i);
+        CHECK_EQ(statistics.max_depth, statistics.depth);
+        waiting += statistics.depth;
+    }
+    CHECK_EQ(waiting, kBurstTasks);
+
+    CHECK(!scheduler.RunPending());
+    CHECK_EQ(runs.size(), kBurstTasks);
+
+    // Classes in priority order, and each producer's tasks of one class in the order it pushed them
+    int last_index[kSchedulePriorityCount][kProducers];
+    for (auto& row : last_index) {
+        row[0] = row[1] = row[2] = row[3] = -1;
+    }
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (i > 0) {
+            CHECK(runs[i - 1].priority <= runs[i].priority);
+        }
+        int& last = last_index[runs[i].priority][runs[i].producer];
+        CHECK(runs[i].index > last);
+        last = runs[i].index;
+    }
+
+    uint32_t run_count = 0;
+    for (int i = 0; i < kSchedulePriorityCount; i++) {
+        auto statistics = scheduler.GetStatistics((SchedulePriority)i);
+        CHECK_EQ(statistics.depth, 0);
+        CHECK(statistics.max_latency_us >= 0);
+        run_count += statistics.run_count;
+        // More than MAIN_TASK_QUEUE_SIZE waiting tasks of a class spill into the overflow list
+        CHECK_EQ(statistics.overflow_count, statistics.max_depth > MAIN_TASK_QUEUE_SIZE ?
+            statistics.max_depth - MAIN_TASK_QUEUE_SIZE : 0);
+    }
+    CHECK_EQ(run_count, kBurstTasks);
+}
+
+// A state change pushed while slow UI updates are queued runs before the next UI update, and a
+// class over its budget leaves the rest for the next RunPending() call
+static void TestPriorityAndBudget() {
+    MainTaskScheduler scheduler;
+    std::vector<int> order;
+    for (int i = 0; i < 10; i++) {
+        scheduler.Push(kSchedulePriorityUi, [&scheduler, &order, i]() {
+            order.push_back(i);
+            BusyWait(8000);
+            if (i == 1) {
+                scheduler.Push(kSchedulePriorityState, [&order]() { order.push_back(-1); });
+            }
+        });
+    }
+
+    CHECK(scheduler.RunPending());
+    // The UI budget (20 ms) is used up by the third 8 ms task
+    std::vector<int> expected = { 0, 1, -1, 2 };
+    CHECK(order == expected);
+    CHECK_EQ(scheduler.GetStatistics(kSchedulePriorityUi).depth, 7);
+
+    while (scheduler.RunPending()) {
+    }
+    CHECK_EQ(order.size(), 11);
+    CHECK_EQ(order.back(), 9);
+}
+
+// Up to MAIN_TASK_QUEUE_SIZE tasks per class with full-size captures never allocate
+static void TestNoAllocation() {
+    MainTaskScheduler scheduler;
+    std::array<char, MAIN_TASK_INLINE_SIZE - sizeof(int*)> payload{};
+    int sum = 0;
+    for (int round = 0; round < 100; round++) {
+        size_t allocations_before = AllocationCount();
+        for (int i = 0; i < kSchedulePriorityCount; i++) {
+            for (int j = 0; j < MAIN_TASK_QUEUE_SIZE; j++) {
+                payload[0] = (char)j;
+                scheduler.Push((SchedulePriority)i, [payload, &sum]() { sum += payload[0]; });
+            }
+        }
+        scheduler.RunPending();
+        CHECK_EQ(AllocationCount() - allocations_before, 0);
+    }
+    CHECK_EQ(sum, 100 * kSchedulePriorityCount * (MAIN_TASK_QUEUE_SIZE - 1) * MAIN_TASK_QUEUE_SIZE / 2);
+}
+
+// The main-task queue before the scheduler: std::function in a mutex-guarded deque, FIFO
+class DequeScheduler {
+public:
+    void Push(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(callback));
+    }
+
+    void RunPending() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto tasks = std::move(tasks_);
+        lock.unlock();
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<std::function<void()>> tasks_;
+};
+
+struct Capture {
+    void* object;
+    int values[8];
+};
+
+static void BenchmarkBurst() {
+    constexpr int kRounds = 200;
+    int sum = 0;
+    Capture capture = { &sum, { 1 } };
+
+    MainTaskScheduler scheduler;
+    size_t allocations_before = AllocationCount();
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        for (int i = 0; i < kBurstTasks; i++) {
+            scheduler.Push((SchedulePriority)(i % kSchedulePriorityCount), [capture]() { *(int*)capture.object += capture.values[0]; });
+        }
+        while (scheduler.RunPending()) {
+        }
+    }
+    int64_t scheduler_us = esp_timer_get_time() - start;
+    size_t scheduler_allocations = AllocationCount() - allocations_before;
+
+    DequeScheduler deque_scheduler;
+    allocations_before = AllocationCount();
+    start = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        for (int i = 0; i < kBurstTasks; i++) {
+            deque_scheduler.Push([capture]() { *(int*)capture.object += capture.values[0]; });
+        }
+        deque_scheduler.RunPending();
+    }
+    int64_t deque_us = esp_timer_get_time() - start;
+    size_t deque_allocations = AllocationCount() - allocations_before;
+
+    CHECK_EQ(sum, 2 * kRounds * kBurstTasks);
+    printf("MainTaskScheduler: %.0f ns per task, %.2f allocations per task (overflow beyond %d per class)\n",
+        scheduler_us * 1000.0 / (kRounds * kBurstTasks), (double)scheduler_allocations / (kRounds * kBurstTasks),
+        MAIN_TASK_QUEUE_SIZE);
+    printf("std::function deque: %.0f ns per task, %.2f allocations per task\n",
+        deque_us * 1000.0 / (kRounds * kBurstTasks), (double)deque_allocations / (kRounds * kBurstTasks));
+}
+
+int main() {
+    RUN_TEST(TestBurst);
+    RUN_TEST(TestPriorityAndBudget);
+    RUN_TEST(TestNoAllocation);
+    RUN_TEST(BenchmarkBurst);
+    return TEST_RESULT();
+}
@@ -0,0 +1,265 @@
+/*
+ * Replay benchmark for the bundled sound assets.
+ *
+ * Turns every .ogg file of the given asset directories (the common sounds and one locale, like
+ * Lang::Sounds) into decoder packets three ways:
+ *   - rescan: AudioService::PlaySound before OggDemuxer, a byte by byte scan for "OggS" on every
+ *             replay and a copy of each packet into a pooled packet;
+ *   - parse:  OggDemuxer::Parse on every replay, packets are views into the asset;
+ *   - cached: the packet index parsed once, like the sound cache of PlaySound.
+ * It prints the time, the bytes copied into packet buffers and the allocations per sound. Both
+ * demuxers must find the same packets in every asset.
+ */
+#include "ogg_demuxer.h"
+#include "protocol.h"
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum ReplayMode {
+    kReplayRescan,
+    kReplayParse,
+    kReplayCached,
+};
+
+static const char* const kModeNames[] = { "rescan", "parse", "cached" };
+
+struct Sound {
+    std::string name;
+    std::string data;
+    std::unique_ptr<OggOpusStream> index;
+};
+
+struct BenchResult {
+    double us_per_sound;
+    double bytes_copied_per_sound;
+    double allocations_per_sound;
+};
+
+// The packets of PlaySound before OggDemuxer, handed to `push` one by one
+template <typename Push>
+static void RescanPackets(std::string_view ogg, Push push) {
+    const uint8_t* buf = reinterpret_cast<const uint8_t*>(ogg.data());
+    size_t size = ogg.size();
+    size_t offset = 0;
+
+    auto find_page = [&](size_t start)->size_t {
+        for (size_t i = start; i + 4 <= size; ++i) {
+            if (buf[i] == 'O' && buf[i+1] == 'g' && buf[i+2] == 'g' && buf[i+3] == 'S') return i;
+        }
+        return static_cast<size_t>(-1);
+    };
+
+    bool seen_head = false;
+    bool seen_tags = false;
+    int sample_rate = 16000;
+
+    while (true) {
+        size_t pos = find_page(offset);
+        if (pos == static_cast<size_t>(-1)) break;
+        offset = pos;
+        if (offset + 27 > size) break;
+
+        const uint8_t* page = buf + offset;
+        uint8_t page_segments = page[26];
+        size_t seg_table_off = offset + 27;
+        if (seg_table_off + page_segments > size) break;
+
+        size_t body_size = 0;
+        for (size_t i = 0; i < page_segments; ++i) body_size += page[27 + i];
+
+        size_t body_off = seg_table_off + page_segments;
+        if (body_off + body_size > size) break;
+
+        size_t cur = body_off;
+        size_t seg_idx = 0;
+        while (seg_idx < page_segments) {
+            size_t pkt_len = 0;
+            size_t pkt_start = cur;
+            bool continued = false;
+            do {
+                uint8_t l = page[27 + seg_idx++];
+                pkt_len += l;
+                cur += l;
+                continued = (l == 255);
+            } while (continued && seg_idx < page_segments);
+
+            if (pkt_len == 0) continue;
+            const uint8_t* pkt_ptr = buf + pkt_start;
+
+            if (!seen_head) {
+                if (pkt_len >= 19 && std::memcmp(pkt_ptr, "OpusHead", 8) == 0) {
+                    seen_head = true;
+                    sample_rate = pkt_ptr[12] | (pkt_ptr[13] << 8) | (pkt_ptr[14] << 16) | (pkt_ptr[15] << 24);
+                }
+                continue;
+            }
+            if (!seen_tags) {
+                if (pkt_len >= 8 && std::memcmp(pkt_ptr, "OpusTags", 8) == 0) {
+                    seen_tags = true;
+                }
+                continue;
+            }
+
+            auto packet = AudioStreamPacket::Acquire();
+            packet->sample_rate = sample_rate;
+            packet->frame_duration = 60;
+            packet->payload.assign(pkt_ptr, pkt_ptr + pkt_len);
+            push(std::move(packet));
+        }
+
+        offset = body_off + body_size;
+    }
+}
+
+// The packets PlaySound pushes for an indexed sound
+template <typename Push>
+static void ViewPackets(const OggOpusStream& sound, Push push) {
+    for (const auto& opus_packet : sound.packets) {
+        auto packet = AudioStreamPacket::Acquire();
+        packet->sample_rate = sound.sample_rate;
+        packet->frame_duration = opus_packet.duration_ms;
+        packet->payload_view = opus_packet.data;
+        packet->payload_view_size = opus_packet.size;
+        push(std::move(packet));
+    }
+}
+
+static std::vector<Sound> LoadSounds(const std::vector<std::string>& directories) {
+    std::vector<Sound> sounds;
+    for (const auto& directory : directories) {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.path().extension() == ".ogg") {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        for (const auto& path : paths) {
+            std::ifstream file(path, std::ios::binary);
+            Sound sound;
+            sound.name = path.parent_path().filename().string() + "/" + path.filename().string();
+            sound.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            sounds.push_back(std::move(sound));
+        }
+    }
+    return sounds;
+}
+
+// Both demuxers must find the same packets, the index with a duration for each
+static bool CheckSounds(std::vector<Sound>& sounds) {
+    bool ok = !sounds.empty();
+    for (auto& sound : sounds) {
+        sound.index = OggDemuxer::Parse(sound.data);
+        if (!sound.index) {
+            fprintf(stderr, "%s: no OpusHead\n", sound.name.c_str());
+            ok = false;
+            continue;
+        }
+        std::vector<std::vector<uint8_t>> rescanned;
+        RescanPackets(sound.data, [&rescanned](std::unique_ptr<AudioStreamPacket> packet) {
+            rescanned.push_back(packet->payload);
+        });
+        bool same = rescanned.size() == sound.index->packets.size();
+        uint32_t duration_ms = 0;
+        for (size_t i = 0; same && i < rescanned.size(); i++) {
+            const auto& packet = sound.index->packets[i];
+            same = packet.duration_ms > 0 && packet.size == rescanned[i].size() &&
+                memcmp(packet.data, rescanned[i].data(), packet.size) == 0;
+            duration_ms += packet.duration_ms;
+        }
+        if (!same) {
+            fprintf(stderr, "%s: the index does not match the rescanned packets\n", sound.name.c_str());
+            ok = false;
+        }
+        printf("%-24s %6zu bytes %4zu packets %6u ms\n", sound.name.c_str(), sound.data.size(),
+            sound.index->packets.size(), (unsigned)duration_ms);
+    }
+    return ok;
+}
+
+static BenchResult Run(ReplayMode mode, const std::vector<Sound>& sounds, int replays) {
+    uint64_t bytes_copied = 0;
+    size_t packets = 0;
+    auto push = [&packets](std::unique_ptr<AudioStreamPacket> packet) {
+        // The decode queue takes the packet, it goes back to the pool once decoded
+        packets += packet->PayloadSize() > 0;
+    };
+    size_t allocations = AllocationCount();
+    auto start = Clock::now();
+    for (int replay = 0; replay < replays; replay++) {
+        for (const auto& sound : sounds) {
+            if (mode == kReplayRescan) {
+                RescanPackets(sound.data, [&](std::unique_ptr<AudioStreamPacket> packet) {
+                    bytes_copied += packet->payload.size();
+                    push(std::move(packet));
+                });
+            } else if (mode == kReplayParse) {
+                auto index = OggDemuxer::Parse(sound.data);
+                for (const auto& assembled : index->assembled) {
+                    bytes_copied += assembled.size();
+                }
+                ViewPackets(*index, push);
+            } else {
+                ViewPackets(*sound.index, push);
+            }
+        }
+    }
+    double elapsed_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    allocations = AllocationCount() - allocations;
+    double count = (double)replays * sounds.size();
+    return { elapsed_us / count, bytes_copied / count, allocations / count };
+}
+
+int main(int argc, char** argv) {
+    int replays = 1000;
+    std::vector<std::string> directories;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--replays") == 0 && i + 1 < argc) {
+            replays = atoi(argv[++i]);
+        } else {
+            directories.push_back(argv[i]);
+        }
+    }
+    if (replays <= 0 || directories.empty()) {
+        fprintf(stderr, "Usage: %s [--replays N] ASSET_DIR...\n", argv[0]);
+        return 1;
+    }
+
+    auto sounds = LoadSounds(directories);
+    bool ok = CheckSounds(sounds);
+    if (!ok) {
+        fprintf(stderr, "FAILED: a sound could not be indexed or its packets differ\n");
+        return 1;
+    }
+    // Warm the packet pool like a running decoder
+    Run(kReplayRescan, sounds, 1);
+
+    printf("%zu sounds replayed %d times, per sound:\n", sounds.size(), replays);
+    printf("%-8s %10s %14s %12s\n", "replay", "us", "bytes copied", "allocations");
+    for (auto mode : { kReplayRescan, kReplayParse, kReplayCached }) {
+        auto result = Run(mode, sounds, replays);
+        printf("%-8s %10.2f %14.1f %12.2f\n", kModeNames[mode], result.us_per_sound, result.bytes_copied_per_sound,
+            result.allocations_per_sound);
+        // A cached replay neither copies nor allocates
+        if (mode == kReplayCached) {
+            ok &= result.bytes_copied_per_sound == 0 && result.allocations_per_sound == 0;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "FAILED: the cached replay copied or allocated\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * PCM kernels against straightforward per-sample reference loops, on random data mixed with
+ * the edge values, for every length up to a few vector blocks and every start alignment.
+ */
+#include "pcm_kernels.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+static constexpr size_t kMaxSamples = 67;
+static constexpr size_t kMaxOffset = 8;
+
+static int16_t RefClamp16(int64_t value) {
+    return (int16_t)std::clamp<int64_t>(value, -INT16_MAX, INT16_MAX);
+}
+
+static std::mt19937 random_engine(2024);
+
+static std::vector<int16_t> MakeInt16(size_t samples) {
+    static const int16_t edges[] = { INT16_MIN, INT16_MIN + 1, -INT16_MAX, -1, 0, 1, INT16_MAX - 1, INT16_MAX };
+    std::vector<int16_t> data(samples);
+    for (auto& sample : data) {
+        if (random_engine() % 4 == 0) {
+            sample = edges[random_engine() % (sizeof(edges) / sizeof(edges[0]))];
+        } else {
+            sample = (int16_t)random_engine();
+        }
+    }
+    return data;
+}
+
+static std::vector<int32_t> MakeInt32(size_t samples) {
+    static const int32_t edges[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX, 32767 << 12, -32768 << 12 };
+    std::vector<int32_t> data(samples);
+    for (auto& sample : data) {
+        if (random_engine() % 4 == 0) {
+            sample = edges[random_engine() % (sizeof(edges) / sizeof(edges[0]))];
+        } else {
+            sample = (int32_t)random_engine();
+        }
+    }
+    return data;
+}
+
+static void TestVolumeToGain() {
+    for (int volume = -10; volume <= 110; volume++) {
+        int clamped = std::clamp(volume, 0, 100);
+        // The floating point formula the codecs used before
+        int32_t expected = (int32_t)(std::pow(clamped / 100.0, 2) * 65536);
+        CHECK_EQ(PcmVolumeToGain(volume), expected);
+    }
+    CHECK_EQ(PcmVolumeToGain(100), 65536);
+}
+
+static void TestScaleToInt32() {
+    static const int32_t gains[] = { 0, 1, 6, 655, 32768, 65535, 65536 };
+    for (size_t samples = 0; samples <= kMaxSamples; samples++) {
+        for (int32_t gain : gains) {
+            auto src = MakeInt16(samples);
+            std::vector<int32_t> dst(samples);
+            PcmScaleToInt32(src.data(), dst.data(), samples, gain);
+            for (size_t i = 0; i < samples; i++) {
+                CHECK_EQ(dst[i], (int64_t)src[i] * gain);
+            }
+        }
+    }
+}
+
+static void TestInt32ToInt16() {
+    for (size_t samples = 0; samples <= kMaxSamples; samples++) {
+        for (int shift = 0; shift <= 16; shift += 4) {
+            auto src = MakeInt32(samples);
+            std::vector<int16_t> dst(samples);
+            PcmInt32ToInt16(src.data(), dst.data(), samples, shift);
+            for (size_t i = 0; i < samples; i++) {
+                CHECK_EQ(dst[i], RefClamp16((int64_t)src[i] >> shift));
+            }
+        }
+    }
+}
+
+static void TestApplyGain() {
+    static const int gains[] = { -65535, -32768, -3, -1, 0, 1, 2, 20, 32767, 65535 };
+    for (size_t offset = 0; offset < kMaxOffset; offset++) {
+        for (size_t samples = 0; samples <= kMaxSamples; samples++) {
+            for (int gain : gains) {
+                auto buffer = MakeInt16(offset + samples);
+                auto expected = buffer;
+                PcmApplyGain(buffer.data() + offset, samples, gain);
+                for (size_t i = offset; i < offset + samples; i++) {
+                    expected[i] = RefClamp16((int64_t)expected[i] * gain);
+                }
+                CHECK(buffer == expected);
+            }
+        }
+    }
+}
+
+static void TestMix() {
+    for (size_t dst_offset = 0; dst_offset < kMaxOffset; dst_offset++) {
+        for (size_t src_offset = 0; src_offset < kMaxOffset; src_offset += 3) {
+            for (size_t samples = 0; samples <= kMaxSamples; samples++) {
+                auto dst = MakeInt16(dst_offset + samples);
+                auto src = MakeInt16(src_offset + samples);
+                auto expected = dst;
+                PcmMix(dst.data() + dst_offset, src.data() + src_offset, samples);
+                for (size_t i = 0; i < samples; i++) {
+                    expected[dst_offset + i] = RefClamp16((int64_t)expected[dst_offset + i] + src[src_offset + i]);
+                }
+                CHECK(dst == expected);
+            }
+        }
+    }
+}
+
+static void TestExtractChannel() {
+    for (int channels = 1; channels <= 4; channels++) {
+        for (int channel = 0; channel < channels; channel++) {
+            for (size_t frames = 0; frames <= kMaxSamples; frames++) {
+                auto src = MakeInt16(frames * channels);
+                std::vector<int16_t> expected(frames);
+                for (size_t i = 0; i < frames; i++) {
+                    expected[i] = src[i * channels + channel];
+                }
+
+                std::vector<int16_t> dst(frames);
+                PcmExtractChannel(src.data(), dst.data(), frames, channels, channel);
+                CHECK(dst == expected);
+
+                // In place, like AudioInputTask does with the capture buffer
+                PcmExtractChannel(src.data(), src.data(), frames, channels, channel);
+                CHECK(std::equal(expected.begin(), expected.end(), src.begin()));
+            }
+        }
+    }
+}
+
+int main() {
+    RUN_TEST(TestVolumeToGain);
+    RUN_TEST(TestScaleToInt32);
+    RUN_TEST(TestInt32ToInt16);
+    RUN_TEST(TestApplyGain);
+    RUN_TEST(TestMix);
+    RUN_TEST(TestExtractChannel);
+    return TEST_RESULT();
+}
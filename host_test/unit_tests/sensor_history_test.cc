@@ -0,0 +1,250 @@
+/*
+ * SensorHistoryStore on a simulated sensor: raw samples come back exactly, also across steps
+ * larger than a delta can hold, the tiers agree with the samples over 31 days, and the NVS
+ * snapshot keeps 30 days across a reboot. Ends with the bytes per sample and the query latency.
+ */
+#include "sensor_history_store.h"
+#include "test.h"
+
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// A day boundary, so the simulated days line up with the snapshot's daily rollups
+static constexpr uint32_t kStartTime = 1760054400;
+
+struct Sample {
+    uint32_t time;
+    int16_t temperature;
+    int16_t humidity;
+};
+
+// One sample per second with a random walk, a few missed seconds and occasional large steps
+// (a calibration offset change or another sensor)
+static std::vector<Sample> MakeSeries(uint32_t start, uint32_t seconds, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<Sample> series;
+    series.reserve(seconds);
+    int temperature = 2350, humidity = 4500;
+    for (uint32_t i = 0; i < seconds; i++) {
+        temperature = std::clamp(temperature + (int)(random() % 41) - 20, -4000, 12500);
+        humidity = std::clamp(humidity + (int)(random() % 41) - 20, 0, 10000);
+        if (random() % 5000 == 0) {
+            temperature = std::clamp(temperature + (int)(random() % 2001) - 1000, -4000, 12500);
+            humidity = std::clamp(humidity + (int)(random() % 2001) - 1000, 0, 10000);
+        }
+        if (random() % 200 != 0) {
+            series.push_back({ start + i, (int16_t)temperature, (int16_t)humidity });
+        }
+    }
+    return series;
+}
+
+// The statistics of the samples in [from, to)
+static SensorRollup Reference(const std::vector<Sample>& series, uint32_t from, uint32_t to) {
+    SensorRollup rollup = { UINT32_MAX, 0, INT16_MAX, INT16_MIN, 0, INT16_MAX, INT16_MIN, 0 };
+    int64_t temperature_sum = 0, humidity_sum = 0;
+    auto begin = std::lower_bound(series.begin(), series.end(), from, [](const Sample& s, uint32_t t) { return s.time < t; });
+    for (auto it = begin; it != series.end() && it->time < to; ++it) {
+        rollup.time = std::min(rollup.time, it->time);
+        rollup.count++;
+        rollup.temperature_min = std::min(rollup.temperature_min, it->temperature);
+        rollup.temperature_max = std::max(rollup.temperature_max, it->temperature);
+        rollup.humidity_min = std::min(rollup.humidity_min, it->humidity);
+        rollup.humidity_max = std::max(rollup.humidity_max, it->humidity);
+        temperature_sum += it->temperature;
+        humidity_sum += it->humidity;
+    }
+    if (rollup.count > 0) {
+        rollup.temperature_avg = (int16_t)(temperature_sum / rollup.count);
+        rollup.humidity_avg = (int16_t)(humidity_sum / rollup.count);
+    }
+    return rollup;
+}
+
+// Counts and extremes are exact in every tier, the averages of averages lose a little to rounding
+static void CheckRollup(const SensorRollup& actual, const SensorRollup& expected) {
+    CHECK_EQ(actual.count, expected.count);
+    CHECK_EQ(actual.temperature_min, expected.temperature_min);
+    CHECK_EQ(actual.temperature_max, expected.temperature_max);
+    CHECK_EQ(actual.humidity_min, expected.humidity_min);
+    CHECK_EQ(actual.humidity_max, expected.humidity_max);
+    CHECK(std::abs(actual.temperature_avg - expected.temperature_avg) <= 3);
+    CHECK(std::abs(actual.humidity_avg - expected.humidity_avg) <= 3);
+}
+
+// Every second of the raw tier reads back the value that was added
+static void TestRawExact() {
+    SensorHistoryStore store;
+    CHECK(store.Allocate());
+    auto series = MakeSeries(kStartTime, 3600, 1);
+    // Steps every few seconds in one minute use up the block's escapes and start a second block
+    for (auto& sample : series) {
+        uint32_t second = sample.time - kStartTime;
+        if (second >= 1800 && second < 1830 && second % 3 == 0) {
+            sample.temperature += 1500;
+            sample.humidity -= 900;
+        }
+    }
+    for (const auto& sample : series) {
+        store.AddSample(sample.time, sample.temperature, sample.humidity);
+    }
+
+    uint32_t raw_from = kStartTime + 3600 - store.raw_duration() + 2 * SENSOR_HISTORY_RAW_BLOCK_SAMPLES;
+    int checked = 0;
+    for (const auto& sample : series) {
+        if (sample.time < raw_from) {
+            continue;
+        }
+        SensorRollup rollup;
+        CHECK(store.Query(sample.time, sample.time + 1, &rollup));
+        CHECK_EQ(rollup.count, 1);
+        CHECK_EQ(rollup.time, sample.time);
+        CHECK_EQ(rollup.temperature_avg, sample.temperature);
+        CHECK_EQ(rollup.humidity_avg, sample.humidity);
+        checked++;
+    }
+    CHECK(checked > 3000);
+
+    // A step of 10 degrees is exact, not caught up over the following seconds
+    SensorHistoryStore step;
+    CHECK(step.Allocate());
+    step.AddSample(kStartTime, 2000, 5000);
+    step.AddSample(kStartTime + 1, 3000, 2000);
+    step.AddSample(kStartTime + 2, 3001, 2001);
+    SensorRollup rollup;
+    CHECK(step.Query(kStartTime + 1, kStartTime + 3, &rollup));
+    CHECK_EQ(rollup.temperature_min, 3000);
+    CHECK_EQ(rollup.temperature_max, 3001);
+    CHECK_EQ(rollup.humidity_min, 2000);
+}
+
+// When the oldest raw block is the second block of a minute, that minute comes from the minute
+// rollup instead, so the evicted first half is not missing and nothing is counted twice. The
+// small internal RAM ring of 16 blocks wraps without completing an hour.
+static void TestContinuedBlockEvicted() {
+    host_psram_size = 0;
+    SensorHistoryStore store;
+    CHECK(store.Allocate());
+    host_psram_size = 8 * 1024 * 1024;
+    std::vector<Sample> series;
+    for (uint32_t i = 0; i < 60 * SENSOR_HISTORY_INTERNAL_RAW_BLOCKS; i++) {
+        // Five steps at the start of the first minute, one more than a block has escapes for
+        int16_t temperature = i >= 1 && i <= 5 ? (int16_t)(i % 2 ? 3000 : 2000) : (int16_t)2500;
+        series.push_back({ kStartTime + i, temperature, 5000 });
+        store.AddSample(series.back().time, temperature, 5000);
+    }
+    uint32_t end = series.back().time + 1;
+    SensorRollup rollup;
+    CHECK(store.Query(kStartTime, end, &rollup));
+    CHECK_EQ(rollup.time, kStartTime);
+    CheckRollup(rollup, Reference(series, kStartTime, end));
+}
+
+static std::vector<Sample> month;
+
+// 31 days through all tiers, queried over hour-aligned ranges like the MCP tool does
+static void TestTiers(SensorHistoryStore& store) {
+    month = MakeSeries(kStartTime, 31 * 86400, 2);
+    for (const auto& sample : month) {
+        store.AddSample(sample.time, sample.temperature, sample.humidity);
+    }
+    uint32_t now = month.back().time;
+    uint32_t now_hour = now - now % 3600;
+    for (uint32_t hours : { 1u, 2u, 6u, 24u, 25u, 72u, 720u }) {
+        uint32_t from = now_hour - (hours - 1) * 3600;
+        SensorRollup rollup;
+        CHECK(store.Query(from, now + 1, &rollup));
+        CheckRollup(rollup, Reference(month, from, now + 1));
+    }
+    // An unaligned start is covered to the second by the raw tier
+    SensorRollup rollup;
+    CHECK(store.Query(now - 1234, now + 1, &rollup));
+    CheckRollup(rollup, Reference(month, now - 1234, now + 1));
+    CHECK(!store.Query(kStartTime - 86400, kStartTime, &rollup));
+}
+
+// The snapshot fits its NVS budget and restores 30 days: the last 2 days by hour, the rest by day
+static void TestSnapshot(SensorHistoryStore& store) {
+    auto blob = store.SaveSnapshot();
+    CHECK(blob.size() <= SENSOR_HISTORY_SNAPSHOT_MAX_SIZE);
+
+    SensorHistoryStore restored;
+    CHECK(restored.Allocate());
+    CHECK_EQ(restored.LoadSnapshot(blob), (blob.size() - 4) / sizeof(SensorRollup));
+
+    uint32_t now = month.back().time;
+    // The snapshot ends with the last completed hour
+    uint32_t saved_to = now - now % 3600;
+    SensorRollup rollup;
+    CHECK(restored.Query(saved_to - 30 * 86400, saved_to, &rollup));
+    CHECK(rollup.time <= saved_to - 29 * 86400);
+    CheckRollup(rollup, Reference(month, rollup.time, saved_to));
+    for (uint32_t hours : { 1u, 24u, 48u }) {
+        CHECK(restored.Query(saved_to - hours * 3600, saved_to, &rollup));
+        CHECK_EQ(rollup.time, saved_to - hours * 3600);
+        CheckRollup(rollup, Reference(month, saved_to - hours * 3600, saved_to));
+    }
+
+    // A snapshot saved after the reboot still covers the days restored from the first one
+    auto resaved = restored.SaveSnapshot();
+    CHECK(resaved == blob);
+
+    CHECK_EQ(restored.LoadSnapshot({ 2, 0, 0, 0 }), -1);
+    CHECK_EQ(restored.LoadSnapshot({ 1, 0, 0 }), -1);
+    CHECK_EQ(restored.LoadSnapshot({}), 0);
+}
+
+// Without PSRAM the tiers shrink to what internal RAM can spare
+static void TestInternalRam() {
+    host_psram_size = 0;
+    SensorHistoryStore store;
+    CHECK(store.Allocate());
+    host_psram_size = 8 * 1024 * 1024;
+    CHECK_EQ(store.raw_duration(), SENSOR_HISTORY_INTERNAL_RAW_BLOCKS * 60);
+    CHECK_EQ(store.hours_duration(), 7 * 86400);
+    CHECK(store.MemoryUsage() < 16 * 1024);
+    printf("without PSRAM: %zu bytes\n", store.MemoryUsage());
+}
+
+static void BenchmarkDensityAndQuery(SensorHistoryStore& store) {
+    size_t rollup_bytes = (SENSOR_HISTORY_MINUTES + SENSOR_HISTORY_HOURS) * sizeof(SensorRollup);
+    size_t raw_bytes = store.MemoryUsage() - rollup_bytes;
+    double bytes_per_sample = (double)raw_bytes / store.raw_duration();
+    CHECK(bytes_per_sample < 3);
+    printf("raw tier: %.2f bytes per sample (both channels), %zu bytes in total\n", bytes_per_sample, store.MemoryUsage());
+
+    uint32_t now = month.back().time;
+    uint32_t now_hour = now - now % 3600;
+    for (uint32_t hours : { 1u, 24u, 720u }) {
+        constexpr int kQueries = 2000;
+        uint32_t from = now_hour - (hours - 1) * 3600;
+        uint64_t count = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kQueries; i++) {
+            SensorRollup rollup;
+            if (store.Query(from, now + 1, &rollup)) {
+                count += rollup.count;
+            }
+        }
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        CHECK(count > 0);
+        printf("Query of %u hours: %.1f us\n", hours, elapsed / kQueries);
+    }
+}
+
+int main() {
+    RUN_TEST(TestRawExact);
+    RUN_TEST(TestContinuedBlockEvicted);
+    SensorHistoryStore store;
+    CHECK(store.Allocate());
+    RUN_TEST([&store] { TestTiers(store); });
+    RUN_TEST([&store] { TestSnapshot(store); });
+    RUN_TEST(TestInternalRam);
+    RUN_TEST([&store] { BenchmarkDensityAndQuery(store); });
+    return TEST_RESULT();
+}
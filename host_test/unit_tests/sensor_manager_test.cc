@@ -0,0 +1,138 @@
+/*
+ * SensorManager on a mock bus. Two polled sensors share the bus, and 1, 4 and 16 consumers
+ * read the cache every 10 ms like the MCP tools, the standby screen and the uploader. The bus
+ * transactions per minute stay at the sampling rate of each sensor whatever the number of
+ * consumers, and transactions of different sensors are at least SENSOR_STAGGER_MS apart.
+ */
+#include "sensor_manager.h"
+#include "test.h"
+
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static constexpr int kFastIntervalMs = 200;
+static constexpr int kSlowIntervalMs = 500;
+static constexpr int kPhaseMs = 3000;
+
+// Counts transactions and records when each one started
+class MockBus {
+public:
+    void Transfer() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t now = esp_timer_get_time();
+        if (last_end_us_ != 0) {
+            min_gap_us_ = std::min(min_gap_us_, now - last_end_us_);
+        }
+        // An I2C read with the conversion time of the sensor
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        transactions_++;
+        last_end_us_ = esp_timer_get_time();
+    }
+
+    uint32_t transactions() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return transactions_;
+    }
+
+    int64_t min_gap_us() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return min_gap_us_;
+    }
+
+private:
+    std::mutex mutex_;
+    uint32_t transactions_ = 0;
+    int64_t last_end_us_ = 0;
+    int64_t min_gap_us_ = INT64_MAX;
+};
+
+static MockBus bus;
+
+class MockSensor : public Sensor {
+public:
+    explicit MockSensor(const char* name) : Sensor(name) {}
+
+    bool IsInitialized() const override { return true; }
+
+    bool Sample() override {
+        bus.Transfer();
+        samples_++;
+        Publish(2350 + samples_ % 10, 4500);
+        return true;
+    }
+
+    uint32_t samples() const { return samples_; }
+
+private:
+    std::atomic<uint32_t> samples_ = 0;
+};
+
+static MockSensor fast_sensor("fast");
+static MockSensor slow_sensor("slow");
+
+// Consumers read both sensors from the cache until the phase ends, returns the number of reads
+static uint64_t RunConsumers(int consumers) {
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> reads = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < consumers; i++) {
+        threads.emplace_back([&stop, &reads]() {
+            while (!stop) {
+                float temperature, humidity;
+                CHECK(fast_sensor.ReadData(&temperature, &humidity));
+                CHECK(slow_sensor.ReadData(&temperature, &humidity));
+                reads += 2;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPhaseMs));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return reads;
+}
+
+static bool WithinTenPercent(double actual, double expected) {
+    return std::abs(actual - expected) <= expected * 0.1;
+}
+
+static void TestTransactionsFollowSamplingRate() {
+    auto& manager = SensorManager::GetInstance();
+    manager.AddSensor(&fast_sensor, kFastIntervalMs);
+    manager.AddSensor(&slow_sensor, kSlowIntervalMs);
+    CHECK(manager.GetSensor("slow") == &slow_sensor);
+    CHECK(manager.GetDefaultSensor() == &fast_sensor);
+    // Both sensors have a sample before the consumers start
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    double scale = 60000.0 / kPhaseMs;
+    for (int consumers : { 1, 4, 16 }) {
+        uint32_t transactions = bus.transactions();
+        uint32_t fast_samples = fast_sensor.samples();
+        uint32_t slow_samples = slow_sensor.samples();
+        uint64_t reads = RunConsumers(consumers);
+        double per_minute = (bus.transactions() - transactions) * scale;
+        double fast_per_minute = (fast_sensor.samples() - fast_samples) * scale;
+        double slow_per_minute = (slow_sensor.samples() - slow_samples) * scale;
+        CHECK(WithinTenPercent(fast_per_minute, 60000.0 / kFastIntervalMs));
+        CHECK(WithinTenPercent(slow_per_minute, 60000.0 / kSlowIntervalMs));
+        printf("%2d consumers: %6.0f reads/min, %4.0f bus transactions/min (%.0f + %.0f)\n", consumers,
+            reads * scale, per_minute, fast_per_minute, slow_per_minute);
+    }
+    CHECK(bus.min_gap_us() >= (SENSOR_STAGGER_MS - 1) * 1000);
+    printf("shortest gap between transactions: %.1f ms\n", bus.min_gap_us() / 1000.0);
+}
+
+int main() {
+    RUN_TEST(TestTransactionsFollowSamplingRate);
+    return TEST_RESULT();
+}
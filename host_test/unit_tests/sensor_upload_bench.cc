@@ -0,0 +1,128 @@
+/*
+ * Keep-alive benchmark for the sensor uploads.
+ *
+ * Posts the same samples to the local HTTP stand-in two ways:
+ *   - per-sample: esp_http_client init, perform and cleanup for every sample, like
+ *     SensorDataUploader::PostData before the long-lived client;
+ *   - keep-alive: SensorDataUploader::UploadSensorData with its long-lived client.
+ * It prints the TCP handshakes, the HTTP bytes and the wall time per 1,000 uploads. The stand-in
+ * is on loopback without TLS, so the wall time only shows the local cost of a handshake; on a
+ * real network each one also costs a round trip, and with https a TLS handshake.
+ */
+#include "sensor_upload.h"
+#include "telemetry_writer.h"
+#include "http_stand_in.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char* kApiKey = "bench-key";
+static constexpr const char* kDeviceId = "sensor-01";
+
+struct BenchResult {
+    uint32_t handshakes;
+    uint32_t requests;
+    uint64_t bytes;
+    double wall_ms;
+};
+
+static BenchResult Finish(HttpStandIn& server, Clock::time_point start) {
+    double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return { server.connections(), server.requests(), server.bytes_received() + server.bytes_sent(), wall_ms };
+}
+
+// The body SensorDataUploader builds for one sample
+static size_t BuildSample(char (&buffer)[256], int index) {
+    TelemetryWriter writer(buffer);
+    writer.BeginObject();
+    writer.Field("device_id", kDeviceId);
+    writer.Field("temperature", 22.0f + (index % 20) * 0.1f);
+    writer.Field("humidity", 50.0f);
+    writer.Field("timestamp", (int64_t)1760054400000 + index * 10000LL);
+    writer.Field("device_status", 0);
+    writer.EndObject();
+    return writer.size();
+}
+
+// The client lifetime of the old PostData: one connection per sample
+static BenchResult RunPerSample(int uploads) {
+    HttpStandIn server;
+    std::string url = server.url();
+    char auth_header[256];
+    snprintf(auth_header, sizeof(auth_header), "Bearer %s", kApiKey);
+    auto start = Clock::now();
+    for (int i = 0; i < uploads; i++) {
+        char body[256];
+        size_t size = BuildSample(body, i);
+        esp_http_client_config_t config = {};
+        config.url = url.c_str();
+        config.method = HTTP_METHOD_POST;
+        config.timeout_ms = 2000;
+        config.buffer_size = 4096;
+        config.buffer_size_tx = 4096;
+        config.user_agent = auth_header;
+        // keep_alive_enable only saves the "Connection: close" header here, cleanup closes the socket
+        config.keep_alive_enable = true;
+        esp_http_client_handle_t client = esp_http_client_init(&config);
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+        esp_http_client_set_header(client, "Authorization", auth_header);
+        esp_http_client_set_post_field(client, body, size);
+        if (esp_http_client_perform(client) != ESP_OK) {
+            fprintf(stderr, "per-sample upload %d failed\n", i);
+        }
+        esp_http_client_cleanup(client);
+    }
+    return Finish(server, start);
+}
+
+static BenchResult RunKeepAlive(int uploads) {
+    HttpStandIn server;
+    SensorDataUploader uploader;
+    uploader.SetUploadUrl(server.url());
+    uploader.SetApiKey(kApiKey);
+    uploader.SetDeviceId(kDeviceId);
+    auto start = Clock::now();
+    for (int i = 0; i < uploads; i++) {
+        if (!uploader.UploadSensorData(22.0f + (i % 20) * 0.1f, 50.0f, 0)) {
+            fprintf(stderr, "keep-alive upload %d failed\n", i);
+        }
+    }
+    return Finish(server, start);
+}
+
+static void Print(const char* name, const BenchResult& result, int uploads) {
+    double scale = 1000.0 / uploads;
+    printf("%-12s %12.0f %10u %12.0f %12.1f\n", name, result.handshakes * scale, result.requests,
+        result.bytes * scale, result.wall_ms * scale);
+}
+
+int main(int argc, char** argv) {
+    int uploads = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--uploads") == 0) {
+            uploads = atoi(argv[i + 1]);
+        }
+    }
+    if (uploads <= 0) {
+        fprintf(stderr, "Usage: %s [--uploads N]\n", argv[0]);
+        return 1;
+    }
+
+    auto per_sample = RunPerSample(uploads);
+    auto keep_alive = RunKeepAlive(uploads);
+    printf("%d uploads to the local stand-in, per 1,000 uploads:\n", uploads);
+    printf("%-12s %12s %10s %12s %12s\n", "client", "handshakes", "requests", "HTTP bytes", "wall ms");
+    Print("per-sample", per_sample, uploads);
+    Print("keep-alive", keep_alive, uploads);
+    // Both must deliver every sample, the long-lived client over a single connection
+    if (per_sample.requests != (uint32_t)uploads || keep_alive.requests != (uint32_t)uploads || keep_alive.handshakes != 1) {
+        fprintf(stderr, "FAILED: expected %d requests each and a single keep-alive connection\n", uploads);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * One day of 10 s samples replayed through SensorUploadPolicy with the default settings. The
+ * tree has no recorded day, so the built-in one is synthetic: a room sensor with a daily cycle,
+ * a heating cycle every 20 minutes, sensor noise at 0.01 resolution and a few conversations that
+ * change the device status. A recording can be replayed instead by passing a CSV file with
+ * "seconds,temperature,humidity,status" lines.
+ *
+ * Reports the upload reduction ratio and the worst-case staleness: the longest time the
+ * dashboard goes without an upload, and the largest difference between the sensor and the last
+ * uploaded value. Status changes must be uploaded with the sample that carries them.
+ */
+#include "sensor_upload_policy.h"
+#include "test.h"
+
+#include <settings.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct ReplaySample {
+    int64_t seconds;
+    float temperature;
+    float humidity;
+    int status;
+};
+
+static std::vector<ReplaySample> SyntheticDay() {
+    std::mt19937 random(1);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<ReplaySample> day;
+    for (int64_t seconds = 0; seconds < 86400; seconds += 10) {
+        double phase = 2 * M_PI * (seconds - 6 * 3600) / 86400.0;
+        // The heating runs 5 minutes out of every 20 and adds up to half a degree
+        double heating = (seconds % 1200) < 300 ? (seconds % 1200) / 600.0 : 0.5 * std::exp(-(seconds % 1200 - 300) / 400.0);
+        float temperature = (float)(21.0 + 2.5 * std::sin(phase) + heating) + 0.02f * noise(random);
+        float humidity = (float)(48.0 - 6.0 * std::sin(phase) - 4.0 * heating) + 0.2f * noise(random);
+        // A three minute conversation every two hours in the daytime: waking, then listening and speaking
+        int status = 0;
+        int64_t since_conversation = seconds % 7200;
+        if (seconds >= 8 * 3600 && seconds < 22 * 3600 && since_conversation < 180) {
+            status = since_conversation < 20 ? 1 : (since_conversation / 20) % 2 ? 2 : 3;
+        }
+        day.push_back({ seconds, std::round(temperature * 100) / 100, std::round(humidity * 100) / 100, status });
+    }
+    return day;
+}
+
+static std::vector<ReplaySample> LoadCsv(const char* path) {
+    std::vector<ReplaySample> samples;
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return samples;
+    }
+    ReplaySample sample;
+    long long seconds;
+    while (fscanf(file, "%lld,%f,%f,%d", &seconds, &sample.temperature, &sample.humidity, &sample.status) == 4) {
+        sample.seconds = seconds;
+        samples.push_back(sample);
+    }
+    fclose(file);
+    return samples;
+}
+
+static int ToX100(float value) {
+    return (int)lroundf(value * 100);
+}
+
+static std::vector<ReplaySample> samples;
+
+static void TestReplayDay() {
+    CHECK(!samples.empty());
+    if (samples.empty()) {
+        return;
+    }
+    Settings settings("sensor_upload", true);
+    settings.EraseKey("min_interval");
+    SensorUploadPolicy policy;
+    const auto& config = policy.config();
+
+    size_t uploads = 0;
+    ReplaySample last_uploaded = {};
+    int64_t max_silence_s = 0;
+    int max_temperature_error = 0;
+    int max_humidity_error = 0;
+    bool status_uploaded = true;
+    for (const auto& replay : samples) {
+        SensorSample sample = {};
+        sample.timestamp = replay.seconds * 1000;
+        sample.temperature = replay.temperature;
+        sample.humidity = replay.humidity;
+        sample.status = replay.status;
+        sample.time_synced = true;
+        bool status_changed = uploads > 0 && replay.status != last_uploaded.status;
+        if (policy.Accept(sample, replay.seconds * 1000000)) {
+            if (uploads > 0) {
+                max_silence_s = std::max(max_silence_s, replay.seconds - last_uploaded.seconds);
+            }
+            uploads++;
+            last_uploaded = replay;
+        } else {
+            status_uploaded &= !status_changed;
+        }
+        // What the dashboard shows against what the sensor reads
+        max_temperature_error = std::max(max_temperature_error, std::abs(ToX100(replay.temperature) - ToX100(last_uploaded.temperature)));
+        max_humidity_error = std::max(max_humidity_error, std::abs(ToX100(replay.humidity) - ToX100(last_uploaded.humidity)));
+    }
+    int64_t cadence_s = samples.size() > 1 ? samples[1].seconds - samples[0].seconds : 0;
+
+    CHECK_EQ(policy.accepted_count(), uploads);
+    CHECK_EQ(policy.accepted_count() + policy.suppressed_count(), samples.size());
+    CHECK(status_uploaded);
+    CHECK(max_silence_s <= config.heartbeat_seconds + cadence_s);
+    // With the minimum interval shorter than the cadence every change past the deadband is sent
+    if (cadence_s >= config.min_interval_seconds) {
+        CHECK(max_temperature_error < config.temperature_deadband_x100);
+        CHECK(max_humidity_error < config.humidity_deadband_x100);
+    }
+    printf("%zu samples, %zu uploads: reduction %.1fx (%.1f%% uploaded)\n", samples.size(), uploads,
+        (double)samples.size() / uploads, 100.0 * uploads / samples.size());
+    printf("worst-case staleness: %lld s without an upload, %.2f°C and %.2f%% off the sensor\n",
+        (long long)max_silence_s, max_temperature_error / 100.0, max_humidity_error / 100.0);
+}
+
+int main(int argc, char** argv) {
+    samples = argc > 1 ? LoadCsv(argv[1]) : SyntheticDay();
+    RUN_TEST(TestReplayDay);
+    return TEST_RESULT();
+}
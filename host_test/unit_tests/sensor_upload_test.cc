@@ -0,0 +1,275 @@
+/*
+ * SensorDataUploader against a local HTTP stand-in. An esp_timer callback that enqueues a sample
+ * every 10 ms keeps its latency while every POST stalls past the client's 2 s timeout, where the
+ * synchronous upload blocks the callback for the whole timeout. Changing the URL, API key and
+ * device ID from another task while the worker uploads takes effect on the next request.
+ * Ends with a simulated 24 hour outage at a 10 s sampling cadence, reporting how long the
+ * backlog takes to flush once the network is back and how many bytes that puts on the wire.
+ */
+#include "sensor_upload.h"
+#include "http_stand_in.h"
+#include "test.h"
+
+#include <esp_timer.h>
+#include <settings.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <sys/time.h>
+
+// Every changed sample is uploaded, the backlog of an earlier test is gone
+static void ResetSettings() {
+    Settings settings("sensor_upload", true);
+    settings.EraseKey("backlog");
+    settings.SetInt("min_interval", 0);
+}
+
+static bool WaitFor(const std::function<bool()>& condition, int timeout_ms) {
+    int64_t end = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (!condition()) {
+        if (esp_timer_get_time() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+struct TimerRun {
+    SensorDataUploader* uploader;
+    bool async;
+    int calls = 0;
+    bool all_queued = true;
+    int64_t last_start_us = 0;
+    int64_t max_duration_us = 0;
+    int64_t max_gap_us = 0;
+};
+
+static void UploadFromTimer(void* arg) {
+    auto run = (TimerRun*)arg;
+    int64_t start = esp_timer_get_time();
+    if (run->last_start_us != 0) {
+        run->max_gap_us = std::max(run->max_gap_us, start - run->last_start_us);
+    }
+    run->last_start_us = start;
+    float temperature = 20.0f + (run->calls % 20) * 0.5f;
+    if (run->async) {
+        run->all_queued &= run->uploader->UploadSensorDataAsync(temperature, 50.0f, 0);
+    } else {
+        run->uploader->UploadSensorData(temperature, 50.0f, 0);
+    }
+    run->calls++;
+    run->max_duration_us = std::max(run->max_duration_us, esp_timer_get_time() - start);
+}
+
+static void RunTimer(TimerRun& run, int period_ms, int duration_ms) {
+    esp_timer_create_args_t args = {
+        .callback = UploadFromTimer,
+        .arg = &run,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sensor_check",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer;
+    esp_timer_create(&args, &timer);
+    esp_timer_start_periodic(timer, period_ms * 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+}
+
+// The server holds every POST longer than the client waits, the timer only ever enqueues
+static void TestStalledServer() {
+    ResetSettings();
+    HttpStandIn server;
+    server.set_stall_ms(2500);
+    {
+        SensorDataUploader uploader;
+        uploader.SetUploadUrl(server.url());
+
+        TimerRun async_run = { &uploader, true };
+        RunTimer(async_run, 10, 3000);
+        CHECK(async_run.calls >= 200);
+        CHECK(async_run.all_queued);
+        // Loose bounds for loaded or sanitized runs, a POST in the callback takes 2 s
+        CHECK(async_run.max_duration_us < 50000);
+        CHECK(async_run.max_gap_us < 100000);
+        CHECK(server.requests() >= 1);
+        printf("async: %d callbacks, max callback %.2f ms, max gap %.1f ms\n", async_run.calls,
+            async_run.max_duration_us / 1000.0, async_run.max_gap_us / 1000.0);
+
+        // The old path: the POST runs in the timer callback. The worker is waiting for its retry
+        // time, so the callback does not wait for the worker's POST as well
+        TimerRun sync_run = { &uploader, false };
+        RunTimer(sync_run, 10, 500);
+        CHECK_EQ(sync_run.calls, 1);
+        CHECK(sync_run.max_duration_us >= 1900000);
+        printf("sync: max callback %.1f ms\n", sync_run.max_duration_us / 1000.0);
+    }
+    // The destructor waits for the stalled POST and saves what was not delivered
+    CHECK(!Settings("sensor_upload").GetBlob("backlog").empty());
+}
+
+// The configuration can change from any task while the worker uploads
+static void TestConfigurationChange() {
+    ResetSettings();
+    HttpStandIn server;
+    std::atomic<int> delivered = 0;
+    SensorDataUploader uploader;
+    uploader.SetUploadUrl(server.url("/a"));
+    uploader.SetApiKey("key-1");
+    uploader.SetDeviceId("device-1");
+    uploader.SetUploadCallback([&delivered](bool success, const char*) {
+        if (success) {
+            delivered++;
+        }
+    });
+
+    std::thread configurator([&uploader, &server]() {
+        for (int i = 0; i < 200; i++) {
+            uploader.SetUploadUrl(server.url(i % 2 ? "/b" : "/a"));
+            uploader.SetApiKey(i % 2 ? "key-2" : "key-1");
+            uploader.SetDeviceId(i % 2 ? "device-2" : "device-1");
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+    for (int i = 0; i < 200; i++) {
+        while (!uploader.UploadSensorDataAsync(20.0f + (i % 2), 50.0f, 0)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    configurator.join();
+
+    // The last configuration is /b with key-2 and device-2
+    int before = delivered;
+    uploader.UploadSensorDataAsync(30.0f, 50.0f, 1);
+    CHECK(WaitFor([&]() { return delivered > before && server.requests() == (uint32_t)delivered; }, 5000));
+    CHECK(server.last_path() == "/b");
+    CHECK(server.last_authorization() == "Bearer key-2");
+    CHECK(server.bodies().back().find("\"device_id\":\"device-2\"") != std::string::npos);
+    // A new key needs a new connection
+    CHECK(server.connections() >= 2);
+}
+
+// A URL nobody listens on, so every connection is refused like without Wi-Fi
+static std::string UnreachableUrl() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&address, sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(fd, (sockaddr*)&address, &length);
+    close(fd);
+    return "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)) + "/api/sensor-data";
+}
+
+static int64_t WallTimeMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+// The sample timestamps in a request body, in order
+static std::vector<int64_t> Timestamps(const std::string& body) {
+    std::vector<int64_t> timestamps;
+    for (size_t pos = body.find("\"timestamp\":"); pos != std::string::npos; pos = body.find("\"timestamp\":", pos + 1)) {
+        timestamps.push_back(strtoll(body.c_str() + pos + 12, nullptr, 10));
+    }
+    return timestamps;
+}
+
+// The samples in the bodies that were taken before a time
+static size_t CountBefore(const std::vector<std::string>& bodies, int64_t time_ms, bool* ordered) {
+    size_t count = 0;
+    int64_t last_timestamp = 0;
+    for (const auto& body : bodies) {
+        for (int64_t timestamp : Timestamps(body)) {
+            *ordered &= timestamp >= last_timestamp;
+            last_timestamp = timestamp;
+            count += timestamp < time_ms;
+        }
+    }
+    return count;
+}
+
+// 24 hours without a network at a 10 s cadence, then the network comes back. The device clock
+// advances 10 s per sample during the outage. A daily temperature and humidity cycle with a
+// little noise goes through the default upload policy.
+static void SimulateOutage(int batch_size) {
+    constexpr int kStepSeconds = 10;
+    constexpr int kOutageSteps = 24 * 3600 / kStepSeconds;
+    Settings settings("sensor_upload", true);
+    settings.EraseKey("backlog");
+    settings.EraseKey("min_interval");
+
+    HttpStandIn server;
+    SensorDataUploader uploader;
+    uploader.SetUploadUrl(UnreachableUrl());
+    uploader.SetDeviceId("sensor-01");
+    uploader.SetBatchSize(batch_size);
+    uploader.SetBatchMaxLatency(60 * 1000);
+
+    auto sample = [&uploader](int step) {
+        double day = 2 * M_PI * step * kStepSeconds / 86400.0;
+        float temperature = 22.0f + 3.0f * (float)sin(day) + 0.03f * (step % 5);
+        float humidity = 50.0f - 10.0f * (float)sin(day) + 0.3f * (step % 3);
+        uploader.UploadSensorDataAsync(temperature, humidity, 0);
+    };
+
+    for (int step = 0; step < kOutageSteps; step++) {
+        sample(step);
+        // Lets the worker take the sample before the clock moves on
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        host_advance_time(kStepSeconds * 1000000LL);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    int64_t outage_end_ms = WallTimeMs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CHECK_EQ(server.connections(), 0);
+
+    // The network is back. After the longest retry backoff the next sample wakes the worker and
+    // pushes the oldest one out of the full backlog, from then on the flush runs in real time
+    uploader.SetUploadUrl(server.url());
+    host_advance_time(SENSOR_UPLOAD_RETRY_MAX_MS * 1000LL);
+    auto start = std::chrono::steady_clock::now();
+    sample(kOutageSteps);
+    bool ordered = true;
+    size_t backlog = 0;
+    CHECK(WaitFor([&]() {
+        backlog = CountBefore(server.bodies(), outage_end_ms, &ordered);
+        return backlog >= SENSOR_SAMPLE_QUEUE_CAPACITY - 1;
+    }, 5000));
+    double flush_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // Every request has been answered
+    CHECK(WaitFor([&]() { return server.requests() == server.bodies().size(); }, 1000));
+
+    // Samples reach the server once and in order, only the newest of the outage fit in the backlog
+    ordered = true;
+    CHECK_EQ(CountBefore(server.bodies(), outage_end_ms, &ordered), (size_t)SENSOR_SAMPLE_QUEUE_CAPACITY - 1);
+    CHECK(ordered);
+    uint64_t bytes = server.bytes_received() + server.bytes_sent();
+    printf("batch %d: %d samples in the outage, the last %u flushed in %.1f ms after the retry backoff, "
+        "%u requests, %llu bytes on the wire (%.0f per sample)\n",
+        batch_size, kOutageSteps, (unsigned)backlog, flush_ms, (unsigned)server.requests(),
+        (unsigned long long)bytes, (double)bytes / backlog);
+}
+
+static void TestOutage() {
+    SimulateOutage(1);
+}
+
+static void TestBatchedOutage() {
+    SimulateOutage(SENSOR_UPLOAD_MAX_BATCH);
+}
+
+int main() {
+    RUN_TEST(TestStalledServer);
+    RUN_TEST(TestConfigurationChange);
+    RUN_TEST(TestOutage);
+    RUN_TEST(TestBatchedOutage);
+    return TEST_RESULT();
+}
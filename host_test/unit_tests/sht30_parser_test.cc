@@ -0,0 +1,210 @@
+/*
+ * SHT30 line parser on known lines, and the framer + parser on a fuzzed UART byte stream split
+ * into random chunks. Ends with the parse cost per line.
+ */
+#include "sht30_parser.h"
+#include "test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static bool Parse(const char* line, int32_t* humidity, int32_t* temperature) {
+    return Sht30ParseLine(line, strlen(line), humidity, temperature);
+}
+
+static void TestParseLine() {
+    int32_t humidity = 0, temperature = 0;
+    CHECK(Parse("R:039.2RH 023.3C", &humidity, &temperature));
+    CHECK_EQ(humidity, 3920);
+    CHECK_EQ(temperature, 2330);
+
+    CHECK(Parse("\xff" "xR:100.0RH -05.35C", &humidity, &temperature));
+    CHECK_EQ(humidity, 10000);
+    CHECK_EQ(temperature, -535);
+
+    CHECK(Parse("R:0RH 0.999C", &humidity, &temperature));
+    CHECK_EQ(humidity, 0);
+    CHECK_EQ(temperature, 99);
+
+    static const char* const invalid[] = {
+        "",
+        "R",
+        "R:",
+        "R:RH 23.3C",
+        "R:39.2 23.3C",
+        "R:39.2RH 23.3",
+        "R:39.2RH C",
+        "R:100.1RH 23.3C",
+        "R:-01.0RH 23.3C",
+        "R:123456.0RH 23.3C",
+        "039.2RH 023.3C",
+    };
+    for (const char* line : invalid) {
+        humidity = temperature = 12345;
+        bool parsed = Parse(line, &humidity, &temperature);
+        if (parsed) {
+            fprintf(stderr, "parsed invalid line \"%s\"\n", line);
+        }
+        CHECK(!parsed);
+        CHECK_EQ(humidity, 12345);
+        CHECK_EQ(temperature, 12345);
+    }
+}
+
+// Every value the module can report, against strtod on the same text
+static void TestParseAgainstReference() {
+    char line[SHT30_MAX_LINE_LENGTH];
+    for (int humidity_x10 = 0; humidity_x10 <= 1000; humidity_x10 += 7) {
+        for (int temperature_x10 = -400; temperature_x10 <= 1250; temperature_x10 += 3) {
+            snprintf(line, sizeof(line), "R:%05.1fRH %05.1fC", humidity_x10 / 10.0, temperature_x10 / 10.0);
+            int32_t humidity = 0, temperature = 0;
+            CHECK(Parse(line, &humidity, &temperature));
+            char* end = nullptr;
+            CHECK_EQ(humidity, (int32_t)std::lround(strtod(line + 2, &end) * 100));
+            CHECK_EQ(temperature, (int32_t)std::lround(strtod(end + 3, nullptr) * 100));
+        }
+    }
+}
+
+struct Reading {
+    int32_t humidity;
+    int32_t temperature;
+    bool operator==(const Reading&) const = default;
+};
+
+static std::mt19937 random_engine(1);
+
+// Valid lines and garbage lines (never containing 'R', so they cannot parse), with CR, LF or
+// CRLF endings and a few overlong lines that the framer must drop
+static std::string MakeStream(int lines, std::vector<Reading>& expected) {
+    static const char* const endings[] = { "\n", "\r", "\r\n", "\n\n" };
+    std::string stream;
+    for (int i = 0; i < lines; i++) {
+        switch (random_engine() % 4) {
+        case 0:
+        case 1: {
+            Reading reading = { (int32_t)(random_engine() % 1001) * 10, (int32_t)(random_engine() % 1651) * 10 - 4000 };
+            char line[SHT30_MAX_LINE_LENGTH];
+            snprintf(line, sizeof(line), "R:%05.1fRH %05.1fC", reading.humidity / 100.0, reading.temperature / 100.0);
+            stream += line;
+            expected.push_back(reading);
+            break;
+        }
+        case 2: {
+            size_t length = random_engine() % (SHT30_MAX_LINE_LENGTH * 2);
+            for (size_t j = 0; j < length; j++) {
+                char c = (char)random_engine();
+                stream += (c == '\n' || c == '\r' || c == 'R') ? ' ' : c;
+            }
+            break;
+        }
+        default:
+            // Too long for the framer, even though it ends in a valid reading
+            stream += std::string(SHT30_MAX_LINE_LENGTH, ' ') + "R:039.2RH 023.3C";
+            break;
+        }
+        stream += endings[random_engine() % 4];
+    }
+    return stream;
+}
+
+static void TestFramedStream() {
+    for (int round = 0; round < 50; round++) {
+        std::vector<Reading> expected;
+        std::string stream = MakeStream(500, expected);
+
+        Sht30LineFramer framer;
+        std::vector<Reading> readings;
+        auto on_line = [&](const char* line, size_t length) {
+            CHECK(length > 0 && length <= SHT30_MAX_LINE_LENGTH);
+            Reading reading;
+            if (Sht30ParseLine(line, length, &reading.humidity, &reading.temperature)) {
+                readings.push_back(reading);
+            }
+        };
+        for (size_t offset = 0; offset < stream.size();) {
+            size_t chunk = std::min<size_t>(1 + random_engine() % 64, stream.size() - offset);
+            framer.Feed((const uint8_t*)stream.data() + offset, chunk, on_line);
+            offset += chunk;
+        }
+        CHECK(readings == expected);
+    }
+}
+
+// Readings with random bytes replaced, inserted or dropped, and plain random bytes biased
+// towards the characters of a reading: nothing crashes (run with HOST_TEST_SANITIZE=ON) and
+// everything parsed is in range
+static void TestFuzz() {
+    static const char alphabet[] = "R:H C.-+0123456789\r\n";
+    auto random_byte = [] {
+        uint32_t value = random_engine();
+        return (value & 0x300) != 0 ? alphabet[value % (sizeof(alphabet) - 1)] : (char)value;
+    };
+    Sht30LineFramer framer;
+    int parsed = 0;
+    auto on_line = [&](const char* line, size_t length) {
+        CHECK(length > 0 && length <= SHT30_MAX_LINE_LENGTH);
+        int32_t humidity, temperature;
+        if (Sht30ParseLine(line, length, &humidity, &temperature)) {
+            CHECK(humidity >= 0 && humidity <= 10000);
+            CHECK(temperature > -10000000 && temperature < 10000000);
+            parsed++;
+        }
+    };
+    for (int round = 0; round < 200000; round++) {
+        std::string chunk;
+        if (random_engine() % 2 == 0) {
+            chunk = "R:039.2RH 023.3C\r\n";
+            for (int mutations = random_engine() % 4; mutations > 0; mutations--) {
+                size_t position = random_engine() % chunk.size();
+                switch (random_engine() % 3) {
+                case 0: chunk[position] = random_byte(); break;
+                case 1: chunk.insert(position, 1, random_byte()); break;
+                default: chunk.erase(position, 1); break;
+                }
+            }
+        } else {
+            for (size_t size = 1 + random_engine() % 64; size > 0; size--) {
+                chunk += random_byte();
+            }
+        }
+        framer.Feed((const uint8_t*)chunk.data(), chunk.size(), on_line);
+        if (round % 1000 == 0) {
+            framer.Reset();
+        }
+    }
+    CHECK(parsed > 0);
+    printf("fuzz: %d lines parsed\n", parsed);
+}
+
+static void BenchmarkParse() {
+    constexpr int kLines = 1000000;
+    static const char line[] = "R:039.2RH 023.3C";
+    int64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLines; i++) {
+        int32_t humidity, temperature;
+        // Keep the compiler from hoisting the parse out of the loop
+        asm volatile("" ::: "memory");
+        if (Sht30ParseLine(line, sizeof(line) - 1, &humidity, &temperature)) {
+            sum += humidity + temperature;
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK_EQ(sum, (int64_t)kLines * (3920 + 2330));
+    printf("Sht30ParseLine: %.1f ns per line\n", elapsed / kLines);
+}
+
+int main() {
+    RUN_TEST(TestParseLine);
+    RUN_TEST(TestParseAgainstReference);
+    RUN_TEST(TestFramedStream);
+    RUN_TEST(TestFuzz);
+    RUN_TEST(BenchmarkParse);
+    return TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+/*
+ * SpscRing: FIFO order across a producer and a consumer thread, Clear() from a third thread,
+ * and the capacity held by cleared items until the consumer drops them.
+ */
+#include "spsc_ring.h"
+#include "test.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+static void TestSingleThread() {
+    SpscRing<std::unique_ptr<int>, 3> ring;
+    CHECK(ring.Empty());
+    for (int i = 0; i < 3; i++) {
+        CHECK(ring.Push(std::make_unique<int>(i)));
+    }
+    CHECK(ring.Full());
+    CHECK(!ring.Push(std::make_unique<int>(3)));
+    CHECK_EQ(ring.Size(), 3);
+
+    std::unique_ptr<int> item;
+    CHECK(ring.Pop(item));
+    CHECK_EQ(*item, 0);
+    CHECK(ring.Push(std::make_unique<int>(3)));
+    for (int expected = 1; expected <= 3; expected++) {
+        CHECK(ring.Pop(item));
+        CHECK_EQ(*item, expected);
+    }
+    CHECK(!ring.Pop(item));
+}
+
+static void TestClearReleasesCapacityOnPop() {
+    SpscRing<std::unique_ptr<int>, 4> ring;
+    for (int i = 0; i < 4; i++) {
+        ring.Push(std::make_unique<int>(i));
+    }
+    ring.Clear();
+    CHECK_EQ(ring.Size(), 0);
+    CHECK(ring.Empty());
+    // The cleared items still hold their slots until the consumer runs
+    CHECK(ring.Full());
+    std::unique_ptr<int> item;
+    CHECK(!ring.Pop(item));
+    CHECK(!ring.Full());
+    CHECK(ring.Push(std::make_unique<int>(10)));
+    CHECK(ring.Pop(item));
+    CHECK_EQ(*item, 10);
+}
+
+static void TestConcurrentOrder() {
+    constexpr int kItems = 1000000;
+    SpscRing<int, 40> ring;
+    std::thread producer([&]() {
+        for (int i = 0; i < kItems; i++) {
+            while (!ring.Push(int(i))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    int item;
+    bool ordered = true;
+    while (expected < kItems) {
+        if (ring.Pop(item)) {
+            ordered &= item == expected;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(ring.Empty());
+}
+
+static void TestConcurrentClear() {
+    constexpr int kItems = 1000000;
+    SpscRing<int, 16> ring;
+    std::atomic<bool> done = false;
+    std::thread producer([&]() {
+        for (int i = 0; i < kItems; i++) {
+            while (!ring.Push(int(i))) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+    std::thread clearer([&]() {
+        while (!done) {
+            ring.Clear();
+            std::this_thread::yield();
+        }
+    });
+    // Items may be dropped, but the survivors stay in order and none is seen twice
+    int last = -1;
+    bool ordered = true;
+    int item;
+    while (!done || !ring.Empty()) {
+        if (ring.Pop(item)) {
+            ordered &= item > last;
+            last = item;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    clearer.join();
+    CHECK(ordered);
+    CHECK(last < kItems);
+}
+
+int main() {
+    RUN_TEST(TestSingleThread);
+    RUN_TEST(TestClearReleasesCapacityOnPop);
+    RUN_TEST(TestConcurrentOrder);
+    RUN_TEST(TestConcurrentClear);
+    return TEST_RESULT();
+}
@@ -0,0 +1,148 @@
+/*
+ * TelemetryWriter output against golden strings in the sensor upload JSON format, and the
+ * truncation behavior for every buffer size. Ends with the cost per record.
+ */
+#include "../../main/telemetry_writer.h"
+#include "test.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <string>
+
+struct Sample {
+    int64_t timestamp;
+    float temperature;
+    float humidity;
+    int32_t status;
+    bool time_synced;
+};
+
+// Same fields and order as SensorDataUploader::WriteSample
+static void WriteSample(TelemetryWriter& writer, const char* device_id, const Sample& sample) {
+    writer.BeginObject();
+    if (device_id[0] != '\0') {
+        writer.Field("device_id", device_id);
+    }
+    writer.Field("temperature", sample.temperature);
+    writer.Field("humidity", sample.humidity);
+    writer.Field("timestamp", sample.timestamp);
+    if (!sample.time_synced) {
+        writer.Field("time_synced", false);
+    }
+    writer.Field("device_status", sample.status);
+    writer.EndObject();
+}
+
+static const Sample kSynced = { 1760000000123, 23.6f, 45.2f, 2, true };
+static const Sample kUnsynced = { 42000, -5.25f, 100.0f, 0, false };
+
+static const char kSyncedJson[] =
+    "{\"device_id\":\"pcroom-esp32\",\"temperature\":23.60,\"humidity\":45.20,\"timestamp\":1760000000123,"
+    "\"device_status\":2}";
+static const char kUnsyncedJson[] =
+    "{\"temperature\":-5.25,\"humidity\":100.00,\"timestamp\":42000,\"time_synced\":false,\"device_status\":0}";
+
+static void TestSample() {
+    char buffer[256];
+    TelemetryWriter writer(buffer);
+    WriteSample(writer, "pcroom-esp32", kSynced);
+    CHECK(writer.ok());
+    CHECK_STREQ(writer.data(), kSyncedJson);
+    CHECK_EQ(writer.size(), strlen(kSyncedJson));
+
+    TelemetryWriter unsynced(buffer);
+    WriteSample(unsynced, "", kUnsynced);
+    CHECK(unsynced.ok());
+    CHECK_STREQ(unsynced.data(), kUnsyncedJson);
+}
+
+static void TestBatch() {
+    char buffer[512];
+    TelemetryWriter writer(buffer);
+    writer.BeginArray();
+    WriteSample(writer, "pcroom-esp32", kSynced);
+    WriteSample(writer, "pcroom-esp32", kSynced);
+    WriteSample(writer, "", kUnsynced);
+    writer.EndArray();
+    CHECK(writer.ok());
+    std::string expected = std::string("[") + kSyncedJson + "," + kSyncedJson + "," + kUnsyncedJson + "]";
+    CHECK_STREQ(writer.data(), expected.c_str());
+
+    TelemetryWriter empty(buffer);
+    empty.BeginArray();
+    empty.EndArray();
+    CHECK_STREQ(empty.data(), "[]");
+}
+
+static void TestValues() {
+    char buffer[512];
+    TelemetryWriter writer(buffer);
+    writer.BeginObject();
+    writer.Field("id", "a\"b\\c\nd\x01/");
+    writer.Field("nan", std::nanf(""));
+    writer.Field("inf", -std::numeric_limits<double>::infinity());
+    writer.Field("round", 0.005);
+    writer.Field("min", std::numeric_limits<int64_t>::min());
+    writer.Field("max", std::numeric_limits<uint64_t>::max());
+    writer.Field("small", (uint8_t)200);
+    writer.Field("on", true);
+    writer.EndObject();
+    CHECK(writer.ok());
+    CHECK_STREQ(writer.data(),
+        "{\"id\":\"a\\\"b\\\\c\\u000ad\\u0001/\",\"nan\":null,\"inf\":null,\"round\":0.01,"
+        "\"min\":-9223372036854775808,\"max\":18446744073709551615,\"small\":200,\"on\":true}");
+
+    TelemetryWriter values(buffer);
+    values.BeginArray();
+    values.Value(1);
+    values.Value("x");
+    values.Value(1.5f);
+    values.EndArray();
+    CHECK_STREQ(values.data(), "[1,\"x\",1.50]");
+}
+
+// Every buffer size up to the full length: the output never overruns and ok() is false until
+// the whole record and the terminating '\0' fit
+static void TestTruncation() {
+    const size_t length = strlen(kSyncedJson);
+    for (size_t capacity = 0; capacity <= length + 1; capacity++) {
+        std::string buffer(capacity + 8, '#');
+        TelemetryWriter writer(buffer.data(), capacity);
+        WriteSample(writer, "pcroom-esp32", kSynced);
+        CHECK_EQ(writer.ok(), capacity > length);
+        CHECK_EQ(buffer.compare(capacity, 8, "########"), 0);
+        if (capacity > 0) {
+            CHECK(memchr(buffer.data(), '\0', capacity) != nullptr);
+        }
+        if (writer.ok()) {
+            CHECK_STREQ(writer.data(), kSyncedJson);
+        }
+    }
+}
+
+static void BenchmarkSample() {
+    constexpr int kRecords = 200000;
+    char buffer[256];
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRecords; i++) {
+        Sample sample = kSynced;
+        sample.timestamp += i;
+        TelemetryWriter writer(buffer);
+        WriteSample(writer, "pcroom-esp32", sample);
+        total += writer.size();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK_EQ(total, (size_t)kRecords * strlen(kSyncedJson));
+    printf("TelemetryWriter: %.0f ns per sample\n", elapsed / kRecords);
+}
+
+int main() {
+    RUN_TEST(TestSample);
+    RUN_TEST(TestBatch);
+    RUN_TEST(TestValues);
+    RUN_TEST(TestTruncation);
+    RUN_TEST(BenchmarkSample);
+    return TEST_RESULT();
+}
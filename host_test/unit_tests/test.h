@@ -0,0 +1,56 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+/*
+ * Minimal checks for the host unit tests: a failed CHECK prints the expression and marks the
+ * test failed, TEST_MAIN runs the cases in order and returns non-zero when one of them failed.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expression); \
+            TestFailures()++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        long long actual_value_ = (long long)(actual); \
+        long long expected_value_ = (long long)(expected); \
+        if (!(actual_value_ == expected_value_)) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #actual, \
+                #expected, actual_value_, expected_value_); \
+            TestFailures()++; \
+        } \
+    } while (0)
+
+#define CHECK_STREQ(actual, expected) \
+    do { \
+        const char* actual_value_ = (actual); \
+        const char* expected_value_ = (expected); \
+        if (strcmp(actual_value_, expected_value_) != 0) { \
+            fprintf(stderr, "%s:%d: CHECK_STREQ failed: %s\n  actual:   %s\n  expected: %s\n", __FILE__, __LINE__, \
+                #actual, actual_value_, expected_value_); \
+            TestFailures()++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(function) \
+    do { \
+        int failures_before_ = TestFailures(); \
+        function(); \
+        printf("%s %s\n", TestFailures() == failures_before_ ? "PASS" : "FAIL", #function); \
+    } while (0)
+
+#define TEST_RESULT() (TestFailures() == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,115 @@
+/*
+ * TimerLatencyMonitor on the host esp_timer task while sensor samples are uploaded to the HTTP
+ * stand-in, which holds every response for 300 ms like a slow network:
+ *   - timer: the old state monitor, a 1 s esp_timer callback that reads the sensor (a blocking
+ *     20 ms UART read) and uploads every second sample with the synchronous UploadSensorData;
+ *   - task:  the state monitor task woken by the sensor's sample notifications, queueing the
+ *     samples with UploadSensorDataAsync. The upload task posts them.
+ * The monitor's 100 ms timer is late by the whole POST in the first run and never late in the
+ * second.
+ */
+#include "timer_latency_monitor.h"
+#include "sensor_upload.h"
+#include "http_stand_in.h"
+#include "test.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <settings.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static constexpr int kRunMs = 5000;
+
+static SensorDataUploader* uploader;
+
+// The SHT30 UART read of the old monitor callback
+static void ReadSensor() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static void StateMonitorCallback(void* arg) {
+    auto ticks = (int*)arg;
+    ReadSensor();
+    if (++*ticks % 2 == 0) {
+        uploader->UploadSensorData(23.5f, 45.0f, 0);
+    }
+}
+
+static void TestTimerCallback() {
+    TimerLatencyMonitor monitor;
+    monitor.Start();
+    int ticks = 0;
+    esp_timer_create_args_t args = {
+        .callback = StateMonitorCallback,
+        .arg = &ticks,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "state_monitor",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer;
+    esp_timer_create(&args, &timer);
+    esp_timer_start_periodic(timer, 1000000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+
+    CHECK(ticks >= 4);
+    CHECK(monitor.max_latency_us() >= 250000);
+    CHECK(monitor.late_count() >= 1);
+    printf("timer: max esp_timer latency %.1f ms, %lu late callbacks\n", monitor.max_latency_us() / 1000.0,
+        (unsigned long)monitor.late_count());
+}
+
+static std::atomic<bool> monitor_stopping;
+static std::atomic<int> monitor_uploads;
+
+static void TestMonitorTask() {
+    TimerLatencyMonitor monitor;
+    monitor.Start();
+    monitor_stopping = false;
+    monitor_uploads = 0;
+    TaskHandle_t monitor_task;
+    xTaskCreate([](void* arg) {
+        int samples = 0;
+        while (!monitor_stopping) {
+            if (xTaskNotifyWait(0, UINT32_MAX, nullptr, pdMS_TO_TICKS(100)) == pdTRUE && ++samples % 2 == 0) {
+                uploader->UploadSensorDataAsync(23.5f + samples * 0.5f, 45.0f, 0);
+                monitor_uploads++;
+            }
+        }
+        vTaskDelete(NULL);
+    }, "state_monitor", 4096, nullptr, 2, &monitor_task);
+
+    // The sensor reads in its own context and notifies the monitor task of every sample
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(kRunMs);
+    while (std::chrono::steady_clock::now() < end) {
+        ReadSensor();
+        xTaskNotify(monitor_task, 1, eSetBits);
+        std::this_thread::sleep_for(std::chrono::milliseconds(980));
+    }
+    monitor_stopping = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    CHECK(monitor_uploads >= 2);
+    CHECK(monitor.max_latency_us() < 50000);
+    CHECK_EQ(monitor.late_count(), 0);
+    printf("task: max esp_timer latency %.1f ms, %lu late callbacks\n", monitor.max_latency_us() / 1000.0,
+        (unsigned long)monitor.late_count());
+}
+
+int main() {
+    Settings settings("sensor_upload", true);
+    settings.SetInt("min_interval", 0);
+    HttpStandIn server;
+    server.set_stall_ms(300);
+    SensorDataUploader sensor_uploader;
+    sensor_uploader.SetUploadUrl(server.url());
+    uploader = &sensor_uploader;
+    RUN_TEST(TestTimerCallback);
+    RUN_TEST(TestMonitorTask);
+    CHECK(server.requests() >= 4);
+    return TEST_RESULT();
+}
@@ -0,0 +1,234 @@
+/*
+ * Benchmark for the MQTT UDP audio encryption, with the system mbedtls.
+ *
+ * Encrypts and decrypts the same Opus-sized frames two ways:
+ *   - copy:   MqttProtocol before UdpAudioCipher; a nonce string and a datagram string per sent
+ *             frame, a new packet and payload per received datagram;
+ *   - cipher: UdpAudioCipher, the datagram buffer is reused and received payloads are decrypted
+ *             into pooled packets.
+ * It prints the packets per second, the time and the allocations per frame for both directions.
+ * The AES-CTR of the host library is checked against the SP 800-38A test vector first.
+ */
+#include "udp_audio_cipher.h"
+#include "alloc_counter.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const std::string kKey("\x2b\x7e\x15\x16\x28\xae\xd2\xa6\xab\xf7\x15\x88\x09\xcf\x4f\x3c", 16);
+static const std::string kNonce("\x01\x00\x00\x00\x5a\x5a\x5a\x5a\x00\x00\x00\x00\x00\x00\x00\x00", 16);
+
+struct BenchResult {
+    double packets_per_second;
+    double ns_per_frame;
+    double allocations_per_frame;
+    bool frames_valid;
+};
+
+static std::vector<std::vector<uint8_t>> opus_frames;
+
+// 60 ms Opus frames between 16 and 24 kbps, like the encoder and the server send
+static void MakeOpusFrames() {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> frame_bytes(120, 180);
+    opus_frames.resize(64);
+    for (auto& opus : opus_frames) {
+        opus.resize(frame_bytes(random));
+        for (auto& byte : opus) {
+            byte = (uint8_t)random();
+        }
+    }
+}
+
+// SP 800-38A F.5.1, the first block of CTR-AES128.Encrypt
+static bool CheckTestVector() {
+    const uint8_t counter[16] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+    const uint8_t plaintext[16] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+    const uint8_t expected[16] = { 0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce };
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, (const unsigned char*)kKey.data(), 128);
+    uint8_t nonce_counter[16];
+    memcpy(nonce_counter, counter, sizeof(nonce_counter));
+    uint8_t stream_block[16] = {0};
+    uint8_t output[16];
+    size_t nc_off = 0;
+    int ret = mbedtls_aes_crypt_ctr(&aes, sizeof(plaintext), &nc_off, nonce_counter, stream_block, plaintext, output);
+    mbedtls_aes_free(&aes);
+    return ret == 0 && memcmp(output, expected, sizeof(expected)) == 0;
+}
+
+// MqttProtocol::SendAudio before UdpAudioCipher
+static std::string CopyEncrypt(mbedtls_aes_context& aes, const AudioStreamPacket& packet, uint32_t sequence) {
+    std::string nonce(kNonce);
+    *(uint16_t*)&nonce[2] = htons(packet.PayloadSize());
+    *(uint32_t*)&nonce[8] = htonl(packet.timestamp);
+    *(uint32_t*)&nonce[12] = htonl(sequence);
+
+    std::string encrypted;
+    encrypted.resize(kNonce.size() + packet.PayloadSize());
+    memcpy(encrypted.data(), nonce.data(), nonce.size());
+
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    mbedtls_aes_crypt_ctr(&aes, packet.PayloadSize(), &nc_off, (uint8_t*)nonce.data(), stream_block,
+        packet.PayloadData(), (uint8_t*)&encrypted[nonce.size()]);
+    return encrypted;
+}
+
+// The UDP receive callback before the packet pool
+static std::unique_ptr<AudioStreamPacket> CopyDecrypt(mbedtls_aes_context& aes, const std::string& data) {
+    size_t decrypted_size = data.size() - kNonce.size();
+    uint8_t nonce_counter[16];
+    memcpy(nonce_counter, data.data(), sizeof(nonce_counter));
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    auto packet = std::unique_ptr<AudioStreamPacket>(new AudioStreamPacket());
+    packet->payload.resize(decrypted_size);
+    mbedtls_aes_crypt_ctr(&aes, decrypted_size, &nc_off, nonce_counter, stream_block,
+        (const uint8_t*)data.data() + kNonce.size(), packet->payload.data());
+    return packet;
+}
+
+static BenchResult Finish(Clock::duration elapsed, size_t allocations, int frames, bool frames_valid) {
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return { frames * 1e9 / ns, ns / frames, (double)allocations / frames, frames_valid };
+}
+
+// Encrypts every frame, the datagrams are kept aside to check the receive direction
+static BenchResult RunSend(bool copy, int frames, std::vector<std::string>& datagrams) {
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, (const unsigned char*)kKey.data(), 128);
+    UdpAudioCipher cipher;
+    cipher.SetKey(kKey, kNonce);
+    auto packet = AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink);
+    // Grow the datagram buffer to the largest frame like a running uplink
+    packet->payload.assign(AUDIO_STREAM_PACKET_HEADROOM + 256, 0);
+    packet->headroom = AUDIO_STREAM_PACKET_HEADROOM;
+    cipher.Encrypt(*packet, 0);
+
+    datagrams.clear();
+    bool frames_valid = true;
+    Clock::duration elapsed{};
+    size_t allocations = 0;
+    for (int i = 0; i < frames; i++) {
+        const auto& opus = opus_frames[i % opus_frames.size()];
+        packet->timestamp = i * 60;
+        packet->headroom = AUDIO_STREAM_PACKET_HEADROOM;
+        packet->payload.resize(packet->headroom + opus.size());
+        memcpy(packet->payload.data() + packet->headroom, opus.data(), opus.size());
+
+        size_t allocations_before = AllocationCount();
+        auto start = Clock::now();
+        size_t datagram_size;
+        if (copy) {
+            // The string is sent and dropped before the next frame
+            std::string datagram = CopyEncrypt(aes, *packet, i + 1);
+            datagram_size = datagram.size();
+            elapsed += Clock::now() - start;
+            allocations += AllocationCount() - allocations_before;
+            if (i < (int)opus_frames.size()) {
+                datagrams.push_back(datagram);
+            }
+        } else {
+            auto datagram = cipher.Encrypt(*packet, i + 1);
+            datagram_size = datagram ? datagram->size() : 0;
+            elapsed += Clock::now() - start;
+            allocations += AllocationCount() - allocations_before;
+            if (datagram && i < (int)opus_frames.size()) {
+                datagrams.push_back(*datagram);
+            }
+        }
+        frames_valid &= datagram_size == MQTT_UDP_NONCE_SIZE + opus.size();
+    }
+    mbedtls_aes_free(&aes);
+    return Finish(elapsed, allocations, frames, frames_valid);
+}
+
+// Decrypts the datagrams of RunSend, the payloads must be the original frames
+static BenchResult RunReceive(bool copy, int frames, const std::vector<std::string>& datagrams) {
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, (const unsigned char*)kKey.data(), 128);
+    UdpAudioCipher cipher;
+    cipher.SetKey(kKey, kNonce);
+    // Warm the pool like a running downlink
+    AudioStreamPacket::Acquire()->payload.reserve(256);
+
+    bool frames_valid = datagrams.size() == std::min<size_t>(frames, opus_frames.size());
+    Clock::duration elapsed{};
+    size_t allocations = 0;
+    for (int i = 0; i < frames && frames_valid; i++) {
+        const auto& datagram = datagrams[i % datagrams.size()];
+        const auto& opus = opus_frames[i % datagrams.size()];
+        size_t allocations_before = AllocationCount();
+        auto start = Clock::now();
+        std::unique_ptr<AudioStreamPacket> packet;
+        if (copy) {
+            packet = CopyDecrypt(aes, datagram);
+        } else {
+            packet = AudioStreamPacket::Acquire();
+            frames_valid &= cipher.Decrypt(datagram, *packet);
+        }
+        elapsed += Clock::now() - start;
+        allocations += AllocationCount() - allocations_before;
+        frames_valid &= packet->PayloadSize() == opus.size() && memcmp(packet->PayloadData(), opus.data(), opus.size()) == 0;
+    }
+    mbedtls_aes_free(&aes);
+    return Finish(elapsed, allocations, frames, frames_valid);
+}
+
+static void Print(const char* direction, const char* mode, const BenchResult& result) {
+    printf("%-9s %-7s %14.0f %10.1f %12.2f\n", direction, mode, result.packets_per_second, result.ns_per_frame,
+        result.allocations_per_frame);
+}
+
+int main(int argc, char** argv) {
+    int frames = 100000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        }
+    }
+    if (frames <= 0) {
+        fprintf(stderr, "Usage: %s [--frames N]\n", argv[0]);
+        return 1;
+    }
+    if (!CheckTestVector()) {
+        fprintf(stderr, "FAILED: the host mbedtls does not match the AES-CTR test vector\n");
+        return 1;
+    }
+
+    MakeOpusFrames();
+    bool ok = true;
+    printf("%d frames of 120-180 bytes:\n", frames);
+    printf("%-9s %-7s %14s %10s %12s\n", "direction", "mode", "packets/s", "ns/frame", "allocations");
+    for (bool copy : { true, false }) {
+        const char* mode = copy ? "copy" : "cipher";
+        std::vector<std::string> datagrams;
+        auto send = RunSend(copy, frames, datagrams);
+        auto receive = RunReceive(copy, frames, datagrams);
+        Print("send", mode, send);
+        Print("receive", mode, receive);
+        ok &= send.frames_valid && receive.frames_valid;
+        // The cipher reuses its datagram buffer and the pooled packets
+        if (!copy) {
+            ok &= send.allocations_per_frame == 0 && receive.allocations_per_frame == 0;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "FAILED: a datagram did not decrypt to its frame, or the cipher allocated\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Framing benchmark for the WebSocket audio uplink.
+ *
+ * Frames the same Opus-sized packets for binary protocol versions 1, 2 and 3 three ways:
+ *   - copy:     a std::string of header + payload for every frame, like
+ *               WebsocketProtocol::SendAudio before the headroom (version 1 sent the payload);
+ *   - headroom: FrameBinaryProtocol on encoder packets, the header goes in the headroom;
+ *   - reframe:  FrameBinaryProtocol on packets without headroom (wake word audio), copied once.
+ * It prints the payload bytes copied, the allocations and the time per frame. A frame that does
+ * not point into the packet's payload buffer counts as one copy of the payload. The time per
+ * frame includes two clock reads.
+ */
+#include "protocol.h"
+#include "alloc_counter.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum FramingMode {
+    kFramingCopy,
+    kFramingHeadroom,
+    kFramingReframe,
+};
+
+static const char* const kModeNames[] = { "copy", "headroom", "reframe" };
+
+struct BenchResult {
+    double bytes_copied_per_frame;
+    double allocations_per_frame;
+    double ns_per_frame;
+    bool frames_valid;
+};
+
+// WebsocketProtocol::SendAudio before the headroom, returns the frame handed to the WebSocket
+static const uint8_t* CopyFrame(const AudioStreamPacket& packet, int version, std::string& serialized, size_t* frame_size) {
+    if (version == 2) {
+        serialized.resize(sizeof(BinaryProtocol2) + packet.payload.size());
+        auto bp2 = (BinaryProtocol2*)serialized.data();
+        bp2->version = htons(version);
+        bp2->type = 0;
+        bp2->reserved = 0;
+        bp2->timestamp = htonl(packet.timestamp);
+        bp2->payload_size = htonl(packet.payload.size());
+        memcpy(bp2->payload, packet.payload.data(), packet.payload.size());
+    } else if (version == 3) {
+        serialized.resize(sizeof(BinaryProtocol3) + packet.payload.size());
+        auto bp3 = (BinaryProtocol3*)serialized.data();
+        bp3->type = 0;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(packet.payload.size());
+        memcpy(bp3->payload, packet.payload.data(), packet.payload.size());
+    } else {
+        *frame_size = packet.payload.size();
+        return packet.payload.data();
+    }
+    *frame_size = serialized.size();
+    return (const uint8_t*)serialized.data();
+}
+
+// The receive side's view of a frame: the header and the payload must match the packet
+static bool CheckFrame(const uint8_t* frame, size_t frame_size, int version, uint32_t timestamp, const std::vector<uint8_t>& opus) {
+    size_t header_size = 0;
+    if (version == 2) {
+        auto bp2 = (const BinaryProtocol2*)frame;
+        header_size = sizeof(BinaryProtocol2);
+        if (ntohs(bp2->version) != 2 || bp2->type != 0 || ntohl(bp2->timestamp) != timestamp ||
+            ntohl(bp2->payload_size) != opus.size()) {
+            return false;
+        }
+    } else if (version == 3) {
+        auto bp3 = (const BinaryProtocol3*)frame;
+        header_size = sizeof(BinaryProtocol3);
+        if (bp3->type != 0 || ntohs(bp3->payload_size) != opus.size()) {
+            return false;
+        }
+    }
+    return frame_size == header_size + opus.size() && memcmp(frame + header_size, opus.data(), opus.size()) == 0;
+}
+
+static std::vector<std::vector<uint8_t>> opus_frames;
+
+// 60 ms Opus frames between 16 and 24 kbps, like the encoder output
+static void MakeOpusFrames() {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> frame_bytes(120, 180);
+    opus_frames.resize(64);
+    for (auto& opus : opus_frames) {
+        opus.resize(frame_bytes(random));
+        for (auto& byte : opus) {
+            byte = (uint8_t)random();
+        }
+    }
+}
+
+static BenchResult Run(FramingMode mode, int version, int frames) {
+    // Warm the pool, the packets keep their payload capacity
+    {
+        std::vector<std::unique_ptr<AudioStreamPacket>> packets;
+        for (int i = 0; i < 4; i++) {
+            packets.push_back(AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink));
+            packets.back()->payload.reserve(AUDIO_STREAM_PACKET_HEADROOM + 256);
+        }
+    }
+
+    uint64_t bytes_copied = 0;
+    bool frames_valid = true;
+    Clock::duration elapsed{};
+    size_t allocations = 0;
+    for (int i = 0; i < frames; i++) {
+        const auto& opus = opus_frames[i % opus_frames.size()];
+        auto packet = AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink);
+        packet->timestamp = i * 60;
+        // What the encoder leaves in the packet; the old encoder wrote the payload from offset 0
+        packet->headroom = mode == kFramingHeadroom ? AUDIO_STREAM_PACKET_HEADROOM : 0;
+        packet->payload.resize(packet->headroom + opus.size());
+        memcpy(packet->payload.data() + packet->headroom, opus.data(), opus.size());
+        const uint8_t* buffer = packet->payload.data();
+        const uint8_t* buffer_end = buffer + packet->payload.size();
+
+        // The old code built a new string for every frame
+        std::string serialized;
+        size_t frame_size;
+        const uint8_t* frame;
+        size_t allocations_before = AllocationCount();
+        auto start = Clock::now();
+        if (mode == kFramingCopy) {
+            frame = CopyFrame(*packet, version, serialized, &frame_size);
+        } else {
+            frame = FrameBinaryProtocol(*packet, version, &frame_size);
+        }
+        elapsed += Clock::now() - start;
+        allocations += AllocationCount() - allocations_before;
+
+        if (frame < buffer || frame + frame_size > buffer_end) {
+            bytes_copied += opus.size();
+        }
+        frames_valid &= CheckFrame(frame, frame_size, version, packet->timestamp, opus);
+    }
+    return {
+        (double)bytes_copied / frames,
+        (double)allocations / frames,
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / frames,
+        frames_valid,
+    };
+}
+
+int main(int argc, char** argv) {
+    int frames = 100000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        }
+    }
+    if (frames <= 0) {
+        fprintf(stderr, "Usage: %s [--frames N]\n", argv[0]);
+        return 1;
+    }
+
+    MakeOpusFrames();
+    bool ok = true;
+    printf("%d frames of 120-180 bytes, per frame:\n", frames);
+    printf("%-8s %-9s %14s %12s %10s\n", "version", "framing", "bytes copied", "allocations", "ns");
+    for (int version : { 1, 2, 3 }) {
+        for (auto mode : { kFramingCopy, kFramingHeadroom, kFramingReframe }) {
+            auto result = Run(mode, version, frames);
+            printf("%-8d %-9s %14.1f %12.2f %10.1f\n", version, kModeNames[mode], result.bytes_copied_per_frame,
+                result.allocations_per_frame, result.ns_per_frame);
+            ok &= result.frames_valid;
+            // Encoder packets are framed without copying or allocating
+            if (mode == kFramingHeadroom) {
+                ok &= result.bytes_copied_per_frame == 0 && result.allocations_per_frame == 0;
+            }
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "FAILED: a frame did not decode, or the headroom framing copied or allocated\n");
+        return 1;
+    }
+    return 0;
+}
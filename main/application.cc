@@ -74,9 +74,12 @@ void Application::Initialize() {
     audio_service_.Initialize(codec);
     audio_service_.Start();
 
+    // Start the audio send task before the send queue can be filled
+    audio_sender_.Start(AUDIO_SEND_TASK_PRIORITY, AUDIO_SEND_TASK_CORE);
+
     AudioServiceCallbacks callbacks;
     callbacks.on_send_queue_available = [this]() {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+        audio_sender_.Notify();
     };
     callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
         xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
@@ -84,6 +87,10 @@ void Application::Initialize() {
     callbacks.on_vad_change = [this](bool speaking) {
         xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
     };
+    callbacks.on_audio_testing_queue_full = [this]() {
+        // Handled like a button release: stop audio testing and play the recording
+        StopListening();
+    };
     audio_service_.SetCallbacks(callbacks);
 
     // Add state change listeners
@@ -94,6 +101,11 @@ void Application::Initialize() {
     // Start the clock timer to update the status bar
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
 
+#if CONFIG_USE_TIMER_LATENCY_MONITOR
+    timer_latency_monitor_ = std::make_unique<TimerLatencyMonitor>();
+    timer_latency_monitor_->Start();
+#endif
+
     // Add MCP common tools (only once during initialization)
     auto& mcp_server = McpServer::GetInstance();
     mcp_server.AddCommonTools();
@@ -169,7 +181,6 @@ void Application::Run() {
 
     const EventBits_t ALL_EVENTS = 
         MAIN_EVENT_SCHEDULE |
-        MAIN_EVENT_SEND_AUDIO |
         MAIN_EVENT_WAKE_WORD_DETECTED |
         MAIN_EVENT_VAD_CHANGE |
         MAIN_EVENT_CLOCK_TICK |
@@ -218,14 +229,6 @@ void Application::Run() {
             HandleStopListeningEvent();
         }
 
-        if (bits & MAIN_EVENT_SEND_AUDIO) {
-            while (auto packet = audio_service_.PopPacketFromSendQueue()) {
-                if (protocol_ && !protocol_->SendAudio(std::move(packet))) {
-                    break;
-                }
-            }
-        }
-
         if (bits & MAIN_EVENT_WAKE_WORD_DETECTED) {
             HandleWakeWordDetectedEvent();
         }
@@ -238,11 +241,9 @@ void Application::Run() {
         }
 
         if (bits & MAIN_EVENT_SCHEDULE) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
+            // Tasks left over after their class used its budget run after the other events are handled
+            if (scheduler_.RunPending()) {
+                xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
             }
         }
 
@@ -254,6 +255,11 @@ void Application::Run() {
             // Print debug info every 10 seconds
             if (clock_ticks_ % 10 == 0) {
                 SystemInfo::PrintHeapStats();
+                audio_service_.PrintDebugStatistics();
+                scheduler_.PrintStatistics();
+                if (timer_latency_monitor_) {
+                    timer_latency_monitor_->Print();
+                }
             }
         }
     }
@@ -485,13 +491,14 @@ void Application::InitializeProtocol() {
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
 
     if (ota_->HasMqttConfig()) {
-        protocol_ = std::make_unique<MqttProtocol>();
+        protocol_ = std::make_shared<MqttProtocol>();
     } else if (ota_->HasWebsocketConfig()) {
-        protocol_ = std::make_unique<WebsocketProtocol>();
+        protocol_ = std::make_shared<WebsocketProtocol>();
     } else {
         ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
-        protocol_ = std::make_unique<MqttProtocol>();
+        protocol_ = std::make_shared<MqttProtocol>();
     }
+    audio_sender_.SetProtocol(protocol_);
 
     protocol_->OnConnected([this]() {
         DismissAlert();
@@ -510,6 +517,7 @@ void Application::InitializeProtocol() {
     
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
         board.SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
+        audio_service_.SetUplinkAudioParams(protocol_->uplink_frame_duration(), protocol_->uplink_bitrate());
         if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                 protocol_->server_sample_rate(), codec->output_sample_rate());
@@ -522,20 +530,18 @@ void Application::InitializeProtocol() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
-        });
+        }, kSchedulePriorityState);
     });
     
-    protocol_->OnIncomingJson([this, display](const cJSON* root) {
-        // Parse JSON data
-        auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
-            auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
+    protocol_->OnIncomingMessage([this, display](const IncomingMessage& message) {
+        switch (message.type) {
+        case kIncomingMessageTts:
+            if (message.tts_state == kTtsStateStart) {
                 Schedule([this]() {
                     aborted_ = false;
                     SetDeviceState(kDeviceStateSpeaking);
-                });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
+                }, kSchedulePriorityState);
+            } else if (message.tts_state == kTtsStateStop) {
                 Schedule([this]() {
                     if (GetDeviceState() == kDeviceStateSpeaking) {
                         if (listening_mode_ == kListeningModeManualStop) {
@@ -544,72 +550,78 @@ void Application::InitializeProtocol() {
                             SetDeviceState(kDeviceStateListening);
                         }
                     }
+                }, kSchedulePriorityState);
+            } else if (message.tts_state == kTtsStateSentenceStart && message.text.present()) {
+                auto text = message.text.ToString();
+                ESP_LOGI(TAG, "<< %s", text.c_str());
+                Schedule([display, text = std::move(text)]() {
+                    display->SetChatMessage("assistant", text.c_str());
                 });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (cJSON_IsString(text)) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
-                }
             }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
-            auto text = cJSON_GetObjectItem(root, "text");
-            if (cJSON_IsString(text)) {
-                ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
+            break;
+        case kIncomingMessageStt:
+            if (message.text.present()) {
+                auto text = message.text.ToString();
+                ESP_LOGI(TAG, ">> %s", text.c_str());
+                Schedule([display, text = std::move(text)]() {
+                    display->SetChatMessage("user", text.c_str());
                 });
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(emotion)) {
-                Schedule([display, emotion_str = std::string(emotion->valuestring)]() {
+            break;
+        case kIncomingMessageLlm:
+            if (message.emotion.present()) {
+                Schedule([display, emotion_str = message.emotion.ToString()]() {
                     display->SetEmotion(emotion_str.c_str());
                 });
             }
-        } else if (strcmp(type->valuestring, "mcp") == 0) {
-            auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
-                McpServer::GetInstance().ParseMessage(payload);
+            break;
+        case kIncomingMessageMcp:
+            // MCP requests carry nested params, they still get a cJSON tree of the payload alone
+            if (message.payload_is_object()) {
+                auto payload = cJSON_ParseWithLength(message.payload.data(), message.payload.size());
+                if (payload != nullptr) {
+                    McpServer::GetInstance().ParseMessage(payload);
+                    cJSON_Delete(payload);
+                }
             }
-        } else if (strcmp(type->valuestring, "system") == 0) {
-            auto command = cJSON_GetObjectItem(root, "command");
-            if (cJSON_IsString(command)) {
-                ESP_LOGI(TAG, "System command: %s", command->valuestring);
-                if (strcmp(command->valuestring, "reboot") == 0) {
+            break;
+        case kIncomingMessageSystem:
+            if (message.command.present()) {
+                auto command = message.command.ToString();
+                ESP_LOGI(TAG, "System command: %s", command.c_str());
+                if (message.command.Equals("reboot")) {
                     // Do a reboot if user requests a OTA update
                     Schedule([this]() {
                         Reboot();
-                    });
+                    }, kSchedulePriorityState);
                 } else {
-                    ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
+                    ESP_LOGW(TAG, "Unknown system command: %s", command.c_str());
                 }
             }
-        } else if (strcmp(type->valuestring, "alert") == 0) {
-            auto status = cJSON_GetObjectItem(root, "status");
-            auto message = cJSON_GetObjectItem(root, "message");
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(status) && cJSON_IsString(message) && cJSON_IsString(emotion)) {
-                Alert(status->valuestring, message->valuestring, emotion->valuestring, Lang::Sounds::OGG_VIBRATION);
+            break;
+        case kIncomingMessageAlert:
+            if (message.status.present() && message.message.present() && message.emotion.present()) {
+                Alert(message.status.ToString().c_str(), message.message.ToString().c_str(),
+                    message.emotion.ToString().c_str(), Lang::Sounds::OGG_VIBRATION);
             } else {
                 ESP_LOGW(TAG, "Alert command requires status, message and emotion");
             }
+            break;
 #if CONFIG_RECEIVE_CUSTOM_MESSAGE
-        } else if (strcmp(type->valuestring, "custom") == 0) {
-            auto payload = cJSON_GetObjectItem(root, "payload");
-            ESP_LOGI(TAG, "Received custom message: %s", cJSON_PrintUnformatted(root));
-            if (cJSON_IsObject(payload)) {
-                Schedule([this, display, payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
+        case kIncomingMessageCustom:
+            ESP_LOGI(TAG, "Received custom message: %.*s", (int)message.json.size(), message.json.data());
+            if (message.payload_is_object()) {
+                Schedule([this, display, payload_str = std::string(message.payload)]() {
                     display->SetChatMessage("system", payload_str.c_str());
                 });
             } else {
                 ESP_LOGW(TAG, "Invalid custom message format: missing payload");
             }
+            break;
 #endif
-        } else {
-            ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
+        default:
+            ESP_LOGW(TAG, "Unknown message type: %.*s", (int)message.type_name.raw.size(), message.type_name.raw.data());
+            break;
         }
     });
     
@@ -706,7 +718,7 @@ void Application::HandleToggleChatEvent() {
             // Schedule to let the state change be processed first (UI update)
             Schedule([this, mode]() {
                 ContinueOpenAudioChannel(mode);
-            });
+            }, kSchedulePriorityAudio);
             return;
         }
         SetListeningMode(mode);
@@ -755,7 +767,7 @@ void Application::HandleStartListeningEvent() {
             // Schedule to let the state change be processed first (UI update)
             Schedule([this]() {
                 ContinueOpenAudioChannel(kListeningModeManualStop);
-            });
+            }, kSchedulePriorityAudio);
             return;
         }
         SetListeningMode(kListeningModeManualStop);
@@ -797,7 +809,7 @@ void Application::HandleWakeWordDetectedEvent() {
             // then continue with OpenAudioChannel which may block for ~1 second
             Schedule([this, wake_word]() {
                 ContinueWakeWordInvoke(wake_word);
-            });
+            }, kSchedulePriorityAudio);
             return;
         }
         // Channel already opened, continue directly
@@ -907,14 +919,6 @@ void Application::HandleStateChangedEvent() {
     }
 }
 
-void Application::Schedule(std::function<void()>&& callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
-    }
-    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
-}
-
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
@@ -934,6 +938,7 @@ void Application::Reboot() {
     if (protocol_ && protocol_->IsAudioChannelOpened()) {
         protocol_->CloseAudioChannel();
     }
+    audio_sender_.SetProtocol(nullptr);
     protocol_.reset();
     audio_service_.Stop();
 
@@ -1008,7 +1013,7 @@ void Application::WakeWordInvoke(const std::string& wake_word) {
             // Schedule to let the state change be processed first (UI update)
             Schedule([this, wake_word]() {
                 ContinueWakeWordInvoke(wake_word);
-            });
+            }, kSchedulePriorityAudio);
             return;
         }
         // Channel already opened, continue directly
@@ -1016,13 +1021,13 @@ void Application::WakeWordInvoke(const std::string& wake_word) {
     } else if (state == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
-        });
+        }, kSchedulePriorityAudio);
     } else if (state == kDeviceStateListening) {   
         Schedule([this]() {
             if (protocol_) {
                 protocol_->CloseAudioChannel();
             }
-        });
+        }, kSchedulePriorityAudio);
     }
 }
 
@@ -1049,7 +1054,7 @@ void Application::SendMcpMessage(const std::string& payload) {
         if (protocol_) {
             protocol_->SendMcpMessage(payload);
         }
-    });
+    }, kSchedulePriorityMcp);
 }
 
 void Application::SetAecMode(AecMode mode) {
@@ -1076,7 +1081,7 @@ void Application::SetAecMode(AecMode mode) {
         if (protocol_ && protocol_->IsAudioChannelOpened()) {
             protocol_->CloseAudioChannel();
         }
-    });
+    }, kSchedulePriorityAudio);
 }
 
 void Application::PlaySound(const std::string_view& sound) {
@@ -1089,8 +1094,9 @@ void Application::ResetProtocol() {
         if (protocol_ && protocol_->IsAudioChannelOpened()) {
             protocol_->CloseAudioChannel();
         }
-        // Reset protocol
+        // Reset protocol, the audio sender may still finish its current packets with it
+        audio_sender_.SetProtocol(nullptr);
         protocol_.reset();
-    });
+    }, kSchedulePriorityAudio);
 }
 
@@ -8,7 +8,6 @@
 
 #include <string>
 #include <mutex>
-#include <deque>
 #include <memory>
 
 #include "protocol.h"
@@ -16,10 +15,12 @@
 #include "audio_service.h"
 #include "device_state.h"
 #include "device_state_machine.h"
+#include "timer_latency_monitor.h"
+#include "main_task_scheduler.h"
+#include "audio_sender.h"
 
 // Main event bits
 #define MAIN_EVENT_SCHEDULE             (1 << 0)
-#define MAIN_EVENT_SEND_AUDIO           (1 << 1)
 #define MAIN_EVENT_WAKE_WORD_DETECTED   (1 << 2)
 #define MAIN_EVENT_VAD_CHANGE           (1 << 3)
 #define MAIN_EVENT_ERROR                (1 << 4)
@@ -32,6 +33,12 @@
 #define MAIN_EVENT_STOP_LISTENING       (1 << 11)
 #define MAIN_EVENT_STATE_CHANGED        (1 << 12)
 
+// Uplink audio is sent from its own task so that scheduled callbacks, UI updates and MCP tools
+// running in the main loop never delay it. It runs below the audio input task (8) so that a send
+// never preempts capture, and on multi-core chips it is pinned away from it (core 0).
+#define AUDIO_SEND_TASK_PRIORITY 7
+#define AUDIO_SEND_TASK_CORE (portNUM_PROCESSORS > 1 ? portNUM_PROCESSORS - 1 : tskNO_AFFINITY)
+
 
 enum AecMode {
     kAecOff,
@@ -64,6 +71,13 @@ public:
     void Run();
 
     DeviceState GetDeviceState() const { return state_machine_.GetState(); }
+    /**
+     * Register a callback for device state changes
+     * The callback runs in the task that changes the state and must not block
+     */
+    int AddStateChangeListener(DeviceStateMachine::StateCallback callback) {
+        return state_machine_.AddStateChangeListener(std::move(callback));
+    }
     bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
     
     /**
@@ -74,8 +88,14 @@ public:
 
     /**
      * Schedule a callback to be executed in the main task
+     * Higher priority classes run first, tasks of the same class run in order.
+     * The callback is stored without allocation and must fit in MAIN_TASK_INLINE_SIZE.
      */
-    void Schedule(std::function<void()>&& callback);
+    template <typename F>
+    void Schedule(F&& callback, SchedulePriority priority = kSchedulePriorityUi) {
+        scheduler_.Push(priority, MainTask(std::forward<F>(callback)));
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
 
     /**
      * Alert with status, message, emotion and optional sound
@@ -124,9 +144,9 @@ private:
     Application();
     ~Application();
 
-    std::mutex mutex_;
-    std::deque<std::function<void()>> main_tasks_;
-    std::unique_ptr<Protocol> protocol_;
+    MainTaskScheduler scheduler_;
+    // Owned by the main task, the audio sender keeps its own reference while it sends
+    std::shared_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
     DeviceStateMachine state_machine_;
@@ -134,7 +154,9 @@ private:
     AecMode aec_mode_ = kAecOff;
     std::string last_error_message_;
     AudioService audio_service_;
+    AudioSender audio_sender_{audio_service_};
     std::unique_ptr<Ota> ota_;
+    std::unique_ptr<TimerLatencyMonitor> timer_latency_monitor_;
 
     bool has_server_time_ = false;
     bool aborted_ = false;
@@ -1,6 +1,9 @@
 #include "audio_service.h"
+#include "object_pool.h"
+#include "pcm_kernels.h"
 #include <esp_log.h>
 #include <cstring>
+#include <algorithm>
 
 #define RATE_CVT_CFG(_src_rate, _dest_rate, _channel)        \
     (esp_ae_rate_cvt_cfg_t)                                  \
@@ -37,6 +40,26 @@
 
 #define TAG "AudioService"
 
+static ObjectPool<AudioTask, AUDIO_TASK_POOL_SIZE>& GetTaskPool() {
+    static ObjectPool<AudioTask, AUDIO_TASK_POOL_SIZE> pool;
+    return pool;
+}
+
+std::unique_ptr<AudioTask> AudioTask::Acquire() {
+    return GetTaskPool().Acquire();
+}
+
+void AudioTask::Reset() {
+    type = kAudioTaskTypeEncodeToSendQueue;
+    pcm.clear();
+    timestamp = 0;
+    enqueue_time_us = 0;
+}
+
+void AudioTask::operator delete(AudioTask* task, std::destroying_delete_t) {
+    GetTaskPool().Release(task);
+}
+
 AudioService::AudioService() {
     event_group_ = xEventGroupCreate();
 }
@@ -72,16 +95,7 @@ void AudioService::Initialize(AudioCodec* codec) {
         decoder_duration_ms_ = OPUS_FRAME_DURATION_MS;
         decoder_frame_size_ = decoder_sample_rate_ / 1000 * OPUS_FRAME_DURATION_MS;
     }
-    esp_opus_enc_config_t opus_enc_cfg = AS_OPUS_ENC_CONFIG();
-    ret = esp_opus_enc_open(&opus_enc_cfg, sizeof(esp_opus_enc_config_t), &opus_encoder_);
-    if (opus_encoder_ == nullptr) {
-        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", ret);
-    } else {
-        encoder_sample_rate_ = 16000;
-        encoder_duration_ms_ = OPUS_FRAME_DURATION_MS;
-        esp_opus_enc_get_frame_size(opus_encoder_, &encoder_frame_size_, &encoder_outbuf_size_);
-        encoder_frame_size_ = encoder_frame_size_ / sizeof(int16_t);
-    }
+    ConfigureEncoder(OPUS_FRAME_DURATION_MS, 0, false);
 
     if (codec->input_sample_rate() != 16000) {
         esp_ae_rate_cvt_cfg_t input_resampler_cfg = RATE_CVT_CFG(
@@ -98,8 +112,34 @@ void AudioService::Initialize(AudioCodec* codec) {
     audio_processor_ = std::make_unique<NoAudioProcessor>();
 #endif
 
-    audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
-        PushTaskToEncodeQueue(kAudioTaskTypeEncodeToSendQueue, std::move(data));
+    audio_processor_->OnOutput([this](const std::vector<int16_t>& data) {
+        /* Join the processor output into frames of the negotiated uplink duration */
+        size_t frame_size = encoder_frame_size_.load();
+        if (frame_size == 0) {
+            return;
+        }
+        /* Samples joined for the previous frame size would make a frame of the wrong size */
+        if (frame_size != uplink_frame_buffer_size_) {
+            uplink_frame_buffer_.clear();
+            uplink_frame_buffer_size_ = frame_size;
+        }
+        if (uplink_frame_buffer_.empty() && data.size() == frame_size) {
+            PushTaskToEncodeQueue(kAudioTaskTypeEncodeToSendQueue, data);
+            return;
+        }
+        size_t offset = 0;
+        while (offset < data.size()) {
+            if (uplink_frame_buffer_.size() >= frame_size) {
+                uplink_frame_buffer_.clear();
+            }
+            size_t n = std::min(frame_size - uplink_frame_buffer_.size(), data.size() - offset);
+            uplink_frame_buffer_.insert(uplink_frame_buffer_.end(), data.begin() + offset, data.begin() + offset + n);
+            offset += n;
+            if (uplink_frame_buffer_.size() >= frame_size) {
+                PushTaskToEncodeQueue(kAudioTaskTypeEncodeToSendQueue, uplink_frame_buffer_);
+                uplink_frame_buffer_.clear();
+            }
+        }
     });
 
     audio_processor_->OnVadStateChange([this](bool speaking) {
@@ -120,6 +160,13 @@ void AudioService::Initialize(AudioCodec* codec) {
         .skip_unhandled_events = true,
     };
     esp_timer_create(&audio_power_timer_args, &audio_power_timer_);
+
+#if CONFIG_USE_AUDIO_PROFILER
+    audio_profiler_ = std::make_unique<AudioProfiler>();
+#endif
+#if CONFIG_USE_AUDIO_JITTER_BUFFER
+    jitter_buffer_ = std::make_unique<JitterBuffer>();
+#endif
 }
 
 void AudioService::Start() {
@@ -171,14 +218,20 @@ void AudioService::Stop() {
     service_stopped_ = true;
     xEventGroupSetBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING |
         AS_EVENT_WAKE_WORD_RUNNING |
-        AS_EVENT_AUDIO_PROCESSOR_RUNNING);
-
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-    audio_encode_queue_.clear();
-    audio_decode_queue_.clear();
-    audio_playback_queue_.clear();
-    audio_testing_queue_.clear();
-    audio_queue_cv_.notify_all();
+        AS_EVENT_AUDIO_PROCESSOR_RUNNING |
+        AS_EVENT_ENCODE_QUEUE_AVAILABLE |
+        AS_EVENT_DECODE_QUEUE_AVAILABLE |
+        AS_EVENT_PLAYBACK_QUEUE_DRAINED);
+
+    audio_encode_queue_.Clear();
+    audio_decode_queue_.Clear();
+    audio_playback_queue_.Clear();
+    audio_testing_queue_.Clear();
+    if (jitter_buffer_) {
+        jitter_buffer_->Reset();
+    }
+    NotifyTask(opus_codec_task_handle_);
+    NotifyTask(audio_output_task_handle_);
 }
 
 bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples) {
@@ -188,22 +241,26 @@ bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, in
         codec_->EnableInput(true);
     }
 
+    int64_t start_time = esp_timer_get_time();
     if (codec_->input_sample_rate() != sample_rate) {
-        data.resize(samples * codec_->input_sample_rate() / sample_rate * codec_->input_channels());
-        if (!codec_->InputData(data)) {
+        /* Read at the codec rate into the capture buffer and resample straight into the caller's buffer */
+        std::lock_guard<std::mutex> lock(input_resampler_mutex_);
+        auto& raw = input_capture_buffer_;
+        raw.resize(samples * codec_->input_sample_rate() / sample_rate * codec_->input_channels());
+        if (!codec_->InputData(raw)) {
             return false;
         }
         if (input_resampler_ != nullptr) {
-            std::lock_guard<std::mutex> lock(input_resampler_mutex_);
-            uint32_t in_sample_num = data.size() / codec_->input_channels();
+            uint32_t in_sample_num = raw.size() / codec_->input_channels();
             uint32_t output_samples = 0;
             esp_ae_rate_cvt_get_max_out_sample_num(input_resampler_, in_sample_num, &output_samples);
-            auto resampled = std::vector<int16_t>(output_samples * codec_->input_channels());
+            data.resize(output_samples * codec_->input_channels());
             uint32_t actual_output = output_samples;
-            esp_ae_rate_cvt_process(input_resampler_, (esp_ae_sample_t)data.data(), in_sample_num,
-                                   (esp_ae_sample_t)resampled.data(), &actual_output);
-            resampled.resize(actual_output * codec_->input_channels());
-            data = std::move(resampled);
+            esp_ae_rate_cvt_process(input_resampler_, (esp_ae_sample_t)raw.data(), in_sample_num,
+                                   (esp_ae_sample_t)data.data(), &actual_output);
+            data.resize(actual_output * codec_->input_channels());
+        } else {
+            data.assign(raw.begin(), raw.end());
         }
     } else {
         data.resize(samples * codec_->input_channels());
@@ -215,6 +272,9 @@ bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, in
     /* Update the last input time */
     last_input_time_ = std::chrono::steady_clock::now();
     debug_statistics_.input_count++;
+    if (audio_profiler_) {
+        audio_profiler_->RecordLatency(kAudioProfilerStageInput, esp_timer_get_time() - start_time);
+    }
 
 #if CONFIG_USE_AUDIO_DEBUGGER
     // 音频调试：发送原始音频数据
@@ -244,30 +304,32 @@ void AudioService::AudioInputTask() {
 
         /* Used for audio testing in NetworkConfiguring mode by clicking the BOOT button */
         if (bits & AS_EVENT_AUDIO_TESTING_RUNNING) {
-            if (audio_testing_queue_.size() >= AUDIO_TESTING_MAX_DURATION_MS / OPUS_FRAME_DURATION_MS) {
+            if (audio_testing_queue_.Size() * encoder_duration_ms_ >= AUDIO_TESTING_MAX_DURATION_MS) {
                 ESP_LOGW(TAG, "Audio testing queue is full, stopping audio testing");
-                EnableAudioTesting(false);
+                /* Stop recording here, the main task stops the test and starts the replay */
+                xEventGroupClearBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING);
+                if (callbacks_.on_audio_testing_queue_full) {
+                    callbacks_.on_audio_testing_queue_full();
+                }
                 continue;
             }
-            std::vector<int16_t> data;
-            int samples = OPUS_FRAME_DURATION_MS * 16000 / 1000;
+            auto& data = capture_buffer_;
+            int samples = encoder_duration_ms_ * 16000 / 1000;
             if (ReadAudioData(data, 16000, samples)) {
-                // If input channels is 2, we need to fetch the left channel data
+                // If input channels is 2, we need to fetch the left channel data, in place
                 if (codec_->input_channels() == 2) {
-                    auto mono_data = std::vector<int16_t>(data.size() / 2);
-                    for (size_t i = 0, j = 0; i < mono_data.size(); ++i, j += 2) {
-                        mono_data[i] = data[j];
-                    }
-                    data = std::move(mono_data);
+                    size_t mono_samples = data.size() / 2;
+                    PcmExtractChannel(data.data(), data.data(), mono_samples, 2, 0);
+                    data.resize(mono_samples);
                 }
-                PushTaskToEncodeQueue(kAudioTaskTypeEncodeToTestingQueue, std::move(data));
+                PushTaskToEncodeQueue(kAudioTaskTypeEncodeToTestingQueue, data);
                 continue;
             }
         }
 
         /* Feed the wake word */
         if (bits & AS_EVENT_WAKE_WORD_RUNNING) {
-            std::vector<int16_t> data;
+            auto& data = capture_buffer_;
             int samples = wake_word_->GetFeedSize();
             if (samples > 0) {
                 if (ReadAudioData(data, 16000, samples)) {
@@ -279,17 +341,17 @@ void AudioService::AudioInputTask() {
 
         /* Feed the audio processor */
         if (bits & AS_EVENT_AUDIO_PROCESSOR_RUNNING) {
-            std::vector<int16_t> data;
+            auto& data = capture_buffer_;
             int samples = audio_processor_->GetFeedSize();
             if (samples > 0) {
                 if (ReadAudioData(data, 16000, samples)) {
-                    audio_processor_->Feed(std::move(data));
+                    audio_processor_->Feed(data);
                     continue;
                 }
             }
         }
 
-        ESP_LOGE(TAG, "Should not be here, bits: %lx", bits);
+        ESP_LOGE(TAG, "Should not be here, bits: %lx", (unsigned long)bits);
         break;
     }
 
@@ -298,23 +360,32 @@ void AudioService::AudioInputTask() {
 
 void AudioService::AudioOutputTask() {
     while (true) {
-        std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-        audio_queue_cv_.wait(lock, [this]() { return !audio_playback_queue_.empty() || service_stopped_; });
+        std::unique_ptr<AudioTask> task;
+        while (!service_stopped_ && !audio_playback_queue_.Pop(task)) {
+            if (audio_playback_queue_.Empty()) {
+                xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_QUEUE_DRAINED);
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
         if (service_stopped_) {
             break;
         }
-
-        auto task = std::move(audio_playback_queue_.front());
-        audio_playback_queue_.pop_front();
-        audio_queue_cv_.notify_all();
-        lock.unlock();
+        /* A slot in the playback queue is free, let the codec task decode the next packet */
+        NotifyTask(opus_codec_task_handle_);
 
         if (!codec_->output_enabled()) {
             esp_timer_stop(audio_power_timer_);
             esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
             codec_->EnableOutput(true);
         }
+        int64_t start_time = esp_timer_get_time();
+        if (audio_profiler_) {
+            audio_profiler_->RecordLatency(kAudioProfilerStagePlaybackQueue, start_time - task->enqueue_time_us);
+        }
         codec_->OutputData(task->pcm);
+        if (audio_profiler_) {
+            audio_profiler_->RecordLatency(kAudioProfilerStageOutput, esp_timer_get_time() - start_time);
+        }
 
         /* Update the last output time */
         last_output_time_ = std::chrono::steady_clock::now();
@@ -323,7 +394,7 @@ void AudioService::AudioOutputTask() {
 #if CONFIG_USE_SERVER_AEC
         /* Record the timestamp for server AEC */
         if (task->timestamp > 0) {
-            lock.lock();
+            std::lock_guard<std::mutex> lock(timestamp_queue_mutex_);
             timestamp_queue_.push_back(task->timestamp);
         }
 #endif
@@ -333,36 +404,48 @@ void AudioService::AudioOutputTask() {
 }
 
 void AudioService::OpusCodecTask() {
-    while (true) {
-        std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-        audio_queue_cv_.wait(lock, [this]() {
-            return service_stopped_ ||
-                (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) ||
-                (!audio_decode_queue_.empty() && audio_playback_queue_.size() < MAX_PLAYBACK_TASKS_IN_QUEUE);
-        });
-        if (service_stopped_) {
-            break;
+    while (!service_stopped_) {
+        bool processed = false;
+
+        /* Decode the audio from decode queue, or from the jitter buffer for sequenced packets */
+        std::unique_ptr<AudioStreamPacket> opus_packet;
+        auto frame_recover = ESP_AUDIO_DEC_RECOVERY_NONE;
+        bool has_packet = false;
+        if (!audio_playback_queue_.Full()) {
+            if (audio_testing_replay_ && !audio_testing_queue_.Pop(opus_packet)) {
+                audio_testing_replay_ = false;
+            }
+            if (opus_packet) {
+                has_packet = true;
+            } else if (audio_decode_queue_.Pop(opus_packet)) {
+                has_packet = true;
+                xEventGroupSetBits(event_group_, AS_EVENT_DECODE_QUEUE_AVAILABLE);
+            } else if (jitter_buffer_) {
+                auto result = jitter_buffer_->Pop(opus_packet, esp_timer_get_time(), audio_playback_queue_.Empty());
+                has_packet = result != kJitterBufferEmpty;
+                if (result == kJitterBufferFec) {
+                    frame_recover = ESP_AUDIO_DEC_RECOVERY_FEC;
+                } else if (result == kJitterBufferPlc) {
+                    frame_recover = ESP_AUDIO_DEC_RECOVERY_PLC;
+                }
+            }
         }
+        if (has_packet) {
+            processed = true;
 
-        /* Decode the audio from decode queue */
-        if (!audio_decode_queue_.empty() && audio_playback_queue_.size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
-            auto packet = std::move(audio_decode_queue_.front());
-            audio_decode_queue_.pop_front();
-            audio_queue_cv_.notify_all();
-            lock.unlock();
-
-            auto task = std::make_unique<AudioTask>();
+            auto task = AudioTask::Acquire();
             task->type = kAudioTaskTypeDecodeToPlaybackQueue;
-            task->timestamp = packet->timestamp;
+            task->timestamp = opus_packet->timestamp;
+            int64_t decode_start_time = esp_timer_get_time();
 
-            SetDecodeSampleRate(packet->sample_rate, packet->frame_duration);
+            SetDecodeSampleRate(opus_packet->sample_rate, opus_packet->frame_duration);
             if (opus_decoder_ != nullptr) {
                 task->pcm.resize(decoder_frame_size_);
                 esp_audio_dec_in_raw_t raw = {
-                    .buffer = (uint8_t *)(packet->payload.data()),
-                    .len = (uint32_t)(packet->payload.size()),
+                    .buffer = (uint8_t *)(opus_packet->PayloadData()),
+                    .len = (uint32_t)(opus_packet->PayloadSize()),
                     .consumed = 0,
-                    .frame_recover = ESP_AUDIO_DEC_RECOVERY_NONE,
+                    .frame_recover = frame_recover,
                 };
                 esp_audio_dec_out_frame_t out_frame = {
                     .buffer = (uint8_t *)(task->pcm.data()),
@@ -378,65 +461,86 @@ void AudioService::OpusCodecTask() {
                     if (decoder_sample_rate_ != codec_->output_sample_rate() && output_resampler_ != nullptr) {
                         uint32_t target_size = 0;
                         esp_ae_rate_cvt_get_max_out_sample_num(output_resampler_, task->pcm.size(), &target_size);
-                        std::vector<int16_t> resampled(target_size);
+                        output_resample_buffer_.resize(target_size);
                         uint32_t actual_output = target_size;
                         esp_ae_rate_cvt_process(output_resampler_, (esp_ae_sample_t)task->pcm.data(), task->pcm.size(),
-                                                (esp_ae_sample_t)resampled.data(), &actual_output);
-                        resampled.resize(actual_output);
-                        task->pcm = std::move(resampled);
+                                                (esp_ae_sample_t)output_resample_buffer_.data(), &actual_output);
+                        output_resample_buffer_.resize(actual_output);
+                        /* Swap the buffers so both keep their capacity for the next frame */
+                        task->pcm.swap(output_resample_buffer_);
                     }
-                    lock.lock();
-                    audio_playback_queue_.push_back(std::move(task));
-                    audio_queue_cv_.notify_all();
+                    task->enqueue_time_us = esp_timer_get_time();
+                    if (audio_profiler_) {
+                        audio_profiler_->RecordLatency(kAudioProfilerStageDecode, task->enqueue_time_us - decode_start_time);
+                    }
+                    audio_playback_queue_.Push(std::move(task));
+                    if (audio_profiler_) {
+                        audio_profiler_->RecordQueueDepth(kAudioProfilerQueuePlayback, audio_playback_queue_.Size());
+                    }
+                    NotifyTask(audio_output_task_handle_);
                     debug_statistics_.decode_count++;
                 } else {
                     ESP_LOGE(TAG, "Failed to decode audio after resize, error code: %d", ret);
-                    lock.lock();
                 }
             } else {
                 ESP_LOGE(TAG, "Audio decoder is not configured");
-                lock.lock();
             }
             debug_statistics_.decode_count++;
         }
+
         /* Encode the audio to send queue */
-        if (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) {
-            auto task = std::move(audio_encode_queue_.front());
-            audio_encode_queue_.pop_front();
-            audio_queue_cv_.notify_all();
-            lock.unlock();
-
-            auto packet = std::make_unique<AudioStreamPacket>();
-            packet->frame_duration = OPUS_FRAME_DURATION_MS;
+        std::unique_ptr<AudioTask> task;
+        if (!audio_send_queue_.Full() && audio_encode_queue_.Pop(task)) {
+            processed = true;
+            xEventGroupSetBits(event_group_, AS_EVENT_ENCODE_QUEUE_AVAILABLE);
+
+            int64_t encode_start_time = esp_timer_get_time();
+            if (audio_profiler_) {
+                audio_profiler_->RecordLatency(kAudioProfilerStageEncodeQueue, encode_start_time - task->enqueue_time_us);
+            }
+
+            auto packet = AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink);
             packet->sample_rate = 16000;
             packet->timestamp = task->timestamp;
 
-            if (opus_encoder_ != nullptr && task->pcm.size() == encoder_frame_size_) {
-                std::vector<uint8_t> buf(encoder_outbuf_size_);
+            std::unique_lock<std::mutex> encoder_lock(encoder_mutex_);
+            if (opus_encoder_ != nullptr && task->pcm.size() == (size_t)encoder_frame_size_) {
+                packet->frame_duration = encoder_duration_ms_;
+                /* Encode straight into the pooled payload buffer, behind the transport header headroom */
+                packet->headroom = AUDIO_STREAM_PACKET_HEADROOM;
+                packet->payload.resize(packet->headroom + encoder_outbuf_size_);
                 esp_audio_enc_in_frame_t in = {
                     .buffer = (uint8_t *)(task->pcm.data()),
                     .len = (uint32_t)(encoder_frame_size_ * sizeof(int16_t)),
                 };
                 esp_audio_enc_out_frame_t out = {
-                    .buffer = buf.data(),
+                    .buffer = packet->payload.data() + packet->headroom,
                     .len = (uint32_t)encoder_outbuf_size_,
                     .encoded_bytes = 0,
                 };
                 auto ret = esp_opus_enc_process(opus_encoder_, &in, &out);
+                encoder_lock.unlock();
                 if (ret == ESP_AUDIO_ERR_OK) {
-                    packet->payload.assign(buf.data(), buf.data() + out.encoded_bytes);
+                    packet->payload.resize(packet->headroom + out.encoded_bytes);
+                    if (audio_profiler_) {
+                        audio_profiler_->RecordLatency(kAudioProfilerStageEncode, esp_timer_get_time() - encode_start_time);
+                    }
 
                     if (task->type == kAudioTaskTypeEncodeToSendQueue) {
-                        {
-                            std::lock_guard<std::mutex> lock2(audio_queue_mutex_);
-                            audio_send_queue_.push_back(std::move(packet));
+                        audio_send_queue_.Push(std::move(packet));
+                        if (audio_profiler_) {
+                            audio_profiler_->RecordQueueDepth(kAudioProfilerQueueSend, audio_send_queue_.Size());
                         }
                         if (callbacks_.on_send_queue_available) {
                             callbacks_.on_send_queue_available();
                         }
+#if CONFIG_USE_OPUS_ADAPTIVE_BITRATE
+                        AdaptUplinkBitrate();
+#endif
                     } else if (task->type == kAudioTaskTypeEncodeToTestingQueue) {
-                        std::lock_guard<std::mutex> lock2(audio_queue_mutex_);
-                        audio_testing_queue_.push_back(std::move(packet));
+                        if (!audio_testing_queue_.Push(std::move(packet))) {
+                            ESP_LOGW(TAG, "Audio testing queue is full, dropping packet");
+                        }
                     }
                     debug_statistics_.encode_count++;
                 } else {
@@ -444,9 +548,15 @@ void AudioService::OpusCodecTask() {
                 }
             } else {
                 ESP_LOGE(TAG, "Failed to encode audio: encoder not configured or invalid frame size (got %u, expected %u)",
-                         task->pcm.size(), encoder_frame_size_);
+                         (unsigned)task->pcm.size(), (unsigned)encoder_frame_size_);
             }
-            lock.lock();
+        }
+
+        if (!processed) {
+            /* A partially filled jitter buffer starts playing after a while without new packets,
+               and a missing frame is concealed once the playback queue ran dry */
+            bool buffering = jitter_buffer_ && jitter_buffer_->Active();
+            ulTaskNotifyTake(pdTRUE, buffering ? pdMS_TO_TICKS(JITTER_BUFFER_POLL_INTERVAL_MS) : portMAX_DELAY);
         }
     }
 
@@ -489,50 +599,177 @@ void AudioService::SetDecodeSampleRate(int sample_rate, int frame_duration) {
     }
 }
 
-void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm) {
-    auto task = std::make_unique<AudioTask>();
+bool AudioService::ConfigureEncoder(int frame_duration_ms, int bitrate, bool enable_fec) {
+    esp_opus_enc_config_t opus_enc_cfg = AS_OPUS_ENC_CONFIG();
+    opus_enc_cfg.frame_duration = (esp_opus_enc_frame_duration_t)AS_OPUS_GET_FRAME_DRU_ENUM(frame_duration_ms);
+    opus_enc_cfg.bitrate = bitrate > 0 ? bitrate : ESP_OPUS_BITRATE_AUTO;
+    opus_enc_cfg.enable_fec = enable_fec;
+
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    if (opus_encoder_ != nullptr) {
+        /* Only the bitrate changes, no need to reset the encoder state */
+        if (frame_duration_ms == encoder_duration_ms_ && enable_fec == encoder_fec_ && bitrate > 0 &&
+            esp_opus_enc_set_bitrate(opus_encoder_, bitrate) == ESP_AUDIO_ERR_OK) {
+            encoder_bitrate_ = bitrate;
+            return true;
+        }
+        esp_opus_enc_close(opus_encoder_);
+        opus_encoder_ = nullptr;
+    }
+    auto ret = esp_opus_enc_open(&opus_enc_cfg, sizeof(esp_opus_enc_config_t), &opus_encoder_);
+    if (opus_encoder_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", ret);
+        return false;
+    }
+    encoder_sample_rate_ = 16000;
+    encoder_duration_ms_ = frame_duration_ms;
+    encoder_bitrate_ = bitrate;
+    encoder_fec_ = enable_fec;
+    int frame_size_bytes = 0;
+    esp_opus_enc_get_frame_size(opus_encoder_, &frame_size_bytes, &encoder_outbuf_size_);
+    encoder_frame_size_ = frame_size_bytes / (int)sizeof(int16_t);
+    ESP_LOGI(TAG, "Opus encoder: %d ms frames, bitrate %d, FEC %s", frame_duration_ms, bitrate, enable_fec ? "on" : "off");
+    return true;
+}
+
+void AudioService::SetUplinkAudioParams(int frame_duration_ms, int bitrate) {
+    if (AS_OPUS_GET_FRAME_DRU_ENUM(frame_duration_ms) < 0 || frame_duration_ms < OPUS_MIN_FRAME_DURATION_MS ||
+        frame_duration_ms > OPUS_FRAME_DURATION_MS) {
+        ESP_LOGW(TAG, "Unsupported uplink frame duration %d ms, using %d ms", frame_duration_ms, OPUS_FRAME_DURATION_MS);
+        frame_duration_ms = OPUS_FRAME_DURATION_MS;
+    }
+    uplink_frame_duration_ms_ = frame_duration_ms;
+    uplink_bitrate_ = bitrate > 0 ? bitrate : 0;
+}
+
+void AudioService::AdaptUplinkBitrate() {
+    /* Levels above 0 lower the bitrate step by step (in percent of the effective bitrate) and turn on in-band FEC */
+    static const int kAdaptiveBitratePercents[] = { 75, 50, 35 };
+    constexpr size_t kMaxLevel = sizeof(kAdaptiveBitratePercents) / sizeof(kAdaptiveBitratePercents[0]);
+
+    auto now = esp_timer_get_time();
+    int queued_ms = audio_send_queue_.Size() * encoder_duration_ms_;
+    size_t level = adaptive_bitrate_level_;
+    if (queued_ms >= OPUS_ADAPTIVE_CONGESTED_MS) {
+        send_queue_clear_since_us_ = 0;
+        if (level < kMaxLevel && now - last_bitrate_change_time_us_ >= OPUS_ADAPTIVE_STEP_DOWN_INTERVAL_MS * 1000) {
+            level++;
+        }
+    } else if (level > 0 && queued_ms <= encoder_duration_ms_) {
+        if (send_queue_clear_since_us_ == 0) {
+            send_queue_clear_since_us_ = now;
+        } else if (now - send_queue_clear_since_us_ >= OPUS_ADAPTIVE_RECOVER_MS * 1000) {
+            send_queue_clear_since_us_ = now;
+            level--;
+        }
+    } else {
+        send_queue_clear_since_us_ = 0;
+    }
+    if (level == adaptive_bitrate_level_) {
+        return;
+    }
+
+    int bitrate = uplink_bitrate_;
+    if (level > 0) {
+        /* With the automatic bitrate libopus targets 60 * Fs / frame_size + Fs bps for mono */
+        int effective_bitrate = uplink_bitrate_ > 0 ? uplink_bitrate_ :
+            60 * 1000 / encoder_duration_ms_ + encoder_sample_rate_;
+        bitrate = std::max(effective_bitrate * kAdaptiveBitratePercents[level - 1] / 100, OPUS_ADAPTIVE_MIN_BITRATE);
+        bitrate = std::min(bitrate, effective_bitrate);
+    }
+    ESP_LOGW(TAG, "Send queue holds %d ms, uplink bitrate level %u -> %u", queued_ms, (unsigned)adaptive_bitrate_level_,
+        (unsigned)level);
+    if (ConfigureEncoder(encoder_duration_ms_, bitrate, level > 0)) {
+        adaptive_bitrate_level_ = level;
+        last_bitrate_change_time_us_ = now;
+    }
+}
+
+void AudioService::PushTaskToEncodeQueue(AudioTaskType type, const std::vector<int16_t>& pcm) {
+    auto task = AudioTask::Acquire();
     task->type = type;
-    task->pcm = std::move(pcm);
-    /* Push the task to the encode queue */
-    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+    /* Copy into the pooled buffer instead of adopting the caller's allocation */
+    task->pcm.assign(pcm.begin(), pcm.end());
 
     /* If the task is to send queue, we need to set the timestamp */
-    if (type == kAudioTaskTypeEncodeToSendQueue && !timestamp_queue_.empty()) {
-        if (timestamp_queue_.size() <= MAX_TIMESTAMPS_IN_QUEUE) {
-            task->timestamp = timestamp_queue_.front();
-        } else {
-            ESP_LOGW(TAG, "Timestamp queue (%u) is full, dropping timestamp", timestamp_queue_.size());
+    if (type == kAudioTaskTypeEncodeToSendQueue) {
+        std::lock_guard<std::mutex> lock(timestamp_queue_mutex_);
+        if (!timestamp_queue_.empty()) {
+            if (timestamp_queue_.size() <= MAX_TIMESTAMPS_IN_QUEUE) {
+                task->timestamp = timestamp_queue_.front();
+            } else {
+                ESP_LOGW(TAG, "Timestamp queue (%u) is full, dropping timestamp", (unsigned)timestamp_queue_.size());
+            }
+            timestamp_queue_.pop_front();
+        }
+    }
+
+    /* Push the task to the encode queue */
+    WaitForEventBits(AS_EVENT_ENCODE_QUEUE_AVAILABLE, [this]() { return !audio_encode_queue_.Full(); });
+    if (service_stopped_) {
+        return;
+    }
+    task->enqueue_time_us = esp_timer_get_time();
+    audio_encode_queue_.Push(std::move(task));
+    if (audio_profiler_) {
+        audio_profiler_->RecordQueueDepth(kAudioProfilerQueueEncode, audio_encode_queue_.Size());
+    }
+    NotifyTask(opus_codec_task_handle_);
+}
+
+void AudioService::WaitForEventBits(EventBits_t bits, const std::function<bool()>& condition) {
+    while (!service_stopped_) {
+        /* Clear before checking, so a bit set by the other side in between is not lost */
+        xEventGroupClearBits(event_group_, bits);
+        if (condition()) {
+            return;
         }
-        timestamp_queue_.pop_front();
+        xEventGroupWaitBits(event_group_, bits, pdFALSE, pdFALSE, portMAX_DELAY);
     }
+}
 
-    audio_queue_cv_.wait(lock, [this]() { return audio_encode_queue_.size() < MAX_ENCODE_TASKS_IN_QUEUE; });
-    audio_encode_queue_.push_back(std::move(task));
-    audio_queue_cv_.notify_all();
+void AudioService::NotifyTask(TaskHandle_t task_handle) {
+    if (task_handle != nullptr) {
+        xTaskNotifyGive(task_handle);
+    }
 }
 
 bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait) {
-    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-    if (audio_decode_queue_.size() >= MAX_DECODE_PACKETS_IN_QUEUE) {
-        if (wait) {
-            audio_queue_cv_.wait(lock, [this]() { return audio_decode_queue_.size() < MAX_DECODE_PACKETS_IN_QUEUE; });
-        } else {
+    if (jitter_buffer_ && packet->sequence != 0) {
+        jitter_buffer_->Put(std::move(packet), esp_timer_get_time());
+        NotifyTask(opus_codec_task_handle_);
+        return true;
+    }
+
+    auto has_space = [this]() {
+        return audio_decode_queue_.Size() < MAX_DECODE_PACKETS_IN_QUEUE && !audio_decode_queue_.Full();
+    };
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(decode_queue_producer_mutex_);
+            if (has_space()) {
+                audio_decode_queue_.Push(std::move(packet));
+                if (audio_profiler_) {
+                    audio_profiler_->RecordQueueDepth(kAudioProfilerQueueDecode, audio_decode_queue_.Size());
+                }
+                break;
+            }
+        }
+        if (!wait || service_stopped_) {
             return false;
         }
+        WaitForEventBits(AS_EVENT_DECODE_QUEUE_AVAILABLE, has_space);
     }
-    audio_decode_queue_.push_back(std::move(packet));
-    audio_queue_cv_.notify_all();
+    NotifyTask(opus_codec_task_handle_);
     return true;
 }
 
 std::unique_ptr<AudioStreamPacket> AudioService::PopPacketFromSendQueue() {
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-    if (audio_send_queue_.empty()) {
+    std::unique_ptr<AudioStreamPacket> packet;
+    if (!audio_send_queue_.Pop(packet)) {
         return nullptr;
     }
-    auto packet = std::move(audio_send_queue_.front());
-    audio_send_queue_.pop_front();
-    audio_queue_cv_.notify_all();
+    NotifyTask(opus_codec_task_handle_);
     return packet;
 }
 
@@ -547,7 +784,7 @@ const std::string& AudioService::GetLastWakeWord() const {
 }
 
 std::unique_ptr<AudioStreamPacket> AudioService::PopWakeWordPacket() {
-    auto packet = std::make_unique<AudioStreamPacket>();
+    auto packet = AudioStreamPacket::Acquire(kAudioStreamPacketPoolUplink);
     if (wake_word_->GetWakeWordOpus(packet->payload)) {
         return packet;
     }
@@ -588,10 +825,19 @@ void AudioService::EnableVoiceProcessing(bool enable) {
     ESP_LOGD(TAG, "%s voice processing", enable ? "Enabling" : "Disabling");
     if (enable) {
         if (!audio_processor_initialized_) {
-            audio_processor_->Initialize(codec_, OPUS_FRAME_DURATION_MS, models_list_);
+            audio_processor_->Initialize(codec_, OPUS_MIN_FRAME_DURATION_MS, models_list_);
             audio_processor_initialized_ = true;
         }
 
+        /* Apply the uplink parameters negotiated for this session */
+        adaptive_bitrate_level_ = 0;
+        send_queue_clear_since_us_ = 0;
+        if (uplink_frame_duration_ms_ != encoder_duration_ms_ || uplink_bitrate_ != encoder_bitrate_ || encoder_fec_) {
+            ConfigureEncoder(uplink_frame_duration_ms_, uplink_bitrate_, false);
+        }
+        uplink_frame_buffer_.clear();
+        uplink_frame_buffer_.reserve(encoder_frame_size_.load());
+
         /* We should make sure no audio is playing */
         ResetDecoder();
         audio_input_need_warmup_ = true;
@@ -614,20 +860,22 @@ void AudioService::EnableVoiceProcessing(bool enable) {
 void AudioService::EnableAudioTesting(bool enable) {
     ESP_LOGI(TAG, "%s audio testing", enable ? "Enabling" : "Disabling");
     if (enable) {
+        audio_testing_replay_ = false;
         xEventGroupSetBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING);
     } else {
         xEventGroupClearBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING);
-        /* Copy audio_testing_queue_ to audio_decode_queue_ */
-        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-        audio_decode_queue_ = std::move(audio_testing_queue_);
-        audio_queue_cv_.notify_all();
+        /* The opus codec task plays the recording straight from audio_testing_queue_, so the queue keeps
+           a single consumer and nothing is pushed into the decode queue before the cleared packets are dropped */
+        audio_decode_queue_.Clear();
+        audio_testing_replay_ = true;
+        NotifyTask(opus_codec_task_handle_);
     }
 }
 
 void AudioService::EnableDeviceAec(bool enable) {
     ESP_LOGI(TAG, "%s device AEC", enable ? "Enabling" : "Disabling");
     if (!audio_processor_initialized_) {
-        audio_processor_->Initialize(codec_, OPUS_FRAME_DURATION_MS, models_list_);
+        audio_processor_->Initialize(codec_, OPUS_MIN_FRAME_DURATION_MS, models_list_);
         audio_processor_initialized_ = true;
     }
 
@@ -645,120 +893,76 @@ void AudioService::PlaySound(const std::string_view& ogg) {
         codec_->EnableOutput(true);
     }
 
-    const uint8_t* buf = reinterpret_cast<const uint8_t*>(ogg.data());
-    size_t size = ogg.size();
-    size_t offset = 0;
-
-    auto find_page = [&](size_t start)->size_t {
-        for (size_t i = start; i + 4 <= size; ++i) {
-            if (buf[i] == 'O' && buf[i+1] == 'g' && buf[i+2] == 'g' && buf[i+3] == 'S') return i;
-        }
-        return static_cast<size_t>(-1);
-    };
-
-    bool seen_head = false;
-    bool seen_tags = false;
-    int sample_rate = 16000; // 默认值
+    auto sound = GetSoundIndex(ogg);
+    if (!sound) {
+        return;
+    }
+    /* The packets point into the sound asset, which stays mapped, so nothing is copied */
+    for (const auto& opus_packet : sound->packets) {
+        auto packet = AudioStreamPacket::Acquire();
+        packet->sample_rate = sound->sample_rate;
+        packet->frame_duration = opus_packet.duration_ms;
+        packet->payload_view = opus_packet.data;
+        packet->payload_view_size = opus_packet.size;
+        PushPacketToDecodeQueue(std::move(packet), true);
+    }
+}
 
-    while (true) {
-        size_t pos = find_page(offset);
-        if (pos == static_cast<size_t>(-1)) break;
-        offset = pos;
-        if (offset + 27 > size) break;
-
-        const uint8_t* page = buf + offset;
-        uint8_t page_segments = page[26];
-        size_t seg_table_off = offset + 27;
-        if (seg_table_off + page_segments > size) break;
-
-        size_t body_size = 0;
-        for (size_t i = 0; i < page_segments; ++i) body_size += page[27 + i];
-
-        size_t body_off = seg_table_off + page_segments;
-        if (body_off + body_size > size) break;
-
-        // Parse packets using lacing
-        size_t cur = body_off;
-        size_t seg_idx = 0;
-        while (seg_idx < page_segments) {
-            size_t pkt_len = 0;
-            size_t pkt_start = cur;
-            bool continued = false;
-            do {
-                uint8_t l = page[27 + seg_idx++];
-                pkt_len += l;
-                cur += l;
-                continued = (l == 255);
-            } while (continued && seg_idx < page_segments);
-
-            if (pkt_len == 0) continue;
-            const uint8_t* pkt_ptr = buf + pkt_start;
-
-            if (!seen_head) {
-                // 解析OpusHead包
-                if (pkt_len >= 19 && std::memcmp(pkt_ptr, "OpusHead", 8) == 0) {
-                    seen_head = true;
-                    // OpusHead结构：[0-7] "OpusHead", [8] version, [9] channel_count, [10-11] pre_skip
-                    // [12-15] input_sample_rate, [16-17] output_gain, [18] mapping_family
-                    if (pkt_len >= 12) {
-                        uint8_t version = pkt_ptr[8];
-                        uint8_t channel_count = pkt_ptr[9];
-                        if (pkt_len >= 16) {
-                            // 读取输入采样率 (little-endian)
-                            sample_rate = pkt_ptr[12] | (pkt_ptr[13] << 8) |
-                                        (pkt_ptr[14] << 16) | (pkt_ptr[15] << 24);
-                            ESP_LOGI(TAG, "OpusHead: version=%d, channels=%d, sample_rate=%d",
-                                   version, channel_count, sample_rate);
-                        }
-                    }
-                }
-                continue;
+std::shared_ptr<OggOpusStream> AudioService::GetSoundIndex(const std::string_view& ogg) {
+    std::lock_guard<std::mutex> lock(sound_cache_mutex_);
+    for (auto it = sound_cache_.begin(); it != sound_cache_.end(); ++it) {
+        if (it->first.data() == ogg.data() && it->first.size() == ogg.size()) {
+            auto sound = it->second;
+            if (it != sound_cache_.begin()) {
+                sound_cache_.erase(it);
+                sound_cache_.emplace_front(ogg, sound);
             }
-            if (!seen_tags) {
-                // Expect OpusTags in second packet
-                if (pkt_len >= 8 && std::memcmp(pkt_ptr, "OpusTags", 8) == 0) {
-                    seen_tags = true;
-                }
-                continue;
-            }
-
-            // Audio packet (Opus)
-            auto packet = std::make_unique<AudioStreamPacket>();
-            packet->sample_rate = sample_rate;
-            packet->frame_duration = 60;
-            packet->payload.resize(pkt_len);
-            std::memcpy(packet->payload.data(), pkt_ptr, pkt_len);
-            PushPacketToDecodeQueue(std::move(packet), true);
+            return sound;
         }
+    }
 
-        offset = body_off + body_size;
+    std::shared_ptr<OggOpusStream> sound = OggDemuxer::Parse(ogg);
+    if (!sound) {
+        ESP_LOGE(TAG, "Failed to parse sound (%u bytes)", (unsigned)ogg.size());
+        return nullptr;
+    }
+    sound_cache_.emplace_front(ogg, sound);
+    if (sound_cache_.size() > MAX_CACHED_SOUNDS) {
+        sound_cache_.pop_back();
     }
+    return sound;
 }
 
 bool AudioService::IsIdle() {
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-    return audio_encode_queue_.empty() && audio_decode_queue_.empty() && audio_playback_queue_.empty() && audio_testing_queue_.empty();
+    return audio_encode_queue_.Empty() && audio_decode_queue_.Empty() && audio_playback_queue_.Empty() && audio_testing_queue_.Empty() &&
+        (!jitter_buffer_ || jitter_buffer_->Empty());
 }
 
 void AudioService::WaitForPlaybackQueueEmpty() {
-    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-    audio_queue_cv_.wait(lock, [this]() { 
-        return service_stopped_ || (audio_decode_queue_.empty() && audio_playback_queue_.empty()); 
+    WaitForEventBits(AS_EVENT_PLAYBACK_QUEUE_DRAINED, [this]() {
+        return audio_decode_queue_.Empty() && audio_playback_queue_.Empty() && (!jitter_buffer_ || jitter_buffer_->Empty());
     });
 }
 
 void AudioService::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
     std::unique_lock<std::mutex> decoder_lock(decoder_mutex_);
     if (opus_decoder_ != nullptr) {
         esp_opus_dec_reset(opus_decoder_);
     }
     decoder_lock.unlock();
-    timestamp_queue_.clear();
-    audio_decode_queue_.clear();
-    audio_playback_queue_.clear();
-    audio_testing_queue_.clear();
-    audio_queue_cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(timestamp_queue_mutex_);
+        timestamp_queue_.clear();
+    }
+    audio_decode_queue_.Clear();
+    audio_playback_queue_.Clear();
+    audio_testing_queue_.Clear();
+    if (jitter_buffer_) {
+        jitter_buffer_->Reset();
+    }
+    /* Let the consumers drop the cleared items and wake up the waiting producers */
+    NotifyTask(opus_codec_task_handle_);
+    NotifyTask(audio_output_task_handle_);
 }
 
 void AudioService::CheckAndUpdateAudioPowerState() {
@@ -804,6 +1008,27 @@ void AudioService::SetModelsList(srmodel_list_t* models_list) {
     }
 }
 
+void AudioService::PrintDebugStatistics() {
+    if (audio_profiler_) {
+        audio_profiler_->Print();
+        if (jitter_buffer_) {
+            auto stats = jitter_buffer_->GetStatistics();
+            ESP_LOGI(TAG, "jitter buffer: received=%lu late=%lu dup=%lu lost=%lu underruns=%lu jitter=%lums target=%lu frames",
+                (unsigned long)stats.received, (unsigned long)stats.late, (unsigned long)stats.duplicated,
+                (unsigned long)stats.lost, (unsigned long)stats.underruns, (unsigned long)stats.jitter_ms,
+                (unsigned long)stats.target_frames);
+        }
+    }
+}
+
+bool AudioService::GetJitterBufferStatistics(JitterBufferStatistics& statistics) {
+    if (!jitter_buffer_) {
+        return false;
+    }
+    statistics = jitter_buffer_->GetStatistics();
+    return true;
+}
+
 bool AudioService::IsAfeWakeWord() {
 #if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
     return wake_word_ != nullptr && dynamic_cast<AfeWakeWord*>(wake_word_.get()) != nullptr;
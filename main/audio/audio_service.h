@@ -3,9 +3,9 @@
 
 #include <memory>
 #include <deque>
-#include <condition_variable>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -21,8 +21,12 @@
 #include "audio_codec.h"
 #include "audio_processor.h"
 #include "processors/audio_debugger.h"
+#include "processors/audio_profiler.h"
 #include "wake_word.h"
 #include "protocol.h"
+#include "spsc_ring.h"
+#include "jitter_buffer.h"
+#include "ogg_demuxer.h"
 
 
 /*
@@ -33,17 +37,39 @@
  * We use one task for MIC / Speaker / Processors, and one task for Opus Encoder / Opus Decoder.
  * 
  * Decode Queue and Send Queue are the main queues, because Opus packets are quite smaller than PCM packets.
- * 
+ *
+ * Every queue is a fixed-capacity SPSC ring. Consumers are woken by task notifications and
+ * producers waiting for free space by event group bits, so a push or pop only wakes the task
+ * that is actually waiting on that queue.
  */
 
 #define OPUS_FRAME_DURATION_MS 60
+// Uplink frames may be 20/40/60 ms, the audio processor outputs the shortest and they are joined before encoding
+#define OPUS_MIN_FRAME_DURATION_MS 20
 #define MAX_ENCODE_TASKS_IN_QUEUE 2
 #define MAX_PLAYBACK_TASKS_IN_QUEUE 2
 #define MAX_DECODE_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
-#define MAX_SEND_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
+// The uplink queues hold the same duration with the shortest frames
+#define MAX_SEND_PACKETS_IN_QUEUE (2400 / OPUS_MIN_FRAME_DURATION_MS)
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
+#define MAX_TESTING_PACKETS_IN_QUEUE (AUDIO_TESTING_MAX_DURATION_MS / OPUS_MIN_FRAME_DURATION_MS)
 #define MAX_TIMESTAMPS_IN_QUEUE 3
 
+static_assert(AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE >= MAX_DECODE_PACKETS_IN_QUEUE + JITTER_BUFFER_MAX_FRAMES,
+    "The downlink packet pool must cover a full decode queue and the jitter buffer");
+static_assert(AUDIO_STREAM_UPLINK_PACKET_POOL_SIZE >= MAX_SEND_PACKETS_IN_QUEUE + 2,
+    "The uplink packet pool must cover a full send queue and the packets being encoded and sent");
+
+// Uplink bitrate adaptation: step down while the send queue holds more than CONGESTED_MS of audio,
+// step back up once it stayed (almost) empty for RECOVER_MS. The levels are fractions of the
+// effective bitrate, never below MIN_BITRATE.
+#define OPUS_ADAPTIVE_CONGESTED_MS 480
+#define OPUS_ADAPTIVE_MIN_BITRATE 6000
+#define OPUS_ADAPTIVE_STEP_DOWN_INTERVAL_MS 1000
+#define OPUS_ADAPTIVE_RECOVER_MS 5000
+
+#define MAX_CACHED_SOUNDS 8
+
 #define AUDIO_POWER_TIMEOUT_MS 15000
 #define AUDIO_POWER_CHECK_INTERVAL_MS 1000
 
@@ -51,6 +77,9 @@
 #define AS_EVENT_WAKE_WORD_RUNNING          (1 << 1)
 #define AS_EVENT_AUDIO_PROCESSOR_RUNNING    (1 << 2)
 #define AS_EVENT_PLAYBACK_NOT_EMPTY         (1 << 3)
+#define AS_EVENT_ENCODE_QUEUE_AVAILABLE     (1 << 4)
+#define AS_EVENT_DECODE_QUEUE_AVAILABLE     (1 << 5)
+#define AS_EVENT_PLAYBACK_QUEUE_DRAINED     (1 << 6)
 
 #define AS_OPUS_GET_FRAME_DRU_ENUM(duration_ms)                   \
     ((duration_ms) == 5 ? ESP_OPUS_ENC_FRAME_DURATION_5_MS :      \
@@ -89,10 +118,19 @@ enum AudioTaskType {
     kAudioTaskTypeDecodeToPlaybackQueue,
 };
 
+// Tasks recycled through the pool: encode + playback queues plus one in flight for each task
+#define AUDIO_TASK_POOL_SIZE (MAX_ENCODE_TASKS_IN_QUEUE + MAX_PLAYBACK_TASKS_IN_QUEUE + 3)
+
 struct AudioTask {
     AudioTaskType type;
     std::vector<int16_t> pcm;
-    uint32_t timestamp;
+    uint32_t timestamp = 0;
+    int64_t enqueue_time_us = 0;
+
+    // Get a task from the task pool, it goes back to the pool (keeping the PCM capacity) when destroyed
+    static std::unique_ptr<AudioTask> Acquire();
+    void Reset();
+    void operator delete(AudioTask* task, std::destroying_delete_t);
 };
 
 struct DebugStatistics {
@@ -133,6 +171,11 @@ public:
     bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
     void SetModelsList(srmodel_list_t* models_list);
+    // Uplink parameters negotiated in the hello exchange, applied when voice processing starts
+    void SetUplinkAudioParams(int frame_duration_ms, int bitrate);
+    void PrintDebugStatistics();
+    // Counters of the jitter buffer, false when it is disabled
+    bool GetJitterBufferStatistics(JitterBufferStatistics& statistics);
 
 private:
     AudioCodec* codec_ = nullptr;
@@ -140,18 +183,38 @@ private:
     std::unique_ptr<AudioProcessor> audio_processor_;
     std::unique_ptr<WakeWord> wake_word_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
+    std::unique_ptr<AudioProfiler> audio_profiler_;
+    std::unique_ptr<JitterBuffer> jitter_buffer_;
     void* opus_encoder_ = nullptr;
     void* opus_decoder_ = nullptr;
     std::mutex decoder_mutex_;
+    std::mutex encoder_mutex_;
     std::mutex input_resampler_mutex_;
     esp_ae_rate_cvt_handle_t input_resampler_ = nullptr;
     esp_ae_rate_cvt_handle_t output_resampler_ = nullptr;
+    std::vector<int16_t> output_resample_buffer_;
+    // Capture buffers reused for every frame: raw codec samples before resampling (guarded by
+    // input_resampler_mutex_) and the 16kHz frame handed to the processors (input task only)
+    std::vector<int16_t> input_capture_buffer_;
+    std::vector<int16_t> capture_buffer_;
     
     // Encoder/Decoder state
     int encoder_sample_rate_ = 16000;
     int encoder_duration_ms_ = OPUS_FRAME_DURATION_MS;
-    int encoder_frame_size_ = 0;
+    // Samples per uplink frame, read without encoder_mutex_ by the processor output callback
+    std::atomic<int> encoder_frame_size_ = 0;
     int encoder_outbuf_size_ = 0;
+    int encoder_bitrate_ = 0;
+    bool encoder_fec_ = false;
+    int uplink_frame_duration_ms_ = OPUS_FRAME_DURATION_MS;
+    int uplink_bitrate_ = 0;
+    size_t adaptive_bitrate_level_ = 0;
+    int64_t last_bitrate_change_time_us_ = 0;
+    int64_t send_queue_clear_since_us_ = 0;
+    // Processor output joined into one uplink frame of uplink_frame_buffer_size_ samples
+    // (audio processor output task only)
+    std::vector<int16_t> uplink_frame_buffer_;
+    size_t uplink_frame_buffer_size_ = 0;
     int decoder_sample_rate_ = 0;
     int decoder_duration_ms_ = OPUS_FRAME_DURATION_MS;
     int decoder_frame_size_ = 0;
@@ -164,15 +227,21 @@ private:
     TaskHandle_t audio_input_task_handle_ = nullptr;
     TaskHandle_t audio_output_task_handle_ = nullptr;
     TaskHandle_t opus_codec_task_handle_ = nullptr;
-    std::mutex audio_queue_mutex_;
-    std::condition_variable audio_queue_cv_;
-    std::deque<std::unique_ptr<AudioStreamPacket>> audio_decode_queue_;
-    std::deque<std::unique_ptr<AudioStreamPacket>> audio_send_queue_;
-    std::deque<std::unique_ptr<AudioStreamPacket>> audio_testing_queue_;
-    std::deque<std::unique_ptr<AudioTask>> audio_encode_queue_;
-    std::deque<std::unique_ptr<AudioTask>> audio_playback_queue_;
+    SpscRing<std::unique_ptr<AudioStreamPacket>, MAX_DECODE_PACKETS_IN_QUEUE> audio_decode_queue_;
+    SpscRing<std::unique_ptr<AudioStreamPacket>, MAX_SEND_PACKETS_IN_QUEUE> audio_send_queue_;
+    // Filled by the encoder while audio testing records, then played back by the same opus codec task
+    SpscRing<std::unique_ptr<AudioStreamPacket>, MAX_TESTING_PACKETS_IN_QUEUE> audio_testing_queue_;
+    std::atomic<bool> audio_testing_replay_ = false;
+    SpscRing<std::unique_ptr<AudioTask>, MAX_ENCODE_TASKS_IN_QUEUE> audio_encode_queue_;
+    SpscRing<std::unique_ptr<AudioTask>, MAX_PLAYBACK_TASKS_IN_QUEUE> audio_playback_queue_;
+    // Serializes the producers of the decode queue (network, PlaySound, audio testing)
+    std::mutex decode_queue_producer_mutex_;
     // For server AEC
+    std::mutex timestamp_queue_mutex_;
     std::deque<uint32_t> timestamp_queue_;
+    // Packet index of the recently played sounds, keyed by the asset data they point into
+    std::mutex sound_cache_mutex_;
+    std::deque<std::pair<std::string_view, std::shared_ptr<OggOpusStream>>> sound_cache_;
 
     bool wake_word_initialized_ = false;
     bool audio_processor_initialized_ = false;
@@ -187,8 +256,13 @@ private:
     void AudioInputTask();
     void AudioOutputTask();
     void OpusCodecTask();
-    void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
+    void PushTaskToEncodeQueue(AudioTaskType type, const std::vector<int16_t>& pcm);
+    void WaitForEventBits(EventBits_t bits, const std::function<bool()>& condition);
+    void NotifyTask(TaskHandle_t task_handle);
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
+    bool ConfigureEncoder(int frame_duration_ms, int bitrate, bool enable_fec);
+    void AdaptUplinkBitrate();
+    std::shared_ptr<OggOpusStream> GetSoundIndex(const std::string_view& ogg);
     void CheckAndUpdateAudioPowerState();
 };
 
@@ -0,0 +1,204 @@
+#include "jitter_buffer.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cstdlib>
+
+#define TAG "JitterBuffer"
+
+void JitterBuffer::Put(std::unique_ptr<AudioStreamPacket> packet, int64_t arrival_time_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_.received++;
+    UpdateJitter(*packet, arrival_time_us);
+
+    uint32_t sequence = packet->sequence;
+    if (!started_) {
+        started_ = true;
+        next_sequence_ = sequence;
+        highest_sequence_ = sequence;
+    }
+
+    int32_t offset = (int32_t)(sequence - next_sequence_);
+    if (offset < 0) {
+        if (!playing_ && (int32_t)(highest_sequence_ - sequence) < JITTER_BUFFER_SLOTS) {
+            // Reordered before playout started, just start earlier
+            next_sequence_ = sequence;
+        } else if (offset > -JITTER_BUFFER_SLOTS) {
+            statistics_.late++;
+            return;
+        } else {
+            // The server restarted its sequence numbers (new session)
+            ESP_LOGI(TAG, "Sequence jumped from %lu to %lu, resync", (unsigned long)next_sequence_, (unsigned long)sequence);
+            Clear();
+            started_ = true;
+            next_sequence_ = sequence;
+            highest_sequence_ = sequence;
+        }
+    } else if (offset >= JITTER_BUFFER_SLOTS) {
+        // Too far ahead, give up on the frames that no longer fit
+        uint32_t new_next = sequence - JITTER_BUFFER_SLOTS + 1;
+        uint32_t gap = new_next - next_sequence_;
+        if (gap >= JITTER_BUFFER_SLOTS) {
+            // Every slot is behind the new window, drop them all instead of walking the gap
+            uint32_t freed = count_;
+            for (auto& slot : slots_) {
+                slot.reset();
+            }
+            count_ = 0;
+            statistics_.lost += gap - freed;
+            next_sequence_ = new_next;
+        }
+        while ((int32_t)(new_next - next_sequence_) > 0) {
+            auto& slot = slots_[next_sequence_ % JITTER_BUFFER_SLOTS];
+            if (slot) {
+                slot.reset();
+                count_--;
+            } else {
+                statistics_.lost++;
+            }
+            next_sequence_++;
+        }
+    }
+
+    auto& slot = slots_[sequence % JITTER_BUFFER_SLOTS];
+    if (slot) {
+        statistics_.duplicated++;
+        return;
+    }
+    if (count_ == 0 && !playing_) {
+        buffering_since_us_ = arrival_time_us;
+    }
+    if ((int32_t)(sequence - highest_sequence_) > 0) {
+        highest_sequence_ = sequence;
+    }
+    slot = std::move(packet);
+    count_++;
+}
+
+JitterBufferResult JitterBuffer::Pop(std::unique_ptr<AudioStreamPacket>& packet, int64_t now_us, bool playback_empty) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t frame_us = (int64_t)std::max(last_frame_duration_, 1) * 1000;
+    if (!playing_) {
+        if (count_ == 0) {
+            return kJitterBufferEmpty;
+        }
+        // Wait until the target delay is buffered, or play the tail of an utterance after the same delay
+        int64_t target_delay_us = (int64_t)statistics_.target_frames * frame_us;
+        if (count_ < statistics_.target_frames && now_us - buffering_since_us_ < target_delay_us) {
+            return kJitterBufferEmpty;
+        }
+        playing_ = true;
+        next_due_us_ = now_us;
+        concealed_frames_ = 0;
+        // Skip the gap in front of the first buffered packet
+        while (!slots_[next_sequence_ % JITTER_BUFFER_SLOTS]) {
+            next_sequence_++;
+        }
+    }
+
+    auto& slot = slots_[next_sequence_ % JITTER_BUFFER_SLOTS];
+    if (slot) {
+        next_sequence_++;
+        packet = std::move(slot);
+        count_--;
+        concealed_frames_ = 0;
+        last_sample_rate_ = packet->sample_rate;
+        last_frame_duration_ = packet->frame_duration;
+        // Frames are due one frame duration apart from the start of playout. When the speaker
+        // fell more than a frame behind that schedule, it restarts from now.
+        int64_t due_us = now_us - next_due_us_ > frame_us ? now_us : next_due_us_;
+        next_due_us_ = due_us + frame_us;
+        return kJitterBufferFrame;
+    }
+
+    // The next frame is missing, it can still arrive until it is due and the speaker ran out of decoded audio
+    if (now_us < next_due_us_ || !playback_empty) {
+        return kJitterBufferEmpty;
+    }
+    if ((int32_t)(highest_sequence_ - next_sequence_) <= 0) {
+        // Nothing after it is buffered, most likely the end of an utterance. Nothing is concealed, a late
+        // frame still plays until the target delay has passed, then playout stops without an underrun.
+        int64_t target_delay_us = (int64_t)statistics_.target_frames * frame_us;
+        if (now_us - next_due_us_ >= target_delay_us) {
+            playing_ = false;
+            buffering_since_us_ = now_us;
+        }
+        return kJitterBufferEmpty;
+    }
+    if (concealed_frames_ >= statistics_.target_frames) {
+        // The gap outlasted the target delay, stop and buffer again
+        playing_ = false;
+        statistics_.underruns++;
+        buffering_since_us_ = now_us;
+        return kJitterBufferEmpty;
+    }
+
+    // Conceal the frame and keep playing
+    next_sequence_++;
+    next_due_us_ += frame_us;
+    concealed_frames_++;
+    statistics_.lost++;
+    packet = AudioStreamPacket::Acquire();
+    packet->sample_rate = last_sample_rate_;
+    packet->frame_duration = last_frame_duration_;
+    auto& following = slots_[next_sequence_ % JITTER_BUFFER_SLOTS];
+    if (following) {
+        packet->timestamp = following->timestamp;
+        packet->payload.assign(following->PayloadData(), following->PayloadData() + following->PayloadSize());
+        return kJitterBufferFec;
+    }
+    return kJitterBufferPlc;
+}
+
+void JitterBuffer::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clear();
+}
+
+bool JitterBuffer::Empty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ == 0;
+}
+
+bool JitterBuffer::Active() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ > 0 || playing_;
+}
+
+JitterBufferStatistics JitterBuffer::GetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void JitterBuffer::Clear() {
+    for (auto& slot : slots_) {
+        slot.reset();
+    }
+    count_ = 0;
+    started_ = false;
+    playing_ = false;
+    has_last_arrival_ = false;
+}
+
+void JitterBuffer::UpdateJitter(const AudioStreamPacket& packet, int64_t arrival_time_us) {
+    if (packet.frame_duration > 0) {
+        last_frame_duration_ = packet.frame_duration;
+    }
+    if (has_last_arrival_) {
+        // Difference between the arrival spacing and the media spacing of the two packets
+        int32_t frames = (int32_t)(packet.sequence - last_arrival_sequence_);
+        int64_t media_us = (int64_t)frames * last_frame_duration_ * 1000;
+        int64_t d = std::abs((arrival_time_us - last_arrival_time_us_) - media_us);
+        jitter_us_x16_ += d - (jitter_us_x16_ + 8) / 16;
+
+        int64_t jitter_us = jitter_us_x16_ / 16;
+        int64_t frame_us = std::max(last_frame_duration_, 1) * 1000;
+        // Cover twice the jitter, rounded up to whole frames
+        int64_t frames_needed = JITTER_BUFFER_MIN_FRAMES + (2 * jitter_us + frame_us - 1) / frame_us;
+        statistics_.jitter_ms = jitter_us / 1000;
+        statistics_.target_frames = std::clamp<int64_t>(frames_needed, JITTER_BUFFER_MIN_FRAMES, JITTER_BUFFER_MAX_FRAMES);
+    }
+    has_last_arrival_ = true;
+    last_arrival_sequence_ = packet.sequence;
+    last_arrival_time_us_ = arrival_time_us;
+}
@@ -0,0 +1,89 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "protocol.h"
+
+/*
+ * Adaptive jitter buffer for sequenced server audio (UDP transport).
+ *
+ * Packets are slotted by sequence number so late arrivals are put back in order.
+ * The inter-arrival jitter is estimated as in RFC 3550, and playout only (re)starts
+ * once the buffer holds enough frames to cover it. While playing, frames are due one
+ * frame duration apart from the start of playout. A frame still missing when it is due,
+ * while a later one is already buffered and the speaker has no decoded audio left, is
+ * reported as lost, so the decoder conceals it with FEC from the next packet or with PLC,
+ * and playout goes on. Only a gap longer than the target delay counts as an underrun and
+ * makes the buffer fill up to the target again. When nothing later is buffered (the end
+ * of an utterance), playout stops after the target delay without concealing anything.
+ */
+
+#define JITTER_BUFFER_SLOTS 64
+#define JITTER_BUFFER_MIN_FRAMES 1
+#define JITTER_BUFFER_MAX_FRAMES 8
+// How often the decoder polls a partially filled buffer (end of an utterance) or a frame missing during playout
+#define JITTER_BUFFER_POLL_INTERVAL_MS 20
+
+enum JitterBufferResult {
+    kJitterBufferEmpty,     // Nothing to play yet (buffering or underrun)
+    kJitterBufferFrame,     // A regular packet
+    kJitterBufferFec,       // The frame was lost, the packet is a copy of the next one to decode FEC from
+    kJitterBufferPlc,       // The frame was lost, the packet has no payload
+};
+
+struct JitterBufferStatistics {
+    uint32_t received = 0;
+    uint32_t late = 0;
+    uint32_t duplicated = 0;
+    uint32_t lost = 0;
+    uint32_t underruns = 0;
+    uint32_t jitter_ms = 0;
+    uint32_t target_frames = JITTER_BUFFER_MIN_FRAMES;
+};
+
+class JitterBuffer {
+public:
+    JitterBuffer() = default;
+
+    // Called by the network task
+    void Put(std::unique_ptr<AudioStreamPacket> packet, int64_t arrival_time_us);
+    // Called by the decoder when it has room for one more frame. `playback_empty` tells that the
+    // playback queue ran dry, a missing frame is only concealed then.
+    JitterBufferResult Pop(std::unique_ptr<AudioStreamPacket>& packet, int64_t now_us, bool playback_empty);
+    void Reset();
+    bool Empty();
+    // Packets are buffered or playout is running, so Pop() has to be polled
+    bool Active();
+    JitterBufferStatistics GetStatistics();
+
+private:
+    std::mutex mutex_;
+    std::unique_ptr<AudioStreamPacket> slots_[JITTER_BUFFER_SLOTS];
+    size_t count_ = 0;
+    bool started_ = false;
+    bool playing_ = false;
+    uint32_t next_sequence_ = 0;
+    uint32_t highest_sequence_ = 0;
+    int64_t buffering_since_us_ = 0;
+    // Deadline of next_sequence_ during playout, and the frames concealed in a row
+    int64_t next_due_us_ = 0;
+    uint32_t concealed_frames_ = 0;
+    int last_sample_rate_ = 0;
+    int last_frame_duration_ = 0;
+
+    // Jitter estimate in microseconds, scaled by 16 as in RFC 3550
+    bool has_last_arrival_ = false;
+    uint32_t last_arrival_sequence_ = 0;
+    int64_t last_arrival_time_us_ = 0;
+    int64_t jitter_us_x16_ = 0;
+    JitterBufferStatistics statistics_;
+
+    void Clear();
+    void UpdateJitter(const AudioStreamPacket& packet, int64_t arrival_time_us);
+};
+
+#endif // JITTER_BUFFER_H
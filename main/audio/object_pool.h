@@ -0,0 +1,63 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+
+/*
+ * Fixed slab of reusable objects for the per-frame audio buffers.
+ *
+ * T declares a destroying operator delete that forwards to Release(), so a
+ * std::unique_ptr<T> handed out by Acquire() puts the object back into the slab
+ * when it is destroyed, keeping the capacity of its buffers. T::Reset() is called
+ * before the object is reused. When the slab is exhausted, Acquire() falls back
+ * to the heap and Release() frees those objects normally.
+ */
+template <typename T, size_t N>
+class ObjectPool {
+public:
+    ObjectPool() {
+        for (size_t i = 0; i < N; i++) {
+            free_[i] = &slab_[i];
+        }
+        free_count_ = N;
+    }
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    std::unique_ptr<T> Acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_count_ > 0) {
+                return std::unique_ptr<T>(free_[--free_count_]);
+            }
+        }
+        return std::make_unique<T>();
+    }
+
+    // The object is one of the slab, not a heap fallback
+    bool Owns(const T* object) const {
+        return object >= slab_ && object < slab_ + N;
+    }
+
+    void Release(T* object) {
+        if (!Owns(object)) {
+            object->~T();
+            ::operator delete(object);
+            return;
+        }
+        object->Reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_[free_count_++] = object;
+    }
+
+private:
+    T slab_[N];
+    T* free_[N];
+    size_t free_count_ = 0;
+    std::mutex mutex_;
+};
+
+#endif // OBJECT_POOL_H
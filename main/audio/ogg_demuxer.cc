@@ -0,0 +1,251 @@
+#include "ogg_demuxer.h"
+
+#include <esp_log.h>
+#include <array>
+#include <cstring>
+
+#define TAG "OggDemuxer"
+
+#define OGG_PAGE_HEADER_SIZE 27
+#define OGG_HEADER_TYPE_CONTINUED 0x01
+#define OGG_HEADER_TYPE_EOS 0x04
+
+// CRC-32 of the Ogg framing: polynomial 0x04c11db7, no reflection, initial value 0
+static uint32_t OggCrcUpdate(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t = {};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t r = i << 24;
+            for (int j = 0; j < 8; j++) {
+                r = (r & 0x80000000) ? (r << 1) ^ 0x04c11db7 : (r << 1);
+            }
+            t[i] = r;
+        }
+        return t;
+    }();
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xff];
+    }
+    return crc;
+}
+
+// The checksum field (bytes 22-25) counts as zero
+static uint32_t OggPageCrc(const uint8_t* page, size_t page_size) {
+    static const uint8_t zeros[4] = {0};
+    uint32_t crc = OggCrcUpdate(0, page, 22);
+    crc = OggCrcUpdate(crc, zeros, 4);
+    return OggCrcUpdate(crc, page + 26, page_size - 26);
+}
+
+static inline uint32_t ReadLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t FindCapturePattern(const uint8_t* buf, size_t size, size_t start) {
+    for (size_t i = start; i + 4 <= size; ++i) {
+        if (buf[i] == 'O' && buf[i + 1] == 'g' && buf[i + 2] == 'g' && buf[i + 3] == 'S') {
+            return i;
+        }
+    }
+    return static_cast<size_t>(-1);
+}
+
+uint32_t OggDemuxer::GetOpusPacketSamples(const uint8_t* packet, size_t size) {
+    if (size < 1) {
+        return 0;
+    }
+    uint8_t toc = packet[0];
+    uint8_t config = toc >> 3;
+    uint32_t frame_samples;  // at 48kHz
+    if (config < 12) {
+        // SILK: 10 / 20 / 40 / 60 ms
+        static const uint32_t silk[] = { 480, 960, 1920, 2880 };
+        frame_samples = silk[config & 0x03];
+    } else if (config < 16) {
+        // Hybrid: 10 / 20 ms
+        frame_samples = (config & 0x01) ? 960 : 480;
+    } else {
+        // CELT: 2.5 / 5 / 10 / 20 ms
+        frame_samples = 120 << (config & 0x03);
+    }
+
+    uint32_t frames;
+    switch (toc & 0x03) {
+    case 0:
+        frames = 1;
+        break;
+    case 1:
+    case 2:
+        frames = 2;
+        break;
+    default:
+        if (size < 2) {
+            return 0;
+        }
+        frames = packet[1] & 0x3f;
+        break;
+    }
+    uint32_t samples = frames * frame_samples;
+    // A packet never holds more than 120 ms
+    return samples <= 5760 ? samples : 0;
+}
+
+std::unique_ptr<OggOpusStream> OggDemuxer::Parse(std::string_view data) {
+    auto stream = std::make_unique<OggOpusStream>();
+    const uint8_t* buf = reinterpret_cast<const uint8_t*>(data.data());
+    size_t size = data.size();
+
+    bool seen_head = false;
+    bool seen_tags = false;
+    std::vector<uint8_t> partial;
+    bool has_partial = false;
+    uint64_t last_granule = 0;
+    bool granule_valid = true;
+    size_t bad_pages = 0;
+    size_t granule_mismatches = 0;
+    uint32_t total_samples = 0;
+
+    // Returns the number of samples of an audio packet, 0 for header packets
+    auto add_packet = [&](const uint8_t* ptr, size_t len, bool assembled) -> uint32_t {
+        if (len == 0) {
+            return 0;
+        }
+        if (!seen_head) {
+            // OpusHead: [0-7] "OpusHead", [8] version, [9] channel_count, [10-11] pre_skip,
+            // [12-15] input_sample_rate, [16-17] output_gain, [18] mapping_family
+            if (len >= 19 && std::memcmp(ptr, "OpusHead", 8) == 0) {
+                seen_head = true;
+                stream->channels = ptr[9];
+                uint32_t sample_rate = ReadLe32(ptr + 12);
+                if (sample_rate != 0) {
+                    stream->sample_rate = sample_rate;
+                }
+                ESP_LOGD(TAG, "OpusHead: version=%d, channels=%d, sample_rate=%d", ptr[8], stream->channels, stream->sample_rate);
+            }
+            return 0;
+        }
+        if (!seen_tags) {
+            if (len >= 8 && std::memcmp(ptr, "OpusTags", 8) == 0) {
+                seen_tags = true;
+            }
+            return 0;
+        }
+
+        uint32_t samples = GetOpusPacketSamples(ptr, len);
+        if (samples == 0) {
+            ESP_LOGW(TAG, "Invalid Opus packet (%u bytes), skipped", (unsigned)len);
+            return 0;
+        }
+        if (assembled) {
+            // Moving the inner vector keeps its buffer, so the pointer stays valid
+            stream->assembled.push_back(std::move(partial));
+            partial = std::vector<uint8_t>();
+            ptr = stream->assembled.back().data();
+        }
+        stream->packets.push_back({ ptr, (uint32_t)len, (uint16_t)(samples / 48) });
+        return samples;
+    };
+
+    size_t offset = 0;
+    while (offset + OGG_PAGE_HEADER_SIZE <= size) {
+        const uint8_t* page = buf + offset;
+        if (std::memcmp(page, "OggS", 4) != 0) {
+            // Lost sync, look for the next page
+            offset = FindCapturePattern(buf, size, offset + 1);
+            if (offset == static_cast<size_t>(-1)) {
+                break;
+            }
+            continue;
+        }
+
+        uint8_t page_segments = page[26];
+        size_t header_size = OGG_PAGE_HEADER_SIZE + page_segments;
+        if (offset + header_size > size) {
+            break;
+        }
+        size_t body_size = 0;
+        for (size_t i = 0; i < page_segments; ++i) {
+            body_size += page[OGG_PAGE_HEADER_SIZE + i];
+        }
+        size_t page_size = header_size + body_size;
+        if (offset + page_size > size) {
+            break;
+        }
+
+        if (OggPageCrc(page, page_size) != ReadLe32(page + 22)) {
+            ESP_LOGW(TAG, "Bad CRC in page at offset %u, skipped", (unsigned)offset);
+            bad_pages++;
+            granule_valid = false;
+            has_partial = false;
+            partial.clear();
+            offset++;
+            continue;
+        }
+
+        uint8_t header_type = page[5];
+        uint64_t granule = (uint64_t)ReadLe32(page + 6) | ((uint64_t)ReadLe32(page + 10) << 32);
+        // The first segments belong to a packet from a page we skipped
+        bool skip_continued = (header_type & OGG_HEADER_TYPE_CONTINUED) && !has_partial;
+        if (!(header_type & OGG_HEADER_TYPE_CONTINUED) && has_partial) {
+            has_partial = false;
+            partial.clear();
+        }
+
+        const uint8_t* body = page + header_size;
+        size_t cur = 0;
+        size_t seg_idx = 0;
+        uint32_t page_samples = 0;
+        while (seg_idx < page_segments) {
+            size_t pkt_start = cur;
+            size_t pkt_len = 0;
+            uint8_t lacing;
+            do {
+                lacing = page[OGG_PAGE_HEADER_SIZE + seg_idx++];
+                pkt_len += lacing;
+            } while (lacing == 255 && seg_idx < page_segments);
+            cur += pkt_len;
+            bool complete = lacing < 255;
+
+            if (skip_continued) {
+                skip_continued = false;
+                continue;
+            }
+            if (has_partial) {
+                partial.insert(partial.end(), body + pkt_start, body + pkt_start + pkt_len);
+                if (complete) {
+                    has_partial = false;
+                    page_samples += add_packet(partial.data(), partial.size(), true);
+                    partial.clear();
+                }
+            } else if (!complete) {
+                partial.assign(body + pkt_start, body + pkt_start + pkt_len);
+                has_partial = true;
+            } else {
+                page_samples += add_packet(body + pkt_start, pkt_len, false);
+            }
+        }
+
+        // Granule -1 means no packet ends on this page
+        if (granule != UINT64_MAX && page_samples > 0) {
+            // The last page may be trimmed to the real end of the stream
+            if (granule_valid && !(header_type & OGG_HEADER_TYPE_EOS) && granule - last_granule != page_samples) {
+                granule_mismatches++;
+            }
+            last_granule = granule;
+            granule_valid = true;
+        }
+        total_samples += page_samples;
+        offset += page_size;
+    }
+
+    if (!seen_head) {
+        ESP_LOGE(TAG, "No OpusHead found");
+        return nullptr;
+    }
+    if (granule_mismatches > 0) {
+        ESP_LOGW(TAG, "%u pages with a granule position not matching their packets", (unsigned)granule_mismatches);
+    }
+    ESP_LOGI(TAG, "Indexed %u packets, %lu ms, %u bad pages", (unsigned)stream->packets.size(),
+        (unsigned long)(total_samples / 48), (unsigned)bad_pages);
+    return stream;
+}
@@ -0,0 +1,40 @@
+#ifndef OGG_DEMUXER_H
+#define OGG_DEMUXER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ * Ogg/Opus demuxer for the bundled sound assets.
+ *
+ * Parse() walks the pages once, drops pages with a bad CRC, and builds an index of
+ * the Opus packets. Each packet keeps a pointer into the original data, so a sound
+ * can be replayed from its index without copying. The frame duration of every packet
+ * comes from its TOC byte and is checked against the page granule positions.
+ */
+
+struct OggOpusPacket {
+    const uint8_t* data;
+    uint32_t size;
+    uint16_t duration_ms;
+};
+
+struct OggOpusStream {
+    int sample_rate = 16000;
+    int channels = 1;
+    std::vector<OggOpusPacket> packets;
+    // Packets continued across pages, these cannot point into the original data
+    std::vector<std::vector<uint8_t>> assembled;
+};
+
+class OggDemuxer {
+public:
+    static std::unique_ptr<OggOpusStream> Parse(std::string_view data);
+    // Duration in samples at 48kHz of an Opus packet, 0 if the TOC is invalid (RFC 6716, section 3.1)
+    static uint32_t GetOpusPacketSamples(const uint8_t* packet, size_t size);
+};
+
+#endif // OGG_DEMUXER_H
@@ -0,0 +1,152 @@
+#include "pcm_kernels.h"
+
+#include <sdkconfig.h>
+#include <algorithm>
+
+static inline int16_t Clamp16(int32_t value) {
+    return (int16_t)std::clamp<int32_t>(value, -INT16_MAX, INT16_MAX);
+}
+
+int32_t PcmVolumeToGain(int volume) {
+    volume = std::clamp(volume, 0, 100);
+    // (volume / 100)^2 * 65536, rounded down like the floating point version
+    return (int32_t)((int64_t)volume * volume * 65536 / 10000);
+}
+
+void PcmScaleToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16) {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        int32_t s0 = src[i], s1 = src[i + 1], s2 = src[i + 2], s3 = src[i + 3];
+        dst[i] = s0 * gain_q16;
+        dst[i + 1] = s1 * gain_q16;
+        dst[i + 2] = s2 * gain_q16;
+        dst[i + 3] = s3 * gain_q16;
+    }
+    for (; i < samples; i++) {
+        dst[i] = (int32_t)src[i] * gain_q16;
+    }
+}
+
+void PcmInt32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift) {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        int32_t s0 = src[i] >> shift, s1 = src[i + 1] >> shift, s2 = src[i + 2] >> shift, s3 = src[i + 3] >> shift;
+        dst[i] = Clamp16(s0);
+        dst[i + 1] = Clamp16(s1);
+        dst[i + 2] = Clamp16(s2);
+        dst[i + 3] = Clamp16(s3);
+    }
+    for (; i < samples; i++) {
+        dst[i] = Clamp16(src[i] >> shift);
+    }
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#define PCM_PIE_BLOCK_SAMPLES 8
+
+static inline bool IsPieAligned(const void* p) {
+    return ((uintptr_t)p & 15) == 0;
+}
+
+// Multiply 8 samples by the broadcast gain in QACC and saturate back to 16 bits
+static size_t PieApplyGain(int16_t* data, size_t blocks, int16_t gain) {
+    int16_t* load = data;
+    int16_t* store = data;
+    int32_t shift = 0;
+    for (size_t n = 0; n < blocks; n++) {
+        asm volatile (
+            "ee.vldbc.16 q1, %[gain]\n"
+            "ee.vld.128.ip q0, %[load], 16\n"
+            "ee.zero.qacc\n"
+            "ee.vmulas.s16.qacc q0, q1\n"
+            "ee.srcmb.s16.qacc q2, %[shift], 0\n"
+            "ee.vst.128.ip q2, %[store], 16\n"
+            : [load] "+r" (load), [store] "+r" (store)
+            : [gain] "r" (&gain), [shift] "r" (shift)
+            : "memory");
+    }
+    return blocks * PCM_PIE_BLOCK_SAMPLES;
+}
+
+// Saturating add of 8 samples
+static size_t PieMix(int16_t* dst, const int16_t* src, size_t blocks) {
+    int16_t* load = dst;
+    int16_t* store = dst;
+    for (size_t n = 0; n < blocks; n++) {
+        asm volatile (
+            "ee.vld.128.ip q0, %[load], 16\n"
+            "ee.vld.128.ip q1, %[src], 16\n"
+            "ee.vadds.s16 q2, q0, q1\n"
+            "ee.vst.128.ip q2, %[store], 16\n"
+            : [load] "+r" (load), [src] "+r" (src), [store] "+r" (store)
+            :
+            : "memory");
+    }
+    return blocks * PCM_PIE_BLOCK_SAMPLES;
+}
+#endif
+
+void PcmApplyGain(int16_t* data, size_t samples, int gain) {
+    size_t i = 0;
+#if CONFIG_IDF_TARGET_ESP32S3
+    if (gain >= INT16_MIN && gain <= INT16_MAX) {
+        for (; i < samples && !IsPieAligned(data + i); i++) {
+            data[i] = Clamp16(data[i] * gain);
+        }
+        i += PieApplyGain(data + i, (samples - i) / PCM_PIE_BLOCK_SAMPLES, (int16_t)gain);
+    }
+#endif
+    for (; i + 4 <= samples; i += 4) {
+        int32_t s0 = data[i] * gain, s1 = data[i + 1] * gain, s2 = data[i + 2] * gain, s3 = data[i + 3] * gain;
+        data[i] = Clamp16(s0);
+        data[i + 1] = Clamp16(s1);
+        data[i + 2] = Clamp16(s2);
+        data[i + 3] = Clamp16(s3);
+    }
+    for (; i < samples; i++) {
+        data[i] = Clamp16(data[i] * gain);
+    }
+}
+
+void PcmMix(int16_t* dst, const int16_t* src, size_t samples) {
+    size_t i = 0;
+#if CONFIG_IDF_TARGET_ESP32S3
+    for (; i < samples && !IsPieAligned(dst + i); i++) {
+        dst[i] = Clamp16(dst[i] + src[i]);
+    }
+    if (IsPieAligned(src + i)) {
+        i += PieMix(dst + i, src + i, (samples - i) / PCM_PIE_BLOCK_SAMPLES);
+    }
+#endif
+    for (; i + 4 <= samples; i += 4) {
+        int32_t s0 = dst[i] + src[i], s1 = dst[i + 1] + src[i + 1], s2 = dst[i + 2] + src[i + 2], s3 = dst[i + 3] + src[i + 3];
+        dst[i] = Clamp16(s0);
+        dst[i + 1] = Clamp16(s1);
+        dst[i + 2] = Clamp16(s2);
+        dst[i + 3] = Clamp16(s3);
+    }
+    for (; i < samples; i++) {
+        dst[i] = Clamp16(dst[i] + src[i]);
+    }
+}
+
+void PcmExtractChannel(const int16_t* src, int16_t* dst, size_t frames, int channels, int channel) {
+    src += channel;
+    if (channels == 2) {
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            int16_t s0 = src[2 * i], s1 = src[2 * i + 2], s2 = src[2 * i + 4], s3 = src[2 * i + 6];
+            dst[i] = s0;
+            dst[i + 1] = s1;
+            dst[i + 2] = s2;
+            dst[i + 3] = s3;
+        }
+        for (; i < frames; i++) {
+            dst[i] = src[2 * i];
+        }
+        return;
+    }
+    for (size_t i = 0; i < frames; i++) {
+        dst[i] = src[i * channels];
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef PCM_KERNELS_H
+#define PCM_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Shared PCM sample loops for the codecs and the audio service.
+ *
+ * All functions clamp 16-bit results to [-INT16_MAX, INT16_MAX], like the loops they
+ * replace. The loops are written branch-free on 4 samples at a time so the compiler
+ * can keep them in registers on Xtensa/RISC-V.
+ *
+ * On ESP32-S3, PcmApplyGain and PcmMix process 8 samples per instruction with the PIE
+ * vector unit when the buffers are 16-byte aligned. The vector path saturates to the full
+ * int16 range, so a negative full-scale result may be -32768 instead of -32767.
+ */
+
+// Volume (0-100) to the Q16 gain used by PcmScaleToInt32: (volume / 100)^2 * 65536
+int32_t PcmVolumeToGain(int volume);
+
+// dst[i] = src[i] * gain_q16, gain_q16 <= 65536 never overflows
+void PcmScaleToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16);
+
+// dst[i] = clamp(src[i] >> shift)
+void PcmInt32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift);
+
+// data[i] = clamp(data[i] * gain), in place, |gain| <= 65535 never overflows
+void PcmApplyGain(int16_t* data, size_t samples, int gain);
+
+// dst[i] = clamp(dst[i] + src[i]), in place
+void PcmMix(int16_t* dst, const int16_t* src, size_t samples);
+
+// Extract one channel of interleaved samples, dst may be src (in place)
+void PcmExtractChannel(const int16_t* src, int16_t* dst, size_t frames, int channels, int channel);
+
+#endif // PCM_KERNELS_H
@@ -88,7 +88,7 @@ size_t AfeAudioProcessor::GetFeedSize() {
     return afe_iface_->get_feed_chunksize(afe_data_);
 }
 
-void AfeAudioProcessor::Feed(std::vector<int16_t>&& data) {
+void AfeAudioProcessor::Feed(const std::vector<int16_t>& data) {
     if (afe_data_ == nullptr) {
         return;
     }
@@ -110,7 +110,7 @@ bool AfeAudioProcessor::IsRunning() {
     return xEventGroupGetBits(event_group_) & PROCESSOR_RUNNING;
 }
 
-void AfeAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
+void AfeAudioProcessor::OnOutput(std::function<void(const std::vector<int16_t>& data)> callback) {
     output_callback_ = callback;
 }
 
@@ -158,13 +158,13 @@ void AfeAudioProcessor::AudioProcessorTask() {
             // Output complete frames when buffer has enough data
             while (output_buffer_.size() >= frame_samples_) {
                 if (output_buffer_.size() == frame_samples_) {
-                    // If buffer size equals frame size, move the entire buffer
-                    output_callback_(std::move(output_buffer_));
+                    // If buffer size equals frame size, hand out the entire buffer and reuse it
+                    output_callback_(output_buffer_);
                     output_buffer_.clear();
-                    output_buffer_.reserve(frame_samples_);
                 } else {
-                    // If buffer size exceeds frame size, copy one frame and remove it
-                    output_callback_(std::vector<int16_t>(output_buffer_.begin(), output_buffer_.begin() + frame_samples_));
+                    // If buffer size exceeds frame size, copy one frame into the reused frame buffer and remove it
+                    frame_buffer_.assign(output_buffer_.begin(), output_buffer_.begin() + frame_samples_);
+                    output_callback_(frame_buffer_);
                     output_buffer_.erase(output_buffer_.begin(), output_buffer_.begin() + frame_samples_);
                 }
             }
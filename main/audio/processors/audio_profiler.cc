@@ -0,0 +1,107 @@
+#include "audio_profiler.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cstdint>
+
+#define TAG "AudioProfiler"
+
+static const char* const kStageNames[kAudioProfilerStageCount] = {
+    "input", "encode_queue", "encode", "decode", "playback_queue", "output",
+};
+
+static const char* const kQueueNames[kAudioProfilerQueueCount] = {
+    "encode", "send", "decode", "playback",
+};
+
+AudioProfiler::AudioProfiler() {
+    last_print_time_us_ = esp_timer_get_time();
+}
+
+void AudioProfiler::RecordLatency(AudioProfilerStage stage, int64_t latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& s = stages_[stage];
+    uint32_t value = latency_us <= 0 ? 0 : latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us;
+    s.buckets[BucketIndex(value)]++;
+    s.count++;
+    if (value > s.max_us) {
+        s.max_us = value;
+    }
+}
+
+void AudioProfiler::RecordQueueDepth(AudioProfilerQueue queue, size_t depth) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& q = queues_[queue];
+    if (depth > q.max_depth) {
+        q.max_depth = depth;
+    }
+    q.depth_sum += depth;
+    q.depth_count++;
+}
+
+size_t AudioProfiler::BucketIndex(uint32_t latency_us) {
+    if (latency_us < AUDIO_PROFILER_SUB_BUCKETS) {
+        return latency_us;
+    }
+    // The top bit picks the octave, the next SUB_BUCKET_BITS bits the bucket inside it
+    int msb = 31 - __builtin_clz(latency_us);
+    size_t index = (msb - AUDIO_PROFILER_SUB_BUCKET_BITS + 1) * AUDIO_PROFILER_SUB_BUCKETS +
+        ((latency_us >> (msb - AUDIO_PROFILER_SUB_BUCKET_BITS)) & (AUDIO_PROFILER_SUB_BUCKETS - 1));
+    return std::min<size_t>(index, AUDIO_PROFILER_BUCKETS - 1);
+}
+
+uint32_t AudioProfiler::BucketUpperBound(size_t index) {
+    if (index < AUDIO_PROFILER_SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / AUDIO_PROFILER_SUB_BUCKETS - 1;
+    size_t sub_bucket = index % AUDIO_PROFILER_SUB_BUCKETS;
+    return ((AUDIO_PROFILER_SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+uint32_t AudioProfiler::Percentile(const StageStatistics& stage, uint32_t percent) {
+    // Smallest bucket that holds at least `percent` of the samples, never reported above the real maximum
+    uint64_t rank = ((uint64_t)stage.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < AUDIO_PROFILER_BUCKETS; i++) {
+        seen += stage.buckets[i];
+        if (seen >= rank && seen > 0) {
+            return std::min(BucketUpperBound(i), stage.max_us);
+        }
+    }
+    return stage.max_us;
+}
+
+void AudioProfiler::Print() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto now = esp_timer_get_time();
+    float elapsed_s = (now - last_print_time_us_) / 1000000.0f;
+    last_print_time_us_ = now;
+    if (elapsed_s <= 0) {
+        elapsed_s = 1;
+    }
+
+    for (int i = 0; i < kAudioProfilerStageCount; i++) {
+        auto& s = stages_[i];
+        if (s.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-14s frames=%lu (%.1f/s) p50=%luus p90=%luus p99=%luus max=%luus", kStageNames[i],
+            (unsigned long)s.count, s.count / elapsed_s,
+            (unsigned long)Percentile(s, 50), (unsigned long)Percentile(s, 90),
+            (unsigned long)Percentile(s, 99), (unsigned long)s.max_us);
+        s = StageStatistics();
+    }
+
+    for (int i = 0; i < kAudioProfilerQueueCount; i++) {
+        auto& q = queues_[i];
+        if (q.depth_count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "queue %-9s avg=%.2f max=%lu", kQueueNames[i],
+            (float)q.depth_sum / q.depth_count, (unsigned long)q.max_depth);
+        q = QueueStatistics();
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef AUDIO_PROFILER_H
+#define AUDIO_PROFILER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+/*
+ * Per-stage latency / queue depth / throughput statistics for the audio pipeline.
+ * Every latency of the reporting interval goes into a fixed log-linear histogram per stage
+ * (4 buckets per power of two), so the percentiles printed by Print() cover the whole interval
+ * and are exact to within one bucket (25%). Latencies above ~1 s share the last bucket.
+ */
+
+enum AudioProfilerStage {
+    kAudioProfilerStageInput,           // AudioInputTask: codec read + resample
+    kAudioProfilerStageEncodeQueue,     // Time spent in audio_encode_queue_
+    kAudioProfilerStageEncode,          // OpusCodecTask: opus encode
+    kAudioProfilerStageDecode,          // OpusCodecTask: opus decode + resample
+    kAudioProfilerStagePlaybackQueue,   // Time spent in audio_playback_queue_
+    kAudioProfilerStageOutput,          // AudioOutputTask: codec write
+    kAudioProfilerStageCount,
+};
+
+enum AudioProfilerQueue {
+    kAudioProfilerQueueEncode,
+    kAudioProfilerQueueSend,
+    kAudioProfilerQueueDecode,
+    kAudioProfilerQueuePlayback,
+    kAudioProfilerQueueCount,
+};
+
+#define AUDIO_PROFILER_SUB_BUCKET_BITS 2
+#define AUDIO_PROFILER_SUB_BUCKETS (1 << AUDIO_PROFILER_SUB_BUCKET_BITS)
+// Latencies below 2^20 us get their own bucket
+#define AUDIO_PROFILER_MAX_LATENCY_BITS 20
+#define AUDIO_PROFILER_BUCKETS \
+    (AUDIO_PROFILER_SUB_BUCKETS * (AUDIO_PROFILER_MAX_LATENCY_BITS - AUDIO_PROFILER_SUB_BUCKET_BITS + 1))
+
+class AudioProfiler {
+public:
+    AudioProfiler();
+
+    void RecordLatency(AudioProfilerStage stage, int64_t latency_us);
+    void RecordQueueDepth(AudioProfilerQueue queue, size_t depth);
+    // Log the statistics collected since the last call and reset them
+    void Print();
+
+private:
+    struct StageStatistics {
+        uint32_t buckets[AUDIO_PROFILER_BUCKETS] = {};
+        uint32_t count = 0;
+        uint32_t max_us = 0;
+    };
+    struct QueueStatistics {
+        uint32_t max_depth = 0;
+        uint64_t depth_sum = 0;
+        uint32_t depth_count = 0;
+    };
+
+    std::mutex mutex_;
+    StageStatistics stages_[kAudioProfilerStageCount];
+    QueueStatistics queues_[kAudioProfilerQueueCount];
+    int64_t last_print_time_us_ = 0;
+
+    static size_t BucketIndex(uint32_t latency_us);
+    static uint32_t BucketUpperBound(size_t index);
+    static uint32_t Percentile(const StageStatistics& stage, uint32_t percent);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+ * Fixed-capacity lock-free single-producer / single-consumer ring.
+ *
+ * Push() must only be called by the producer and Pop() by the consumer.
+ * Clear() and Size() may be called from any task: Clear() only records the
+ * current write position, the consumer drops the cleared items on its next Pop().
+ * Until then the cleared items still take up capacity, so Push() after Clear()
+ * can fail when the consumer has not run yet.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    static_assert(Capacity > 0, "SpscRing capacity must be greater than zero");
+
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    bool Push(T&& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        slots_[tail % kSlots] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& item) {
+        size_t head = DiscardCleared();
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots_[head % kSlots]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Clear() {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t until = clear_until_.load(std::memory_order_relaxed);
+        while (Before(until, tail) &&
+               !clear_until_.compare_exchange_weak(until, tail, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    size_t Size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t until = clear_until_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        if (Before(head, until)) {
+            head = until;
+        }
+        return tail - head;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    // Producer side: no free slot until the consumer pops (or drops cleared items)
+    bool Full() const {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) >= Capacity;
+    }
+
+private:
+    // Power of two so that the free running indices stay consistent when they wrap
+    static constexpr size_t RoundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+    static constexpr size_t kSlots = RoundUpPow2(Capacity);
+
+    static bool Before(size_t a, size_t b) {
+        return static_cast<ptrdiff_t>(b - a) > 0;
+    }
+
+    size_t DiscardCleared() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t until = clear_until_.load(std::memory_order_acquire);
+        if (!Before(head, until)) {
+            return head;
+        }
+        while (Before(head, until)) {
+            slots_[head % kSlots] = T();
+            head++;
+        }
+        head_.store(head, std::memory_order_release);
+        return head;
+    }
+
+    T slots_[kSlots];
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<size_t> clear_until_{0};
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,42 @@
+#include "audio_sender.h"
+
+AudioSender::AudioSender(AudioService& audio_service) : audio_service_(audio_service) {
+}
+
+void AudioSender::Start(UBaseType_t priority, BaseType_t core_id) {
+    xTaskCreatePinnedToCore([](void* arg) {
+        AudioSender* sender = static_cast<AudioSender*>(arg);
+        sender->Run();
+        vTaskDelete(NULL);
+    }, "audio_send", 2048 * 3, this, priority, &task_handle_, core_id);
+}
+
+void AudioSender::Notify() {
+    xTaskNotifyGive(task_handle_);
+}
+
+void AudioSender::SetProtocol(std::shared_ptr<Protocol> protocol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    protocol_ = std::move(protocol);
+}
+
+void AudioSender::Run() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        std::shared_ptr<Protocol> protocol;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            protocol = protocol_;
+        }
+
+        // A packet that fails to send is dropped and the rest stay queued until the next packet
+        // arrives. While the network is slow the send queue fills up, which makes AudioService
+        // lower the uplink bitrate and finally stop taking frames from the encode queue.
+        while (auto packet = audio_service_.PopPacketFromSendQueue()) {
+            if (protocol && !protocol->SendAudio(std::move(packet))) {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef AUDIO_SENDER_H
+#define AUDIO_SENDER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <memory>
+#include <mutex>
+
+#include "audio_service.h"
+#include "protocol.h"
+
+/*
+ * Sends the encoded uplink audio from its own task, so that scheduled callbacks, UI updates and
+ * MCP tools running in the main loop never delay it.
+ *
+ * The task borrows the protocol under a short lock and sends without holding it, so replacing or
+ * resetting the protocol never waits for a network send. A protocol dropped while a send is in
+ * progress is destroyed by the send task once that batch is done.
+ */
+class AudioSender {
+public:
+    explicit AudioSender(AudioService& audio_service);
+
+    void Start(UBaseType_t priority, BaseType_t core_id);
+    // Called by AudioService whenever a packet was pushed to the send queue
+    void Notify();
+    // Packets popped while there is no protocol are dropped
+    void SetProtocol(std::shared_ptr<Protocol> protocol);
+
+private:
+    AudioService& audio_service_;
+    std::mutex mutex_;
+    std::shared_ptr<Protocol> protocol_;
+    TaskHandle_t task_handle_ = nullptr;
+
+    void Run();
+};
+
+#endif // AUDIO_SENDER_H
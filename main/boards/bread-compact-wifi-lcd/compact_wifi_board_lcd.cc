@@ -9,6 +9,8 @@
 #include "lamp_controller.h"
 #include "led/single_led.h"
 #include "sht30_sensor.h"
+#include "sensor_manager.h"
+#include "sensor_history.h"
 #include "sensor_upload.h"
 #include "device_state.h"
 #include "settings.h"
@@ -64,19 +66,29 @@ static const gc9a01_lcd_init_cmd_t gc9107_lcd_init_cmds[] = {
  
 #define TAG "CompactWifiBoardLCD"
 
+// 状态监控任务的事件
+#define MONITOR_EVENT_STATE_CHANGED (1 << 0)
+#define MONITOR_EVENT_SENSOR_SAMPLE (1 << 1)
+// 待机状态下的上传间隔
+#define IDLE_UPLOAD_INTERVAL_US (10 * 1000 * 1000)
+
 class CompactWifiBoardLCD : public WifiBoard {
 private:
 
     Button boot_button_;
     LcdDisplay* display_;
     SHT30Sensor* sht30_sensor_;
+    SensorHistory* sensor_history_;
     SensorDataUploader* sensor_uploader_;
 
     // 上一次的设备状态，用于检测状态变化
     DeviceState last_device_state_;
 
-    // 上次上传时间计数器
-    int upload_counter_;
+    // 状态监控任务，由状态变化和传感器采样事件唤醒
+    TaskHandle_t monitor_task_;
+
+    // 上次上传的时间
+    int64_t last_upload_time_us_;
 
     void InitializeSpi() {
         spi_bus_config_t buscfg = {};
@@ -158,6 +170,8 @@ private:
 
             // 温度校准：显示值比实际高1度，设置偏移-1度
             sht30_sensor_->SetTemperatureOffset(-1.0f);
+            // SHT30 主动上报，不需要轮询
+            SensorManager::GetInstance().AddSensor(sht30_sensor_, 0);
 
             // 注册 MCP 工具
             auto& mcp_server = McpServer::GetInstance();
@@ -176,13 +190,42 @@ private:
                     return result;
                 });
 
+            // 温湿度历史记录（最近1小时每秒、24小时每分钟、30天每小时）
+            sensor_history_ = new SensorHistory(sht30_sensor_);
+            mcp_server.AddTool("sensor.get_temperature_humidity_history",
+                "查询最近一段时间的温度和湿度统计（最小值、最大值、平均值），例如今天的最高温度。\n"
+                "参数 hours: 从现在往前的整小时数（1-720）；查询今天的数据时传入从0点到现在的小时数（向上取整）。\n"
+                "最近1小时按秒统计，24小时内按分钟统计，更早的部分按整点小时统计（重启前超过2天的数据按天统计）；"
+                "返回的 start_time 是统计到的最早数据的时间（Unix时间，秒）",
+                PropertyList({
+                    Property("hours", kPropertyTypeInteger, 24, 1, SENSOR_HISTORY_HOURS)
+                }),
+                [this](const PropertyList& properties) -> ReturnValue {
+                    uint32_t now = time(nullptr);
+                    uint32_t from = now - properties["hours"].value<int>() * 3600;
+                    SensorRollup rollup;
+                    if (!sensor_history_->Query(from, now + 1, &rollup)) {
+                        return std::string("{\"error\": \"No history data\"}");
+                    }
+                    cJSON* result = cJSON_CreateObject();
+                    cJSON_AddNumberToObject(result, "start_time", rollup.time);
+                    cJSON_AddNumberToObject(result, "samples", rollup.count);
+                    cJSON_AddNumberToObject(result, "temperature_min", rollup.temperature_min / 100.0);
+                    cJSON_AddNumberToObject(result, "temperature_max", rollup.temperature_max / 100.0);
+                    cJSON_AddNumberToObject(result, "temperature_avg", rollup.temperature_avg / 100.0);
+                    cJSON_AddNumberToObject(result, "humidity_min", rollup.humidity_min / 100.0);
+                    cJSON_AddNumberToObject(result, "humidity_max", rollup.humidity_max / 100.0);
+                    cJSON_AddNumberToObject(result, "humidity_avg", rollup.humidity_avg / 100.0);
+                    return result;
+                });
+
             // 初始化温湿度数据上传器
             InitializeSensorUploader();
         } else {
             ESP_LOGW(TAG, "SHT30 sensor initialization failed");
         }
 
-        // 启动设备状态监控定时器
+        // 启动设备状态监控任务
         StartDeviceStateMonitor();
     }
 
@@ -212,10 +255,14 @@ private:
                  upload_url.c_str(), device_id.c_str());
     }
 
-    // 设备状态监控定时器回调
-    static void DeviceStateMonitorCallback(void* arg) {
-        CompactWifiBoardLCD* board = static_cast<CompactWifiBoardLCD*>(arg);
-        board->CheckDeviceState();
+    // 设备状态监控任务：状态变化或有新的采样时刷新界面和上传
+    // 在独立的低优先级任务中运行，不占用共享的esp_timer任务
+    void DeviceStateMonitorTask() {
+        while (true) {
+            // 传感器离线时不会有采样事件，超时后也检查一次，显示占位符
+            xTaskNotifyWait(0, UINT32_MAX, nullptr, pdMS_TO_TICKS(SENSOR_SAMPLE_TIMEOUT_MS));
+            CheckDeviceState();
+        }
     }
 
     // 检查设备状态并切换界面
@@ -223,7 +270,7 @@ private:
         auto& app = Application::GetInstance();
         DeviceState current_state = app.GetDeviceState();
 
-        ESP_LOGI(TAG, "CheckDeviceState: current=%d, last=%d", current_state, last_device_state_);
+        ESP_LOGD(TAG, "CheckDeviceState: current=%d, last=%d", current_state, last_device_state_);
 
         // 检测状态变化
         if (current_state != last_device_state_) {
@@ -241,7 +288,7 @@ private:
                         float temp, humi;
                         if (sht30_sensor_->ReadData(&temp, &humi)) {
                             ESP_LOGI(TAG, "Uploading idle status: temp=%.1f, humi=%.1f", temp, humi);
-                            sensor_uploader_->UploadSensorData(temp, humi, 0, nullptr); // status=0: 待机
+                            sensor_uploader_->UploadSensorDataAsync(temp, humi, 0); // status=0: 待机
                         }
                     }
                     break;
@@ -257,7 +304,7 @@ private:
                         float temp, humi;
                         if (sht30_sensor_->ReadData(&temp, &humi)) {
                             ESP_LOGI(TAG, "Uploading activating status: temp=%.1f, humi=%.1f", temp, humi);
-                            sensor_uploader_->UploadSensorData(temp, humi, 1, nullptr); // status=1: 唤醒中
+                            sensor_uploader_->UploadSensorDataAsync(temp, humi, 1); // status=1: 唤醒中
                         }
                     }
                     break;
@@ -270,14 +317,14 @@ private:
                         ESP_LOGI(TAG, "Listening/Speaking state - hiding standby screen");
                         display_->HideStandbyScreen();
                     }
-                    upload_counter_ = 0; // 重置上传计数
+                    last_upload_time_us_ = esp_timer_get_time(); // 重新开始待机上传计时
                     // 上传录音/播放状态
                     if (sensor_uploader_ && sht30_sensor_ && sht30_sensor_->IsInitialized()) {
                         float temp, humi;
                         if (sht30_sensor_->ReadData(&temp, &humi)) {
                             int status = (current_state == kDeviceStateListening) ? 2 : 3; // status=2: 录音中, status=3: 播放中
                             ESP_LOGI(TAG, "Uploading %s status: temp=%.1f, humi=%.1f", (status == 2) ? "listening" : "speaking", temp, humi);
-                            sensor_uploader_->UploadSensorData(temp, humi, status, nullptr);
+                            sensor_uploader_->UploadSensorDataAsync(temp, humi, status);
                         }
                     }
                     break;
@@ -292,13 +339,13 @@ private:
                         ESP_LOGI(TAG, "Configuring/Connecting state - hiding standby screen");
                         display_->HideStandbyScreen();
                     }
-                    upload_counter_ = 0; // 重置上传计数
+                    last_upload_time_us_ = esp_timer_get_time(); // 重新开始待机上传计时
                     // 上传配置中状态
                     if (sensor_uploader_ && sht30_sensor_ && sht30_sensor_->IsInitialized()) {
                         float temp, humi;
                         if (sht30_sensor_->ReadData(&temp, &humi)) {
                             ESP_LOGI(TAG, "Uploading configuring status: temp=%.1f, humi=%.1f", temp, humi);
-                            sensor_uploader_->UploadSensorData(temp, humi, 4, nullptr); // status=4: 配置中
+                            sensor_uploader_->UploadSensorDataAsync(temp, humi, 4); // status=4: 配置中
                         }
                     }
                     break;
@@ -328,23 +375,22 @@ private:
             if (sht30_sensor_ && sht30_sensor_->IsInitialized()) {
                 float temp, humi;
                 if (sht30_sensor_->ReadData(&temp, &humi)) {
-                    ESP_LOGI(TAG, "SHT30 read successful: temp=%.1f°C, humi=%.1f%%", temp, humi);
+                    ESP_LOGD(TAG, "SHT30 read successful: temp=%.1f°C, humi=%.1f%%", temp, humi);
                     display_->UpdateStandbyTemperatureHumidity(temp, humi);
 
                     // 上传温湿度数据到云服务器（仅在待机状态下上传）
                     // 待机状态下没有其他任务，可以加快上传频率，提高数据实时性
                     // 这样可以避免在上传时阻塞小智唤醒和语音交互
                     if (current_state == kDeviceStateIdle) {
-                        upload_counter_++;
-                        if (upload_counter_ >= 10) { // 10秒上传一次（待机状态）
-                            ESP_LOGI(TAG, "Upload counter reached %d, attempting upload", upload_counter_);
+                        int64_t now = esp_timer_get_time();
+                        if (now - last_upload_time_us_ >= IDLE_UPLOAD_INTERVAL_US) { // 10秒上传一次（待机状态）
                             if (sensor_uploader_) {
-                                ESP_LOGI(TAG, "Calling UploadSensorData: temp=%.1f, humi=%.1f", temp, humi);
-                                sensor_uploader_->UploadSensorData(temp, humi, 0, nullptr); // status=0: 待机
+                                ESP_LOGI(TAG, "Queueing sensor upload: temp=%.1f, humi=%.1f", temp, humi);
+                                sensor_uploader_->UploadSensorDataAsync(temp, humi, 0); // status=0: 待机
                             } else {
                                 ESP_LOGW(TAG, "Sensor uploader not available (sensor_uploader_=%p)", (void*)sensor_uploader_);
                             }
-                            upload_counter_ = 0;
+                            last_upload_time_us_ = now;
                         }
                     } else {
                         ESP_LOGD(TAG, "Device not idle (state=%d), skipping sensor upload", current_state);
@@ -364,18 +410,18 @@ private:
 
     // 启动设备状态监控
     void StartDeviceStateMonitor() {
-        esp_timer_handle_t timer;
-        esp_timer_create_args_t timer_args = {
-            .callback = DeviceStateMonitorCallback,
-            .arg = this,
-            .dispatch_method = ESP_TIMER_TASK,
-            .name = "state_monitor",
-            .skip_unhandled_events = false,
-        };
-        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer));
-
-        // 每秒检查一次状态
-        ESP_ERROR_CHECK(esp_timer_start_periodic(timer, 1000000)); // 1秒
+        xTaskCreate([](void* arg) {
+            static_cast<CompactWifiBoardLCD*>(arg)->DeviceStateMonitorTask();
+            vTaskDelete(NULL);
+        }, "state_monitor", 4096, this, 2, &monitor_task_);
+
+        // 状态变化和新的采样都只发送通知，界面刷新和上传在监控任务中进行
+        Application::GetInstance().AddStateChangeListener([this](DeviceState old_state, DeviceState new_state) {
+            xTaskNotify(monitor_task_, MONITOR_EVENT_STATE_CHANGED, eSetBits);
+        });
+        if (sht30_sensor_) {
+            sht30_sensor_->SetSampleNotify(monitor_task_, MONITOR_EVENT_SENSOR_SAMPLE);
+        }
         ESP_LOGI(TAG, "Device state monitor started");
     }
 
@@ -384,9 +430,11 @@ public:
         boot_button_(BOOT_BUTTON_GPIO),
         display_(nullptr),
         sht30_sensor_(nullptr),
+        sensor_history_(nullptr),
         sensor_uploader_(nullptr),
         last_device_state_(kDeviceStateUnknown),
-        upload_counter_(0) {
+        monitor_task_(nullptr),
+        last_upload_time_us_(0) {
         InitializeSpi();
         InitializeLcdDisplay();
         InitializeButtons();
@@ -407,12 +455,15 @@ public:
             if (sht30_sensor_->ReadData(&temp, &humi)) {
                 ESP_LOGI(TAG, "Initial upload: temp=%.1f°C, humi=%.1f%%", temp, humi);
                 display_->UpdateStandbyTemperatureHumidity(temp, humi);
-                sensor_uploader_->UploadSensorData(temp, humi, 0, nullptr); // status=0: 待机
+                sensor_uploader_->UploadSensorDataAsync(temp, humi, 0); // status=0: 待机
             }
         }
     }
 
     ~CompactWifiBoardLCD() {
+        if (sensor_history_) {
+            delete sensor_history_;
+        }
         if (sht30_sensor_) {
             delete sht30_sensor_;
         }
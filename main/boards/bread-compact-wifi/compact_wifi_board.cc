@@ -10,6 +10,7 @@
 #include "led/single_led.h"
 #include "assets/lang_config.h"
 #include "dht20_sensor.h"
+#include "sensor_manager.h"
 
 #include <esp_log.h>
 #include <driver/i2c_master.h>
@@ -157,6 +158,9 @@ private:
         dht20_sensor_ = new DHT20Sensor(display_i2c_bus_, DHT20_I2C_ADDR);
 
         if (dht20_sensor_->IsInitialized()) {
+            // 由 SensorManager 定期采样，MCP 工具只读取缓存
+            SensorManager::GetInstance().AddSensor(dht20_sensor_);
+
             auto& mcp_server = McpServer::GetInstance();
 
             // 注册 MCP 工具：读取温湿度
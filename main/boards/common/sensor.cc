@@ -0,0 +1,100 @@
+#include "sensor.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstdio>
+
+#define TAG "Sensor"
+
+void Sensor::Publish(int32_t temperature_x100, int32_t humidity_x100) {
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    temperature_x100_.store(temperature_x100, std::memory_order_relaxed);
+    humidity_x100_.store(humidity_x100, std::memory_order_relaxed);
+    sample_time_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+    ESP_LOGD(TAG, "%s: temperature: %.2f°C, humidity: %.2f%%", name_,
+        temperature_x100 / 100.0f, humidity_x100 / 100.0f);
+
+    TaskHandle_t task = notify_task_.load(std::memory_order_acquire);
+    if (task != nullptr) {
+        xTaskNotify(task, notify_bits_.load(std::memory_order_relaxed), eSetBits);
+    }
+}
+
+void Sensor::SetSampleNotify(TaskHandle_t task, uint32_t bits) {
+    notify_bits_.store(bits, std::memory_order_relaxed);
+    notify_task_.store(task, std::memory_order_release);
+}
+
+bool Sensor::LoadSample(int32_t* temperature_x100, int32_t* humidity_x100, int64_t* sample_time_us) const {
+    uint32_t before, after;
+    do {
+        before = sequence_.load(std::memory_order_acquire);
+        *temperature_x100 = temperature_x100_.load(std::memory_order_relaxed);
+        *humidity_x100 = humidity_x100_.load(std::memory_order_relaxed);
+        *sample_time_us = sample_time_us_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return before != 0;
+}
+
+bool Sensor::ReadData(float* temperature, float* humidity) {
+    int32_t temperature_x100, humidity_x100;
+    int64_t sample_time_us;
+    bool has_sample = LoadSample(&temperature_x100, &humidity_x100, &sample_time_us);
+    *temperature = temperature_x100 / 100.0f + temperature_offset_;
+    *humidity = humidity_x100 / 100.0f + humidity_offset_;
+    if (!has_sample) {
+        return false;
+    }
+    return esp_timer_get_time() - sample_time_us < SENSOR_SAMPLE_TIMEOUT_MS * 1000LL;
+}
+
+float Sensor::GetTemperature() {
+    float temp, hum;
+    ReadData(&temp, &hum);
+    return temp;
+}
+
+float Sensor::GetHumidity() {
+    float temp, hum;
+    ReadData(&temp, &hum);
+    return hum;
+}
+
+std::string Sensor::GetJsonData() {
+    float temp, hum;
+    if (ReadData(&temp, &hum)) {
+        char json[100];
+        snprintf(json, sizeof(json), "{\"temperature\": %.2f, \"humidity\": %.2f}", temp, hum);
+        return std::string(json);
+    }
+    return std::string("{\"error\": \"Failed to read ") + name_ + "\"}";
+}
+
+void Sensor::SetTemperatureOffset(float offset) {
+    temperature_offset_ = offset;
+    ESP_LOGI(TAG, "%s: temperature offset set to %.2f", name_, offset);
+}
+
+void Sensor::SetHumidityOffset(float offset) {
+    humidity_offset_ = offset;
+    ESP_LOGI(TAG, "%s: humidity offset set to %.2f", name_, offset);
+}
+
+void Sensor::CalibrateTemperature(float actual_temp) {
+    float current_temp = GetTemperature();
+    temperature_offset_ += actual_temp - current_temp;
+    ESP_LOGI(TAG, "%s: temperature calibrated: current=%.2f, actual=%.2f, offset=%.2f",
+             name_, current_temp, actual_temp, temperature_offset_);
+}
+
+void Sensor::CalibrateHumidity(float actual_humidity) {
+    float current_hum = GetHumidity();
+    humidity_offset_ += actual_humidity - current_hum;
+    ESP_LOGI(TAG, "%s: humidity calibrated: current=%.2f, actual=%.2f, offset=%.2f",
+             name_, current_hum, actual_humidity, humidity_offset_);
+}
@@ -0,0 +1,79 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 超过这个时间没有新的采样，认为传感器离线
+#define SENSOR_SAMPLE_TIMEOUT_MS 10000
+
+/*
+ * 温湿度传感器的公共接口
+ *
+ * 最新的采样缓存在这里（seqlock，读取不会阻塞，也不会访问硬件）。
+ * 主动上报的传感器（如UART的SHT30）在收到数据时调用Publish()；
+ * 需要轮询的传感器（如I2C的DHT20）实现Sample()，由SensorManager的任务按采样间隔调用。
+ * 校准偏移量在读取时加上，不影响缓存的原始值。
+ */
+class Sensor {
+public:
+    explicit Sensor(const char* name) : name_(name) {}
+    virtual ~Sensor() = default;
+
+    const char* name() const { return name_; }
+    virtual bool IsInitialized() const = 0;
+
+    // 执行一次硬件读取，成功时调用Publish()；只由SensorManager的任务调用
+    virtual bool Sample() { return false; }
+
+    // 每次有新的采样时用xTaskNotify(eSetBits)通知指定任务，传nullptr取消
+    void SetSampleNotify(TaskHandle_t task, uint32_t bits);
+
+    // 读取最新的温度和湿度；没有数据或数据已过期时返回false（输出上一次的值）
+    bool ReadData(float* temperature, float* humidity);
+    // 只读取温度
+    float GetTemperature();
+    // 只读取湿度
+    float GetHumidity();
+    // 获取 JSON 格式的数据
+    std::string GetJsonData();
+
+    // 设置温度校准偏移量（正数增加显示值，负数减少显示值）
+    void SetTemperatureOffset(float offset);
+    // 设置湿度校准偏移量（正数增加显示值，负数减少显示值）
+    void SetHumidityOffset(float offset);
+    float GetTemperatureOffset() const { return temperature_offset_; }
+    float GetHumidityOffset() const { return humidity_offset_; }
+
+    // 校准温度（设置偏移量使显示值等于实际值）
+    // actual_temp: 实际温度值（使用标准温度计测量）
+    void CalibrateTemperature(float actual_temp);
+    // 校准湿度（设置偏移量使显示值等于实际值）
+    // actual_humidity: 实际湿度值（使用标准湿度计测量）
+    void CalibrateHumidity(float actual_humidity);
+
+protected:
+    // 发布一次采样（定点数 x100），同一时间只能有一个写入者
+    void Publish(int32_t temperature_x100, int32_t humidity_x100);
+
+private:
+    const char* name_;
+    float temperature_offset_ = 0.0f;  // 温度校准偏移量
+    float humidity_offset_ = 0.0f;     // 湿度校准偏移量
+
+    // seqlock：写入时序号为奇数，读者发现序号变化就重读
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<int32_t> temperature_x100_{0};
+    std::atomic<int32_t> humidity_x100_{0};
+    std::atomic<int64_t> sample_time_us_{0};
+    std::atomic<TaskHandle_t> notify_task_{nullptr};
+    std::atomic<uint32_t> notify_bits_{0};
+
+    // 返回false表示还没有收到过数据
+    bool LoadSample(int32_t* temperature_x100, int32_t* humidity_x100, int64_t* sample_time_us) const;
+};
+
+#endif // SENSOR_H
@@ -0,0 +1,107 @@
+#include "sensor_history.h"
+#include "sensor_sample_queue.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+#define TAG "SensorHistory"
+
+// 温湿度历史快照和上传积压队列（SensorSampleQueue）与Wi-Fi等设置共用16KB的nvs分区，
+// 两者合计不超过一页（4KB），重写其中一份时旧数据和新数据都能放下
+static_assert(SENSOR_HISTORY_SNAPSHOT_MAX_SIZE + 4 + SENSOR_SAMPLE_QUEUE_SAVE_SAMPLES * sizeof(SensorSample) <= 4000,
+    "Sensor data does not fit in the NVS budget");
+
+SensorHistory::SensorHistory(Sensor* sensor) : sensor_(sensor) {
+    if (!store_.Allocate()) {
+        ESP_LOGE(TAG, "Failed to allocate history buffers");
+        return;
+    }
+    ESP_LOGI(TAG, "History buffers: %u bytes", store_.MemoryUsage());
+
+    task_exited_ = xSemaphoreCreateBinary();
+    xTaskCreate([](void* arg) {
+        SensorHistory* history = (SensorHistory*)arg;
+        history->HistoryTask();
+        xSemaphoreGive(history->task_exited_);
+        vTaskDelete(NULL);
+    }, "sensor_history", 3072, this, 1, &task_);
+}
+
+SensorHistory::~SensorHistory() {
+    if (task_ != nullptr) {
+        // 任务最多在1秒内看到stopping_，正在写NVS时等写完
+        stopping_ = true;
+        xSemaphoreTake(task_exited_, portMAX_DELAY);
+        vSemaphoreDelete(task_exited_);
+    }
+}
+
+void SensorHistory::HistoryTask() {
+    LoadSnapshot();
+
+    TickType_t last_wake = xTaskGetTickCount();
+    bool time_valid = false;
+    while (!stopping_) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(1000));
+
+        time_t now = time(nullptr);
+        struct tm tm;
+        localtime_r(&now, &tm);
+        if (tm.tm_year < 2025 - 1900) {
+            continue;
+        }
+        if (!time_valid) {
+            time_valid = true;
+            ESP_LOGI(TAG, "System time is set, start recording");
+        }
+
+        float temperature, humidity;
+        if (!sensor_->ReadData(&temperature, &humidity)) {
+            continue;
+        }
+        int16_t temperature_x100 = (int16_t)std::clamp<long>(lroundf(temperature * 100), INT16_MIN, INT16_MAX);
+        int16_t humidity_x100 = (int16_t)std::clamp<long>(lroundf(humidity * 100), 0, INT16_MAX);
+
+        bool hour_completed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            hour_completed = store_.AddSample((uint32_t)now, temperature_x100, humidity_x100);
+        }
+        // 每完成一个小时的汇总保存一次
+        if (hour_completed) {
+            SaveSnapshot();
+        }
+    }
+}
+
+bool SensorHistory::Query(uint32_t from, uint32_t to, SensorRollup* result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return store_.Query(from, to, result);
+}
+
+void SensorHistory::SaveSnapshot() {
+    std::vector<uint8_t> blob;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blob = store_.SaveSnapshot();
+    }
+    Settings settings("sensor_history", true);
+    if (!settings.SetBlob("hours", blob.data(), blob.size())) {
+        ESP_LOGW(TAG, "Failed to save %u rollups", (blob.size() - 4) / sizeof(SensorRollup));
+    }
+}
+
+void SensorHistory::LoadSnapshot() {
+    Settings settings("sensor_history");
+    auto blob = settings.GetBlob("hours");
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = store_.LoadSnapshot(blob);
+    if (count < 0) {
+        ESP_LOGW(TAG, "Invalid snapshot (%u bytes), discarded", blob.size());
+    } else if (count > 0) {
+        ESP_LOGI(TAG, "Loaded %d rollups", count);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include "sensor.h"
+#include "sensor_history_store.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/*
+ * 温湿度历史记录
+ *
+ * 每秒从Sensor的缓存取一次采样（不访问硬件），存入SensorHistoryStore
+ * （最近1小时的原始数据，以及按分钟、按小时汇总的最小/最大/平均值）。
+ * 每完成一个小时的汇总把快照保存到NVS，启动时恢复，重启后仍有30天的数据。
+ * 需要系统时间（SNTP）同步后才开始记录。
+ */
+class SensorHistory {
+public:
+    explicit SensorHistory(Sensor* sensor);
+    // 等待任务完成正在进行的NVS写入后退出
+    ~SensorHistory();
+
+    // 统计 [from, to) 时间范围内的数据，见SensorHistoryStore::Query
+    bool Query(uint32_t from, uint32_t to, SensorRollup* result);
+
+private:
+    Sensor* sensor_;
+    std::mutex mutex_;
+    SensorHistoryStore store_;
+    TaskHandle_t task_ = nullptr;
+    SemaphoreHandle_t task_exited_ = nullptr;
+    std::atomic<bool> stopping_ = false;
+
+    void HistoryTask();
+    void SaveSnapshot();
+    void LoadSnapshot();
+};
+
+#endif // SENSOR_HISTORY_H
@@ -0,0 +1,277 @@
+#include "sensor_history_store.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "SensorHistory"
+
+#define SENSOR_HISTORY_SNAPSHOT_VERSION 1
+// 原始数据中表示“绝对值在转义表中”的差值
+#define SENSOR_HISTORY_RAW_ESCAPE INT8_MIN
+
+template <typename T>
+void SensorHistoryStore::Ring<T>::Push(const T& item) {
+    if (count == capacity) {
+        head = (head + 1) % capacity;
+        count--;
+    }
+    items[(head + count) % capacity] = item;
+    count++;
+}
+
+void SensorHistoryStore::Accumulator::Add(const SensorRollup& rollup) {
+    count += rollup.count;
+    temperature_sum += (int64_t)rollup.temperature_avg * rollup.count;
+    humidity_sum += (int64_t)rollup.humidity_avg * rollup.count;
+    temperature_min = std::min(temperature_min, rollup.temperature_min);
+    temperature_max = std::max(temperature_max, rollup.temperature_max);
+    humidity_min = std::min(humidity_min, rollup.humidity_min);
+    humidity_max = std::max(humidity_max, rollup.humidity_max);
+}
+
+SensorRollup SensorHistoryStore::Accumulator::ToRollup() const {
+    SensorRollup rollup = {};
+    rollup.time = time;
+    rollup.count = count;
+    rollup.temperature_min = temperature_min;
+    rollup.temperature_max = temperature_max;
+    rollup.humidity_min = humidity_min;
+    rollup.humidity_max = humidity_max;
+    if (count > 0) {
+        rollup.temperature_avg = (int16_t)(temperature_sum / (int64_t)count);
+        rollup.humidity_avg = (int16_t)(humidity_sum / (int64_t)count);
+    }
+    return rollup;
+}
+
+static SensorRollup MakeSampleRollup(uint32_t time, int16_t temperature, int16_t humidity) {
+    return { time, 1, temperature, temperature, temperature, humidity, humidity, humidity };
+}
+
+template <typename T>
+bool SensorHistoryStore::AllocateRing(Ring<T>& ring, size_t capacity) {
+    // 优先使用PSRAM
+    ring.items = (T*)heap_caps_calloc_prefer(capacity, sizeof(T), 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    ring.capacity = ring.items ? capacity : 0;
+    return ring.items != nullptr;
+}
+
+SensorHistoryStore::~SensorHistoryStore() {
+    heap_caps_free(raw_.items);
+    heap_caps_free(minutes_.items);
+    heap_caps_free(hours_.items);
+}
+
+bool SensorHistoryStore::Allocate() {
+    // 完整的缓冲区约56KB，放在内部RAM中会挤占Wi-Fi和音频的内存
+    bool has_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+    if (!has_psram) {
+        ESP_LOGW(TAG, "No PSRAM, keeping %d minutes of samples, %d hours of minutes and %d days of hours",
+            SENSOR_HISTORY_INTERNAL_RAW_BLOCKS, SENSOR_HISTORY_INTERNAL_MINUTES / 60, SENSOR_HISTORY_INTERNAL_HOURS / 24);
+    }
+    return AllocateRing(raw_, has_psram ? SENSOR_HISTORY_RAW_BLOCKS : SENSOR_HISTORY_INTERNAL_RAW_BLOCKS) &&
+        AllocateRing(minutes_, has_psram ? SENSOR_HISTORY_MINUTES : SENSOR_HISTORY_INTERNAL_MINUTES) &&
+        AllocateRing(hours_, has_psram ? SENSOR_HISTORY_HOURS : SENSOR_HISTORY_INTERNAL_HOURS);
+}
+
+size_t SensorHistoryStore::MemoryUsage() const {
+    return raw_.capacity * sizeof(RawBlock) + (minutes_.capacity + hours_.capacity) * sizeof(SensorRollup);
+}
+
+void SensorHistoryStore::StartBlock(uint32_t minute, uint32_t offset, int16_t temperature, int16_t humidity,
+    bool continued) {
+    RawBlock block = {};
+    block.continued = continued;
+    block.start_time = minute;
+    block.present = 1ULL << offset;
+    block.temperature = temperature;
+    block.humidity = humidity;
+    block.last_offset = offset;
+    raw_.Push(block);
+    last_temperature_ = temperature;
+    last_humidity_ = humidity;
+}
+
+bool SensorHistoryStore::AddSample(uint32_t time, int16_t temperature, int16_t humidity) {
+    // 原始数据：同一分钟的采样放在同一块中，只保存差值
+    uint32_t minute = time - time % 60;
+    uint32_t offset = time % 60;
+    RawBlock* block = raw_.count > 0 ? &raw_.Back() : nullptr;
+    if (block != nullptr && time <= block->start_time + block->last_offset) {
+        // 同一秒内的重复采样，或者系统时间被往回调整
+        return false;
+    }
+    int temperature_delta = temperature - last_temperature_;
+    int humidity_delta = humidity - last_humidity_;
+    bool fits = temperature_delta >= -127 && temperature_delta <= 127 && humidity_delta >= -127 && humidity_delta <= 127;
+    if (block == nullptr || block->start_time != minute) {
+        StartBlock(minute, offset, temperature, humidity, false);
+    } else if (!fits && block->escape_count == SENSOR_HISTORY_RAW_BLOCK_ESCAPES) {
+        StartBlock(minute, offset, temperature, humidity, true);
+    } else {
+        if (fits) {
+            block->temperature_delta[offset] = (int8_t)temperature_delta;
+            block->humidity_delta[offset] = (int8_t)humidity_delta;
+        } else {
+            block->temperature_delta[offset] = SENSOR_HISTORY_RAW_ESCAPE;
+            block->escape_temperature[block->escape_count] = temperature;
+            block->escape_humidity[block->escape_count] = humidity;
+            block->escape_count++;
+        }
+        block->present |= 1ULL << offset;
+        block->last_offset = offset;
+        last_temperature_ = temperature;
+        last_humidity_ = humidity;
+    }
+
+    // 分钟汇总，完成的分钟再合并到小时汇总
+    bool hour_completed = false;
+    if (minute_.count > 0 && minute != minute_.time) {
+        SensorRollup rollup = minute_.ToRollup();
+        minutes_.Push(rollup);
+        minute_ = Accumulator();
+
+        uint32_t hour = rollup.time - rollup.time % 3600;
+        if (hour_.count > 0 && hour != hour_.time) {
+            hours_.Push(hour_.ToRollup());
+            hour_ = Accumulator();
+            hour_completed = true;
+        }
+        hour_.time = hour;
+        hour_.Add(rollup);
+    }
+    minute_.time = minute;
+    minute_.Add(MakeSampleRollup(time, temperature, humidity));
+    return hour_completed;
+}
+
+bool SensorHistoryStore::Query(uint32_t from, uint32_t to, SensorRollup* result) {
+    // 每一层只统计更细的一层没有覆盖的时间：[from, minutes_from) 用小时汇总，
+    // [minutes_from, raw_from) 用分钟汇总，[raw_from, to) 用原始数据
+    uint32_t raw_from = raw_.count > 0 ? raw_.At(0).start_time : UINT32_MAX;
+    // 最早一块的前半分钟已经被覆盖时，这一分钟用分钟汇总统计
+    if (raw_.count > 0 && raw_.At(0).continued) {
+        raw_from += SENSOR_HISTORY_RAW_BLOCK_SAMPLES;
+    }
+    uint32_t minutes_from = minutes_.count > 0 ? minutes_.At(0).time : minute_.count > 0 ? minute_.time : raw_from;
+    // 最早的分钟所在的小时已经完成汇总时由小时汇总统计，否则（例如刚启动）从最早的分钟开始统计
+    uint32_t first_hour_end = minutes_from - minutes_from % 3600 + 3600;
+    if (minutes_from != UINT32_MAX && hours_.count > 0 && hours_.Back().time + 3600 >= first_hour_end) {
+        minutes_from = first_hour_end;
+    }
+    raw_from = std::max(raw_from, minutes_from);
+
+    Accumulator total;
+    uint32_t first_time = UINT32_MAX;
+    auto add_in_range = [&](const SensorRollup& rollup, uint32_t range_from, uint32_t range_to) {
+        if (rollup.count > 0 && rollup.time >= std::max(from, range_from) && rollup.time < std::min(to, range_to)) {
+            total.Add(rollup);
+            first_time = std::min(first_time, rollup.time);
+        }
+    };
+
+    for (size_t i = 0; i < hours_.count; i++) {
+        add_in_range(hours_.At(i), 0, minutes_from);
+    }
+    for (size_t i = 0; i < minutes_.count; i++) {
+        add_in_range(minutes_.At(i), minutes_from, raw_from);
+    }
+    add_in_range(minute_.ToRollup(), minutes_from, raw_from);
+    for (size_t i = 0; i < raw_.count; i++) {
+        const RawBlock& block = raw_.At(i);
+        if (block.start_time >= to || block.start_time + SENSOR_HISTORY_RAW_BLOCK_SAMPLES <= from) {
+            continue;
+        }
+        int16_t temperature = block.temperature;
+        int16_t humidity = block.humidity;
+        size_t escape = 0;
+        bool first = true;
+        for (uint32_t j = 0; j < SENSOR_HISTORY_RAW_BLOCK_SAMPLES; j++) {
+            if (!(block.present & (1ULL << j))) {
+                continue;
+            }
+            if (first) {
+                first = false;
+            } else if (block.temperature_delta[j] == SENSOR_HISTORY_RAW_ESCAPE) {
+                temperature = block.escape_temperature[escape];
+                humidity = block.escape_humidity[escape];
+                escape++;
+            } else {
+                temperature += block.temperature_delta[j];
+                humidity += block.humidity_delta[j];
+            }
+            add_in_range(MakeSampleRollup(block.start_time + j, temperature, humidity), raw_from, UINT32_MAX);
+        }
+    }
+
+    if (total.count == 0) {
+        return false;
+    }
+    total.time = first_time;
+    *result = total.ToRollup();
+    return true;
+}
+
+std::vector<uint8_t> SensorHistoryStore::SaveSnapshot() {
+    // 最近的小时汇总原样保存，之前30天内的按天合并
+    size_t hour_count = std::min<size_t>(hours_.count, SENSOR_HISTORY_SNAPSHOT_HOURS);
+    std::vector<SensorRollup> days;
+    if (hour_count > 0) {
+        uint32_t days_from = hours_.Back().time - SENSOR_HISTORY_SNAPSHOT_DAYS * 86400;
+        days_from -= days_from % 86400;
+        Accumulator day;
+        for (size_t i = 0; i < hours_.count - hour_count; i++) {
+            const SensorRollup& rollup = hours_.At(i);
+            if (rollup.time < days_from) {
+                continue;
+            }
+            uint32_t day_time = rollup.time - rollup.time % 86400;
+            if (day.count > 0 && day.time != day_time) {
+                days.push_back(day.ToRollup());
+                day = Accumulator();
+            }
+            day.time = day_time;
+            day.Add(rollup);
+        }
+        if (day.count > 0) {
+            days.push_back(day.ToRollup());
+        }
+        if (days.size() > SENSOR_HISTORY_SNAPSHOT_DAYS) {
+            days.erase(days.begin(), days.end() - SENSOR_HISTORY_SNAPSHOT_DAYS);
+        }
+    }
+
+    std::vector<uint8_t> blob(4 + (days.size() + hour_count) * sizeof(SensorRollup));
+    blob[0] = SENSOR_HISTORY_SNAPSHOT_VERSION;
+    blob[1] = (uint8_t)days.size();
+    uint8_t* out = blob.data() + 4;
+    for (const auto& rollup : days) {
+        memcpy(out, &rollup, sizeof(SensorRollup));
+        out += sizeof(SensorRollup);
+    }
+    for (size_t i = hours_.count - hour_count; i < hours_.count; i++) {
+        memcpy(out, &hours_.At(i), sizeof(SensorRollup));
+        out += sizeof(SensorRollup);
+    }
+    return blob;
+}
+
+int SensorHistoryStore::LoadSnapshot(const std::vector<uint8_t>& blob) {
+    if (blob.size() < 4) {
+        return blob.empty() ? 0 : -1;
+    }
+    size_t count = (blob.size() - 4) / sizeof(SensorRollup);
+    if (blob[0] != SENSOR_HISTORY_SNAPSHOT_VERSION || blob.size() != 4 + count * sizeof(SensorRollup) ||
+        blob[1] > count) {
+        return -1;
+    }
+    // 按天的汇总也放在小时汇总的环形缓冲区中，Query 只按起始时间区分
+    for (size_t i = 0; i < count && hours_.capacity > 0; i++) {
+        SensorRollup rollup;
+        memcpy(&rollup, blob.data() + 4 + i * sizeof(SensorRollup), sizeof(SensorRollup));
+        hours_.Push(rollup);
+    }
+    return (int)count;
+}
@@ -0,0 +1,130 @@
+#ifndef SENSOR_HISTORY_STORE_H
+#define SENSOR_HISTORY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 原始采样：每秒一次，保留64分钟（每个整分钟一块，块内差分编码）
+#define SENSOR_HISTORY_RAW_BLOCKS 64
+#define SENSOR_HISTORY_RAW_BLOCK_SAMPLES 60
+// 每块最多保存的绝对值采样（与上一个值的差超过±1.27时使用）
+#define SENSOR_HISTORY_RAW_BLOCK_ESCAPES 4
+// 分钟汇总保留24小时，小时汇总保留30天
+#define SENSOR_HISTORY_MINUTES (24 * 60)
+#define SENSOR_HISTORY_HOURS (30 * 24)
+// 没有PSRAM时缩小到16分钟原始数据、6小时分钟汇总、7天小时汇总（约13KB内部RAM）
+#define SENSOR_HISTORY_INTERNAL_RAW_BLOCKS 16
+#define SENSOR_HISTORY_INTERNAL_MINUTES (6 * 60)
+#define SENSOR_HISTORY_INTERNAL_HOURS (7 * 24)
+// 快照：最近2天的小时汇总，更早的（最多30天）合并为每天一条，约1.6KB
+#define SENSOR_HISTORY_SNAPSHOT_HOURS (2 * 24)
+#define SENSOR_HISTORY_SNAPSHOT_DAYS 30
+#define SENSOR_HISTORY_SNAPSHOT_MAX_SIZE (4 + (SENSOR_HISTORY_SNAPSHOT_DAYS + SENSOR_HISTORY_SNAPSHOT_HOURS) * sizeof(SensorRollup))
+
+// 一段时间内的统计（定点数 x100），time 为起始时间（Unix时间，秒）
+struct SensorRollup {
+    uint32_t time;
+    uint32_t count;
+    int16_t temperature_min;
+    int16_t temperature_max;
+    int16_t temperature_avg;
+    int16_t humidity_min;
+    int16_t humidity_max;
+    int16_t humidity_avg;
+};
+
+/*
+ * 温湿度历史的分层存储（不加锁，由SensorHistory的互斥锁保护）
+ *
+ * 最近的原始采样、按分钟和按小时汇总的最小/最大/平均值，数据优先放在PSRAM中。
+ * 原始数据每个整分钟一块：块头保存第一个采样，之后每秒保存与上一个值的差（int8，单位0.01），
+ * 加上位图和转义表每个采样约占2.7字节。差值放不下时（例如校准偏移量改变或更换传感器）写入转义码，
+ * 该秒的绝对值按顺序保存在块的转义表中；转义表用完后同一分钟开始新的一块。
+ * 所以原始数据总是精确的。漏掉的秒只在位图中标记为缺失。
+ */
+class SensorHistoryStore {
+public:
+    SensorHistoryStore() = default;
+    ~SensorHistoryStore();
+    SensorHistoryStore(const SensorHistoryStore&) = delete;
+    SensorHistoryStore& operator=(const SensorHistoryStore&) = delete;
+
+    // 分配缓冲区，没有PSRAM时使用较小的容量（会打印警告）
+    bool Allocate();
+    // 返回缓冲区占用的字节数
+    size_t MemoryUsage() const;
+    // 各层保留的时间（秒）
+    uint32_t raw_duration() const { return raw_.capacity * SENSOR_HISTORY_RAW_BLOCK_SAMPLES; }
+    uint32_t hours_duration() const { return hours_.capacity * 3600; }
+
+    // 返回true表示完成了一个小时的汇总
+    bool AddSample(uint32_t time, int16_t temperature, int16_t humidity);
+
+    // 统计 [from, to) 时间范围内的数据：原始数据覆盖的部分按秒，分钟汇总覆盖的部分按分钟，
+    // 更早的部分按小时（重启后超过2天的按天）。result->time 为统计到的最早数据的时间；没有数据时返回false
+    bool Query(uint32_t from, uint32_t to, SensorRollup* result);
+
+    // 快照：[0] 版本，[1] 按天的条数，[2-3] 保留，然后是按天、按小时的汇总（从旧到新）
+    std::vector<uint8_t> SaveSnapshot();
+    // 启动时恢复快照（在添加采样之前调用），返回恢复的条数，快照无效时返回-1
+    int LoadSnapshot(const std::vector<uint8_t>& blob);
+
+private:
+    struct RawBlock {
+        uint32_t start_time;    // 整分钟
+        uint64_t present;       // 第n位表示start_time + n秒有采样
+        int16_t temperature;    // 第一个采样
+        int16_t humidity;
+        uint8_t last_offset;    // 最后一个采样的秒
+        uint8_t escape_count;
+        bool continued;         // 同一分钟前一块的转义表用完后开始的块
+        // 下标为秒，与上一个采样的差；SENSOR_HISTORY_RAW_ESCAPE 表示绝对值在转义表中
+        int8_t temperature_delta[SENSOR_HISTORY_RAW_BLOCK_SAMPLES];
+        int8_t humidity_delta[SENSOR_HISTORY_RAW_BLOCK_SAMPLES];
+        int16_t escape_temperature[SENSOR_HISTORY_RAW_BLOCK_ESCAPES];
+        int16_t escape_humidity[SENSOR_HISTORY_RAW_BLOCK_ESCAPES];
+    };
+
+    // 汇总中的累加器
+    struct Accumulator {
+        uint32_t time = 0;
+        uint32_t count = 0;
+        int64_t temperature_sum = 0;
+        int64_t humidity_sum = 0;
+        int16_t temperature_min = INT16_MAX;
+        int16_t temperature_max = INT16_MIN;
+        int16_t humidity_min = INT16_MAX;
+        int16_t humidity_max = INT16_MIN;
+
+        void Add(const SensorRollup& rollup);
+        SensorRollup ToRollup() const;
+    };
+
+    template <typename T>
+    struct Ring {
+        T* items = nullptr;
+        size_t capacity = 0;
+        size_t head = 0;
+        size_t count = 0;
+
+        void Push(const T& item);
+        T& At(size_t index) { return items[(head + index) % capacity]; }
+        T& Back() { return At(count - 1); }
+    };
+
+    Ring<RawBlock> raw_;
+    Ring<SensorRollup> minutes_;
+    Ring<SensorRollup> hours_;
+    // 当前块最后一个采样的值
+    int16_t last_temperature_ = 0;
+    int16_t last_humidity_ = 0;
+    Accumulator minute_;
+    Accumulator hour_;
+
+    void StartBlock(uint32_t minute, uint32_t offset, int16_t temperature, int16_t humidity, bool continued);
+    template <typename T>
+    static bool AllocateRing(Ring<T>& ring, size_t capacity);
+};
+
+#endif // SENSOR_HISTORY_STORE_H
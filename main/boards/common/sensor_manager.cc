@@ -0,0 +1,93 @@
+#include "sensor_manager.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstring>
+
+#define TAG "SensorManager"
+
+void SensorManager::AddSensor(Sensor* sensor, int interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 新加入的传感器错开第一次采样
+    int64_t first_sample_us = esp_timer_get_time() + (int64_t)entries_.size() * SENSOR_STAGGER_MS * 1000;
+    entries_.push_back({ sensor, interval_ms, first_sample_us, 0, 0 });
+    ESP_LOGI(TAG, "Sensor %s added, interval: %d ms", sensor->name(), interval_ms);
+
+    if (interval_ms <= 0) {
+        return;
+    }
+    if (sampling_task_ == nullptr) {
+        xTaskCreate([](void* arg) {
+            SensorManager* manager = (SensorManager*)arg;
+            manager->SamplingTask();
+            vTaskDelete(NULL);
+        }, "sensor_sampling", 3072, this, 3, &sampling_task_);
+    } else {
+        xTaskNotifyGive(sampling_task_);
+    }
+}
+
+Sensor* SensorManager::GetSensor(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (strcmp(entry.sensor->name(), name) == 0) {
+            return entry.sensor;
+        }
+    }
+    return nullptr;
+}
+
+Sensor* SensorManager::GetDefaultSensor() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.empty() ? nullptr : entries_.front().sensor;
+}
+
+void SensorManager::SamplingTask() {
+    while (true) {
+        // 找到下一个到期的传感器
+        Sensor* sensor = nullptr;
+        size_t index = 0;
+        int64_t next_sample_us = INT64_MAX;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < entries_.size(); i++) {
+                auto& entry = entries_[i];
+                if (entry.interval_ms > 0 && entry.next_sample_us < next_sample_us) {
+                    next_sample_us = entry.next_sample_us;
+                    sensor = entry.sensor;
+                    index = i;
+                }
+            }
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (sensor == nullptr || next_sample_us > now) {
+            TickType_t wait = sensor == nullptr ? portMAX_DELAY : pdMS_TO_TICKS((next_sample_us - now) / 1000) + 1;
+            // AddSensor 会唤醒任务重新计算
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
+        }
+
+        bool success = sensor->IsInitialized() && sensor->Sample();
+        now = esp_timer_get_time();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = entries_[index];
+        if (success) {
+            entry.sample_count++;
+        } else if (++entry.failure_count % 10 == 1) {
+            ESP_LOGW(TAG, "Failed to sample %s (%lu failures)", sensor->name(), (unsigned long)entry.failure_count);
+        }
+        // 保持固定的采样节奏；落后太多时从现在重新开始
+        entry.next_sample_us += (int64_t)entry.interval_ms * 1000;
+        if (entry.next_sample_us < now) {
+            entry.next_sample_us = now;
+        }
+        // 与其他已经到期的传感器错开
+        for (auto& other : entries_) {
+            if (&other != &entry && other.interval_ms > 0 && other.next_sample_us < now + SENSOR_STAGGER_MS * 1000) {
+                other.next_sample_us = now + SENSOR_STAGGER_MS * 1000;
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef SENSOR_MANAGER_H
+#define SENSOR_MANAGER_H
+
+#include "sensor.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mutex>
+#include <vector>
+
+#define SENSOR_DEFAULT_INTERVAL_MS 2000
+// 同一轮到期的传感器之间至少间隔这么久，避免总线上的事务挤在一起
+#define SENSOR_STAGGER_MS 50
+
+/*
+ * 传感器采样调度
+ *
+ * 所有需要轮询的传感器在同一个任务中按各自的采样间隔读取，读取之间错开SENSOR_STAGGER_MS，
+ * 结果缓存在各个Sensor中。MCP工具、待机界面、上传等使用者只读取缓存，
+ * 硬件读取的次数只取决于采样间隔，与使用者的数量无关。
+ */
+class SensorManager {
+public:
+    static SensorManager& GetInstance() {
+        static SensorManager instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    SensorManager(const SensorManager&) = delete;
+    SensorManager& operator=(const SensorManager&) = delete;
+
+    // interval_ms 为0表示传感器主动上报，不需要轮询
+    void AddSensor(Sensor* sensor, int interval_ms = SENSOR_DEFAULT_INTERVAL_MS);
+    // 按名称查找传感器，找不到时返回nullptr
+    Sensor* GetSensor(const char* name);
+    // 第一个传感器（单传感器的板子使用）
+    Sensor* GetDefaultSensor();
+
+private:
+    struct SensorEntry {
+        Sensor* sensor;
+        int interval_ms;
+        int64_t next_sample_us;
+        uint32_t sample_count;
+        uint32_t failure_count;
+    };
+
+    std::mutex mutex_;
+    std::vector<SensorEntry> entries_;
+    TaskHandle_t sampling_task_ = nullptr;
+
+    SensorManager() = default;
+    ~SensorManager() = default;
+
+    void SamplingTask();
+};
+
+#endif // SENSOR_MANAGER_H
@@ -0,0 +1,95 @@
+#include "sht30_parser.h"
+
+// 解析定点数 "039.2" / "-05.35"，最多取两位小数，结果 x100
+static bool ParseFixed(const char*& p, const char* end, int32_t* value_x100) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    int32_t integer = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (digits++ >= 5) {
+            return false;
+        }
+        integer = integer * 10 + (*p++ - '0');
+    }
+    int32_t fraction = 0;
+    int fraction_digits = 0;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (fraction_digits < 2) {
+                fraction = fraction * 10 + (*p - '0');
+                fraction_digits++;
+            }
+            digits++;
+            p++;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    if (fraction_digits == 1) {
+        fraction *= 10;
+    }
+    int32_t value = integer * 100 + fraction;
+    *value_x100 = negative ? -value : value;
+    return true;
+}
+
+bool Sht30ParseLine(const char* line, size_t length, int32_t* humidity_x100, int32_t* temperature_x100) {
+    const char* end = line + length;
+    // 行首可能有噪声，找到 "R:"
+    const char* p = line;
+    while (p + 1 < end && !(p[0] == 'R' && p[1] == ':')) {
+        p++;
+    }
+    if (p + 1 >= end) {
+        return false;
+    }
+    p += 2;
+
+    int32_t humidity;
+    if (!ParseFixed(p, end, &humidity) || end - p < 2 || p[0] != 'R' || p[1] != 'H') {
+        return false;
+    }
+    p += 2;
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    int32_t temperature;
+    if (!ParseFixed(p, end, &temperature) || p >= end || *p != 'C') {
+        return false;
+    }
+    if (humidity < 0 || humidity > 10000) {
+        return false;
+    }
+
+    *humidity_x100 = humidity;
+    *temperature_x100 = temperature;
+    return true;
+}
+
+void Sht30LineFramer::Feed(const uint8_t* data, size_t size, const LineCallback& callback) {
+    for (size_t i = 0; i < size; i++) {
+        char c = (char)data[i];
+        if (c == '\n' || c == '\r') {
+            if (!overflow_ && length_ > 0) {
+                callback(line_, length_);
+            }
+            length_ = 0;
+            overflow_ = false;
+        } else if (length_ < sizeof(line_)) {
+            line_[length_++] = c;
+        } else {
+            overflow_ = true;
+        }
+    }
+}
+
+void Sht30LineFramer::Reset() {
+    length_ = 0;
+    overflow_ = false;
+}
@@ -0,0 +1,28 @@
+#ifndef SHT30_PARSER_H
+#define SHT30_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#define SHT30_MAX_LINE_LENGTH 32
+
+// 解析 SHT30 模块上报的一行数据: "R:039.2RH 023.3C"
+// 结果为定点数（x100），例如 39.2% -> 3920, 23.3°C -> 2330
+bool Sht30ParseLine(const char* line, size_t length, int32_t* humidity_x100, int32_t* temperature_x100);
+
+// 把UART字节流按行切分，每收到一行调用一次回调；过长的行被丢弃
+class Sht30LineFramer {
+public:
+    using LineCallback = std::function<void(const char* line, size_t length)>;
+
+    void Feed(const uint8_t* data, size_t size, const LineCallback& callback);
+    void Reset();
+
+private:
+    char line_[SHT30_MAX_LINE_LENGTH];
+    size_t length_ = 0;
+    bool overflow_ = false;
+};
+
+#endif // SHT30_PARSER_H
@@ -0,0 +1,115 @@
+#include "sht30_sensor.h"
+
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "SHT30"
+
+#define SHT30_UART_RX_BUFFER_SIZE 512
+#define SHT30_UART_QUEUE_SIZE 8
+
+SHT30Sensor::SHT30Sensor(uart_port_t uart_port, int tx_pin, int rx_pin, int baud_rate)
+    : Sensor("SHT30"), uart_port_(uart_port) {
+    // 配置 UART
+    uart_config_t uart_config = {
+        .baud_rate = baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    // 安装 UART 驱动，数据到达时通过事件队列通知读取任务
+    esp_err_t ret = uart_driver_install(uart_port_, SHT30_UART_RX_BUFFER_SIZE, 0,
+        SHT30_UART_QUEUE_SIZE, &uart_queue_, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    // 配置 UART 参数
+    ret = uart_param_config(uart_port_, &uart_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to config UART: %s", esp_err_to_name(ret));
+        uart_driver_delete(uart_port_);
+        return;
+    }
+
+    // 设置 UART 引脚
+    ret = uart_set_pin(uart_port_, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set UART pins: %s", esp_err_to_name(ret));
+        uart_driver_delete(uart_port_);
+        return;
+    }
+
+    reader_task_exited_ = xSemaphoreCreateBinary();
+    xTaskCreate([](void* arg) {
+        SHT30Sensor* sensor = (SHT30Sensor*)arg;
+        sensor->ReaderTask();
+        xSemaphoreGive(sensor->reader_task_exited_);
+        vTaskDelete(NULL);
+    }, "sht30_reader", 2560, this, 3, &reader_task_);
+
+    initialized_ = true;
+    ESP_LOGI(TAG, "SHT30 initialized on UART_NUM_%d (TX:GPIO%d, RX:GPIO%d, %d baud)",
+             uart_port, tx_pin, rx_pin, baud_rate);
+}
+
+SHT30Sensor::~SHT30Sensor() {
+    if (!initialized_) {
+        return;
+    }
+    // UART_EVENT_MAX 通知读取任务退出
+    uart_event_t event = {};
+    event.type = UART_EVENT_MAX;
+    xQueueSend(uart_queue_, &event, portMAX_DELAY);
+    xSemaphoreTake(reader_task_exited_, portMAX_DELAY);
+    vSemaphoreDelete(reader_task_exited_);
+    uart_driver_delete(uart_port_);
+}
+
+void SHT30Sensor::ReaderTask() {
+    uint8_t buffer[64];
+    auto on_line = [this](const char* line, size_t length) {
+        int32_t humidity, temperature;
+        if (Sht30ParseLine(line, length, &humidity, &temperature)) {
+            Publish(temperature, humidity);
+        } else {
+            ESP_LOGW(TAG, "Invalid data: %.*s", (int)length, line);
+        }
+    };
+
+    uart_event_t event;
+    while (true) {
+        if (xQueueReceive(uart_queue_, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        switch (event.type) {
+        case UART_DATA: {
+            size_t remaining = event.size;
+            while (remaining > 0) {
+                int len = uart_read_bytes(uart_port_, buffer, std::min(remaining, sizeof(buffer)), 0);
+                if (len <= 0) {
+                    break;
+                }
+                framer_.Feed(buffer, len, on_line);
+                remaining -= len;
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            ESP_LOGW(TAG, "UART overflow, flushing input");
+            uart_flush_input(uart_port_);
+            xQueueReset(uart_queue_);
+            framer_.Reset();
+            break;
+        case UART_EVENT_MAX:
+            return;
+        default:
+            break;
+        }
+    }
+}
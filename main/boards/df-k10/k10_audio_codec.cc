@@ -3,7 +3,8 @@
 #include <esp_log.h>
 #include <driver/i2c_master.h>
 #include <driver/i2s_tdm.h>
-#include <cmath>
+
+#include "pcm_kernels.h"
 
 static const char TAG[] = "K10AudioCodec";
 
@@ -201,20 +202,12 @@ int K10AudioCodec::Write(const int16_t* data, int samples) {
     if (output_enabled_) {
         std::vector<int32_t> buffer(samples * 2);  // Allocate buffer for 2x samples
 
-        // Apply volume adjustment (same as before)
-        int32_t volume_factor = pow(double(output_volume_) / 100.0, 2) * 65536;
+        // Scale into the upper half, then repeat each sample for slow playback (assuming mono audio)
+        PcmScaleToInt32(data, buffer.data() + samples, samples, PcmVolumeToGain(output_volume_));
         for (int i = 0; i < samples; i++) {
-            int64_t temp = int64_t(data[i]) * volume_factor;
-            if (temp > INT32_MAX) {
-            buffer[i * 2] = INT32_MAX;
-            } else if (temp < INT32_MIN) {
-            buffer[i * 2] = INT32_MIN;
-            } else {
-            buffer[i * 2] = static_cast<int32_t>(temp);
-            }
-
-            // Repeat each sample for slow playback (assuming mono audio)
-            buffer[i * 2 + 1] = buffer[i * 2];
+            int32_t sample = buffer[samples + i];
+            buffer[i * 2] = sample;
+            buffer[i * 2 + 1] = sample;
         }
 
         size_t bytes_written;
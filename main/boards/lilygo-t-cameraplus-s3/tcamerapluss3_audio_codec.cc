@@ -6,6 +6,7 @@
 #include <driver/i2s_pdm.h>
 
 #include "config.h"
+#include "pcm_kernels.h"
 
 static const char TAG[] = "Tcamerapluss3AudioCodec";
 
@@ -146,11 +147,7 @@ int Tcamerapluss3AudioCodec::Read(int16_t *dest, int samples) {
         i2s_channel_read(rx_handle_, dest, samples * sizeof(int16_t), &bytes_read, portMAX_DELAY);
         
         // 麦克风接收音量放大20倍（限制在 int16_t 范围内防止溢出）
-        int16_t *ptr = dest;
-        for (int i = 0; i < samples; i++) {
-            int32_t amplified = *ptr * 20;
-            *ptr++ = (amplified > 32767) ? 32767 : (amplified < -32768) ? -32768 : amplified;
-        }
+        PcmApplyGain(dest, samples, 20);
     }
     return samples;
 }
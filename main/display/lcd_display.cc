@@ -1291,6 +1291,7 @@ void LcdDisplay::HideStandbyScreen() {
 }
 
 void LcdDisplay::UpdateStandbyTemperatureHumidity(float temperature, float humidity) {
+    DisplayLockGuard lock(this);
     if (standby_screen_) {
         standby_screen_->UpdateTemperatureHumidity(temperature, humidity);
     }
@@ -3,16 +3,27 @@
 #include "board.h"
 #include <esp_log.h>
 #include <esp_sntp.h>
+#include <esp_heap_caps.h>
 #include <time.h>
 #include <sys/time.h>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 #define TAG "StandbyScreen"
 
 LV_FONT_DECLARE(font_puhui_20_4);
 LV_FONT_DECLARE(font_awesome_20_4);
 
+// 只在文字变化时更新标签，lv_label_set_text 即使文字相同也会让整个标签重绘
+static void SetLabelText(lv_obj_t* label, char* shown, size_t shown_size, const char* text) {
+    if (strcmp(shown, text) == 0) {
+        return;
+    }
+    snprintf(shown, shown_size, "%s", text);
+    lv_label_set_text(label, text);
+}
+
 StandbyScreen::StandbyScreen(int width, int height)
     : width_(width)
     , height_(height)
@@ -20,7 +31,8 @@ StandbyScreen::StandbyScreen(int width, int height)
     , container_(nullptr)
     , date_label_(nullptr)
     , weekday_label_(nullptr)
-    , time_label_(nullptr)
+    , time_box_(nullptr)
+    , time_digits_{}
     , temperature_label_(nullptr)
     , humidity_label_(nullptr)
     , temp_icon_(nullptr)
@@ -28,7 +40,15 @@ StandbyScreen::StandbyScreen(int width, int height)
     , divider_line_(nullptr)
     , update_timer_(nullptr)
     , current_temperature_(NAN)
-    , current_humidity_(NAN) {
+    , current_humidity_(NAN)
+    , clock_glyphs_{}
+    , clock_glyph_data_(nullptr)
+    , shown_date_{}
+    , shown_weekday_{}
+    , shown_time_{}
+    , shown_temperature_{}
+    , shown_humidity_{}
+    , shown_temperature_color_(0) {
 
     // 不设置时区
     // 我们会在显示时手动调整时间
@@ -53,6 +73,114 @@ StandbyScreen::~StandbyScreen() {
         esp_timer_stop(update_timer_);
         esp_timer_delete(update_timer_);
     }
+    if (clock_glyph_data_ != nullptr) {
+        heap_caps_free(clock_glyph_data_);
+    }
+}
+
+void StandbyScreen::CreateClockGlyphs(const lv_font_t* font) {
+    if (clock_glyph_data_ != nullptr) {
+        return;
+    }
+
+    // 数字使用相同的宽度，这样时间变化时每一位的位置不变，只需要重绘变化的那一位
+    const char* glyphs = STANDBY_CLOCK_GLYPHS;
+    int digit_width = 0;
+    for (char c = '0'; c <= '9'; c++) {
+        digit_width = std::max<int>(digit_width, lv_font_get_glyph_width(font, c, 0));
+    }
+    int src_height = lv_font_get_line_height(font);
+    int src_widths[STANDBY_CLOCK_GLYPH_COUNT];
+    int max_src_width = 0;
+    size_t total_size = 0;
+    for (size_t i = 0; i < STANDBY_CLOCK_GLYPH_COUNT; i++) {
+        src_widths[i] = glyphs[i] == ':' ? lv_font_get_glyph_width(font, ':', 0) : digit_width;
+        max_src_width = std::max(max_src_width, src_widths[i]);
+        int width = src_widths[i] * STANDBY_CLOCK_SCALE / 256;
+        int height = src_height * STANDBY_CLOCK_SCALE / 256;
+        total_size += width * height * sizeof(uint16_t);
+    }
+
+    clock_glyph_data_ = (uint8_t*)heap_caps_malloc(total_size, MALLOC_CAP_8BIT);
+    if (clock_glyph_data_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for clock glyphs", total_size);
+        return;
+    }
+
+    // 先用原始字体画到隐藏的画布上，再按覆盖率（绿色通道）双线性插值放大
+    lv_draw_buf_t* draw_buf = lv_draw_buf_create(max_src_width, src_height, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
+    if (draw_buf == nullptr) {
+        ESP_LOGE(TAG, "Failed to create draw buffer for clock glyphs");
+        heap_caps_free(clock_glyph_data_);
+        clock_glyph_data_ = nullptr;
+        return;
+    }
+    lv_obj_t* canvas = lv_canvas_create(lv_screen_active());
+    lv_obj_add_flag(canvas, LV_OBJ_FLAG_HIDDEN);
+    lv_canvas_set_draw_buf(canvas, draw_buf);
+
+    uint8_t* data = clock_glyph_data_;
+    for (size_t i = 0; i < STANDBY_CLOCK_GLYPH_COUNT; i++) {
+        char text[2] = {glyphs[i], '\0'};
+        lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_COVER);
+        lv_layer_t layer;
+        lv_canvas_init_layer(canvas, &layer);
+        lv_draw_label_dsc_t label_dsc;
+        lv_draw_label_dsc_init(&label_dsc);
+        label_dsc.font = font;
+        label_dsc.color = lv_color_white();
+        label_dsc.align = LV_TEXT_ALIGN_CENTER;
+        label_dsc.text = text;
+        lv_area_t area = {0, 0, src_widths[i] - 1, src_height - 1};
+        lv_draw_label(&layer, &label_dsc, &area);
+        lv_canvas_finish_layer(canvas, &layer);
+
+        int width = src_widths[i] * STANDBY_CLOCK_SCALE / 256;
+        int height = src_height * STANDBY_CLOCK_SCALE / 256;
+        uint16_t* dst = (uint16_t*)data;
+        for (int y = 0; y < height; y++) {
+            float sy = std::clamp((y + 0.5f) * 256 / STANDBY_CLOCK_SCALE - 0.5f, 0.0f, src_height - 1.0f);
+            int y0 = (int)sy;
+            int y1 = std::min(y0 + 1, src_height - 1);
+            float fy = sy - y0;
+            const uint16_t* row0 = (const uint16_t*)(draw_buf->data + y0 * draw_buf->header.stride);
+            const uint16_t* row1 = (const uint16_t*)(draw_buf->data + y1 * draw_buf->header.stride);
+            for (int x = 0; x < width; x++) {
+                float sx = std::clamp((x + 0.5f) * 256 / STANDBY_CLOCK_SCALE - 0.5f, 0.0f, src_widths[i] - 1.0f);
+                int x0 = (int)sx;
+                int x1 = std::min(x0 + 1, src_widths[i] - 1);
+                float fx = sx - x0;
+                auto coverage = [](uint16_t pixel) { return ((pixel >> 5) & 0x3F) * 255 / 63; };
+                float top = coverage(row0[x0]) * (1 - fx) + coverage(row0[x1]) * fx;
+                float bottom = coverage(row1[x0]) * (1 - fx) + coverage(row1[x1]) * fx;
+                uint8_t value = (uint8_t)(top * (1 - fy) + bottom * fy + 0.5f);
+                dst[y * width + x] = ((value >> 3) << 11) | ((value >> 2) << 5) | (value >> 3);
+            }
+        }
+
+        lv_image_dsc_t& dsc = clock_glyphs_[i];
+        dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+        dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+        dsc.header.w = width;
+        dsc.header.h = height;
+        dsc.header.stride = width * sizeof(uint16_t);
+        dsc.data_size = width * height * sizeof(uint16_t);
+        dsc.data = data;
+        data += dsc.data_size;
+    }
+
+    lv_obj_delete(canvas);
+    lv_draw_buf_destroy(draw_buf);
+    ESP_LOGI(TAG, "Clock glyphs rendered: %d x %d per digit, %u bytes",
+             (int)clock_glyphs_[0].header.w, (int)clock_glyphs_[0].header.h, total_size);
+}
+
+const lv_image_dsc_t* StandbyScreen::GetClockGlyph(char c) const {
+    const char* glyph = strchr(STANDBY_CLOCK_GLYPHS, c);
+    if (c == '\0' || glyph == nullptr) {
+        glyph = strchr(STANDBY_CLOCK_GLYPHS, '-');
+    }
+    return &clock_glyphs_[glyph - STANDBY_CLOCK_GLYPHS];
 }
 
 void StandbyScreen::CreateUI() {
@@ -93,18 +221,26 @@ void StandbyScreen::CreateUI() {
     // 使用顶部居中对齐，Y轴位置基于date_label的底部
     lv_obj_align(weekday_label_, LV_ALIGN_TOP_MID, 0, 16 + 8 + text_font->line_height);
 
-    // 第三行：时钟（屏幕中央偏左）
-    time_label_ = lv_label_create(container_);
-    lv_label_set_text(time_label_, "--:--");
-    lv_obj_set_style_text_font(time_label_, text_font, 0);
-    lv_obj_set_style_text_color(time_label_, lv_color_white(), 0);
-    lv_obj_set_style_text_align(time_label_, LV_TEXT_ALIGN_CENTER, 0);
-    
-    // 放大字体
-    lv_obj_set_style_transform_scale(time_label_, 400, 0);
-    
-    // 定位到屏幕中央偏左
-    lv_obj_align(time_label_, LV_ALIGN_CENTER, -20, 0);
+    // 第三行：时钟（屏幕中央），每一位是一个预渲染的放大数字图像
+    CreateClockGlyphs(text_font);
+    if (clock_glyph_data_ != nullptr) {
+        time_box_ = lv_obj_create(container_);
+        lv_obj_set_style_bg_opa(time_box_, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_border_width(time_box_, 0, 0);
+        lv_obj_set_style_pad_all(time_box_, 0, 0);
+        lv_obj_set_scrollbar_mode(time_box_, LV_SCROLLBAR_MODE_OFF);
+        snprintf(shown_time_, sizeof(shown_time_), "--:--:--");
+        int x = 0;
+        for (int i = 0; i < STANDBY_CLOCK_LENGTH; i++) {
+            const lv_image_dsc_t* glyph = GetClockGlyph(shown_time_[i]);
+            time_digits_[i] = lv_image_create(time_box_);
+            lv_image_set_src(time_digits_[i], glyph);
+            lv_obj_set_pos(time_digits_[i], x, 0);
+            x += glyph->header.w;
+        }
+        lv_obj_set_size(time_box_, x, clock_glyphs_[0].header.h);
+        lv_obj_align(time_box_, LV_ALIGN_CENTER, 0, 0);
+    }
 
     // 第三行：温湿度（底部左右）
     // 左边：温度
@@ -142,13 +278,20 @@ void StandbyScreen::DestroyUI() {
         container_ = nullptr;
         date_label_ = nullptr;
         weekday_label_ = nullptr;
-        time_label_ = nullptr;
+        time_box_ = nullptr;
+        std::fill(std::begin(time_digits_), std::end(time_digits_), nullptr);
         temperature_label_ = nullptr;
         humidity_label_ = nullptr;
         temp_icon_ = nullptr;
         humidity_icon_ = nullptr;
         divider_line_ = nullptr;
     }
+    shown_date_[0] = '\0';
+    shown_weekday_[0] = '\0';
+    shown_time_[0] = '\0';
+    shown_temperature_[0] = '\0';
+    shown_humidity_[0] = '\0';
+    shown_temperature_color_ = 0;
 }
 
 void StandbyScreen::Show() {
@@ -166,6 +309,10 @@ void StandbyScreen::Show() {
     }
     is_visible_ = true;
 
+    // 立即显示当前时间和温湿度，不用等第一次定时器回调
+    UpdateTimeUI();
+    UpdateTemperatureHumidityUI();
+
     // 启动定时更新（每秒更新时间）
     esp_err_t ret = esp_timer_start_periodic(update_timer_, 1000000); // 1秒
     if (ret != ESP_OK) {
@@ -186,27 +333,56 @@ void StandbyScreen::Hide() {
     is_visible_ = false;
 }
 
-void StandbyScreen::UpdateTime(const char* date, const char* weekday, const char* time) {
-    cached_date_ = date;
-    cached_weekday_ = weekday;
-    cached_time_ = time;
-    lv_async_call([](void* ctx) {
-        StandbyScreen* screen = static_cast<StandbyScreen*>(ctx);
-        screen->UpdateTimeUI();
-    }, this);
-}
-
 void StandbyScreen::UpdateTimeUI() {
     if (!is_visible_ || date_label_ == nullptr) {
-        ESP_LOGW("StandbyScreen", "UpdateTimeUI skipped - is_visible=%d, date_label=%p", is_visible_, (void*)date_label_);
+        ESP_LOGW(TAG, "UpdateTimeUI skipped - is_visible=%d, date_label=%p", is_visible_, (void*)date_label_);
         return;
     }
 
-    ESP_LOGI("StandbyScreen", "Updating UI with time: date=%s, weekday=%s, time=%s",
-             cached_date_.c_str(), cached_weekday_.c_str(), cached_time_.c_str());
-    lv_label_set_text(date_label_, cached_date_.c_str());
-    lv_label_set_text(weekday_label_, cached_weekday_.c_str());
-    lv_label_set_text(time_label_, cached_time_.c_str());
+    // 获取当前时间
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    // 使用gmtime_r获取UTC时间
+    gmtime_r(&now, &timeinfo);
+    // 手动加8小时转换为东八区时间
+    timeinfo.tm_hour += 8;
+    // 处理跨日情况
+    while (timeinfo.tm_hour >= 24) {
+        timeinfo.tm_hour -= 24;
+        timeinfo.tm_mday++;
+    }
+    // 重新计算星期
+    time_t adjusted = mktime(&timeinfo);
+    gmtime_r(&adjusted, &timeinfo);
+
+    // 格式化日期
+    char date_buf[32];
+    snprintf(date_buf, sizeof(date_buf), "%04d-%02d-%02d",
+             timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday);
+
+    // 星期数组
+    const char* weekdays[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
+    const char* weekday = weekdays[timeinfo.tm_wday];
+
+    // 格式化时间
+    char time_buf[16];
+    snprintf(time_buf, sizeof(time_buf), "%02d:%02d:%02d",
+             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+
+    ESP_LOGD(TAG, "Updating time: %s %s %s", date_buf, weekday, time_buf);
+    SetLabelText(date_label_, shown_date_, sizeof(shown_date_), date_buf);
+    SetLabelText(weekday_label_, shown_weekday_, sizeof(shown_weekday_), weekday);
+
+    // 时钟只替换变化的数字
+    if (time_box_ != nullptr) {
+        for (int i = 0; i < STANDBY_CLOCK_LENGTH; i++) {
+            if (shown_time_[i] != time_buf[i]) {
+                shown_time_[i] = time_buf[i];
+                lv_image_set_src(time_digits_[i], GetClockGlyph(time_buf[i]));
+            }
+        }
+    }
 }
 
 void StandbyScreen::UpdateTemperatureHumidity(float temperature, float humidity) {
@@ -230,21 +406,21 @@ void StandbyScreen::UpdateTemperatureHumidityUI() {
         return;
     }
 
-    char temp_buf[32];
-    char humi_buf[32];
+    char temp_buf[16];
+    char humi_buf[16];
 
     // 检查是否为NaN（未连接传感器）
     if (std::isnan(current_temperature_)) {
         snprintf(temp_buf, sizeof(temp_buf), "--.-°C");
-        ESP_LOGW("StandbyScreen", "Temperature is NaN, displaying placeholder");
+        ESP_LOGD(TAG, "Temperature is NaN, displaying placeholder");
     } else {
         snprintf(temp_buf, sizeof(temp_buf), "%.1f°C", current_temperature_);
 
         // 根据温度设置颜色
-        lv_color_t temp_color;
+        uint32_t temp_color;
         if (current_temperature_ < 20.0f) {
             // 20度以下：蓝色
-            temp_color = lv_color_hex(0x2196F3);
+            temp_color = 0x2196F3;
         } else if (current_temperature_ >= 20.0f && current_temperature_ <= 30.0f) {
             // 20-30度：浅黄色到深橙色渐变
             // 浅黄色(0xFFEB3B) -> 深橙色(0xFF5722)
@@ -252,29 +428,33 @@ void StandbyScreen::UpdateTemperatureHumidityUI() {
             uint8_t r = 0xFF; // 红色保持255
             uint8_t g = 0xEB + (0x57 - 0xEB) * ratio; // 235 -> 87
             uint8_t b = 0x3B + (0x22 - 0x3B) * ratio; // 59 -> 34
-            temp_color = lv_color_make(r, g, b);
+            temp_color = (r << 16) | (g << 8) | b;
         } else {
             // 30度以上：红色
-            temp_color = lv_color_hex(0xF44336);
+            temp_color = 0xF44336;
+        }
+        // 颜色属性变化同样会让整个标签重绘
+        if (temp_color != shown_temperature_color_) {
+            shown_temperature_color_ = temp_color;
+            lv_obj_set_style_text_color(temperature_label_, lv_color_hex(temp_color), 0);
         }
-        lv_obj_set_style_text_color(temperature_label_, temp_color, 0);
     }
 
     if (std::isnan(current_humidity_)) {
         snprintf(humi_buf, sizeof(humi_buf), "--.-%%");
-        ESP_LOGW("StandbyScreen", "Humidity is NaN, displaying placeholder");
+        ESP_LOGD(TAG, "Humidity is NaN, displaying placeholder");
     } else {
         snprintf(humi_buf, sizeof(humi_buf), "%.1f%%", current_humidity_);
     }
 
-    ESP_LOGI("StandbyScreen", "Updating temperature/humidity UI: %s %s", temp_buf, humi_buf);
-    lv_label_set_text(temperature_label_, temp_buf);
+    ESP_LOGD(TAG, "Updating temperature/humidity UI: %s %s", temp_buf, humi_buf);
+    SetLabelText(temperature_label_, shown_temperature_, sizeof(shown_temperature_), temp_buf);
 
-    // 湿度始终用绿色显示
-    if (!std::isnan(current_humidity_)) {
+    // 湿度始终用绿色显示（文字变化时标签本来就要重绘）
+    if (!std::isnan(current_humidity_) && strcmp(shown_humidity_, humi_buf) != 0) {
         lv_obj_set_style_text_color(humidity_label_, lv_color_hex(0x4CAF50), 0);
     }
-    lv_label_set_text(humidity_label_, humi_buf);
+    SetLabelText(humidity_label_, shown_humidity_, sizeof(shown_humidity_), humi_buf);
 }
 
 void StandbyScreen::StartUpdate() {
@@ -290,38 +470,9 @@ void StandbyScreen::StopUpdate() {
 }
 
 void StandbyScreen::UpdateTimerCallback() {
-    ESP_LOGI("StandbyScreen", "Timer callback triggered");
-    // 获取当前时间
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    // 使用gmtime_r获取UTC时间
-    gmtime_r(&now, &timeinfo);
-    // 手动加8小时转换为东八区时间
-    timeinfo.tm_hour += 8;
-    // 处理跨日情况
-    while (timeinfo.tm_hour >= 24) {
-        timeinfo.tm_hour -= 24;
-        timeinfo.tm_mday++;
-    }
-    // 重新计算星期
-    time_t adjusted = mktime(&timeinfo);
-    gmtime_r(&adjusted, &timeinfo);
-
-    // 格式化日期
-    char date_buf[32];
-    snprintf(date_buf, sizeof(date_buf), "%04d-%02d-%02d",
-             timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday);
-
-    // 星期数组
-    const char* weekdays[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
-    const char* weekday = weekdays[timeinfo.tm_wday];
-
-    // 格式化时间
-    char time_buf[16];
-    snprintf(time_buf, sizeof(time_buf), "%02d:%02d:%02d",
-             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-
-    ESP_LOGI("StandbyScreen", "Updating time: %s %s %s", date_buf, weekday, time_buf);
-    UpdateTime(date_buf, weekday, time_buf);
+    // 在LVGL任务中格式化和比较，esp_timer任务只负责触发
+    lv_async_call([](void* ctx) {
+        StandbyScreen* screen = static_cast<StandbyScreen*>(ctx);
+        screen->UpdateTimeUI();
+    }, this);
 }
@@ -3,9 +3,23 @@
 
 #include <lvgl.h>
 #include <esp_timer.h>
-#include <string>
-#include <memory>
+#include <cstdint>
 
+// 大号时钟相对于正文字体的放大倍数（256为原始大小）
+#define STANDBY_CLOCK_SCALE 400
+// 预渲染的时钟字符
+#define STANDBY_CLOCK_GLYPHS "0123456789:-"
+#define STANDBY_CLOCK_GLYPH_COUNT (sizeof(STANDBY_CLOCK_GLYPHS) - 1)
+// 时钟格式 HH:MM:SS
+#define STANDBY_CLOCK_LENGTH 8
+
+/*
+ * 待机界面：日期、星期、大号时钟和温湿度
+ *
+ * 每个标签缓存当前显示的文字，只有变化时才更新，LVGL只重绘变化的区域。
+ * 大号时钟不用运行时缩放（整块变换重绘很慢），而是在第一次显示时把数字放大
+ * 预渲染成图像，每一位是一个图像对象，秒数变化时只刷新最后一位。
+ */
 class StandbyScreen {
 public:
     StandbyScreen(int width, int height);
@@ -17,9 +31,6 @@ public:
     // 隐藏待机界面
     void Hide();
 
-    // 更新时间显示
-    void UpdateTime(const char* date, const char* weekday, const char* time);
-
     // 更新温湿度显示
     void UpdateTemperatureHumidity(float temperature, float humidity);
 
@@ -34,6 +45,8 @@ public:
 
 private:
     void CreateUI();
+    void CreateClockGlyphs(const lv_font_t* font);
+    const lv_image_dsc_t* GetClockGlyph(char c) const;
     void DestroyUI();
     void UpdateTimerCallback();
     void UpdateTimeUI();
@@ -47,7 +60,8 @@ private:
     lv_obj_t* container_;
     lv_obj_t* date_label_;
     lv_obj_t* weekday_label_;
-    lv_obj_t* time_label_;
+    lv_obj_t* time_box_;
+    lv_obj_t* time_digits_[STANDBY_CLOCK_LENGTH];
     lv_obj_t* temperature_label_;
     lv_obj_t* humidity_label_;
     lv_obj_t* temp_icon_;
@@ -59,10 +73,17 @@ private:
     float current_temperature_;
     float current_humidity_;
 
-    // 缓存的时间字符串
-    std::string cached_date_;
-    std::string cached_weekday_;
-    std::string cached_time_;
+    // 预渲染的时钟字形（RGB565，黑底白字），所有字形共用一块内存
+    lv_image_dsc_t clock_glyphs_[STANDBY_CLOCK_GLYPH_COUNT];
+    uint8_t* clock_glyph_data_;
+
+    // 当前显示的文字，用于跳过没有变化的更新
+    char shown_date_[16];
+    char shown_weekday_[16];
+    char shown_time_[STANDBY_CLOCK_LENGTH + 1];
+    char shown_temperature_[16];
+    char shown_humidity_[16];
+    uint32_t shown_temperature_color_;
 };
 
 #endif // STANDBY_SCREEN_H
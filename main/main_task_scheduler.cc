@@ -0,0 +1,109 @@
+#include "main_task_scheduler.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+
+#define TAG "MainTaskScheduler"
+
+// Run time budget of each class per RunPending() call, a started task always runs to completion
+static const int64_t kRunBudgetUs[kSchedulePriorityCount] = {
+    50 * 1000,      // State
+    50 * 1000,      // Audio
+    100 * 1000,     // MCP
+    20 * 1000,      // UI
+};
+
+static const char* const kPriorityNames[kSchedulePriorityCount] = {
+    "state", "audio", "mcp", "ui",
+};
+
+void MainTaskScheduler::Push(SchedulePriority priority, MainTask&& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& queue = queues_[priority];
+    if (queue.count < MAIN_TASK_QUEUE_SIZE && queue.overflow.empty()) {
+        auto& entry = queue.ring[(queue.head + queue.count) % MAIN_TASK_QUEUE_SIZE];
+        entry.task = std::move(task);
+        entry.enqueue_time_us = esp_timer_get_time();
+        queue.count++;
+    } else {
+        queue.overflow.push_back({std::move(task), esp_timer_get_time()});
+        queue.statistics.overflow_count++;
+    }
+    queue.statistics.max_depth = std::max(queue.statistics.max_depth, queue.count + queue.overflow.size());
+}
+
+bool MainTaskScheduler::RunPending() {
+    int64_t used_us[kSchedulePriorityCount] = {};
+    while (true) {
+        MainTask task;
+        int priority = -1;
+        bool deferred = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int i = 0; i < kSchedulePriorityCount; i++) {
+                auto& queue = queues_[i];
+                if (queue.count == 0) {
+                    continue;
+                }
+                if (used_us[i] >= kRunBudgetUs[i]) {
+                    deferred = true;
+                    continue;
+                }
+
+                auto& entry = queue.ring[queue.head];
+                task = std::move(entry.task);
+                queue.statistics.max_latency_us = std::max(queue.statistics.max_latency_us,
+                    esp_timer_get_time() - entry.enqueue_time_us);
+                queue.head = (queue.head + 1) % MAIN_TASK_QUEUE_SIZE;
+                queue.count--;
+                // Refill the ring from the overflow list to keep FIFO order
+                if (!queue.overflow.empty()) {
+                    auto& tail = queue.ring[(queue.head + queue.count) % MAIN_TASK_QUEUE_SIZE];
+                    tail = std::move(queue.overflow.front());
+                    queue.overflow.pop_front();
+                    queue.count++;
+                }
+                priority = i;
+                break;
+            }
+        }
+        if (priority < 0) {
+            return deferred;
+        }
+
+        int64_t start_time = esp_timer_get_time();
+        task();
+        int64_t run_time = esp_timer_get_time() - start_time;
+        used_us[priority] += run_time;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        queues_[priority].statistics.run_count++;
+        queues_[priority].statistics.run_time_us += run_time;
+    }
+}
+
+MainTaskStatistics MainTaskScheduler::GetStatistics(SchedulePriority priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& queue = queues_[priority];
+    MainTaskStatistics statistics = queue.statistics;
+    statistics.depth = queue.count + queue.overflow.size();
+    return statistics;
+}
+
+void MainTaskScheduler::PrintStatistics() {
+    for (int i = 0; i < kSchedulePriorityCount; i++) {
+        auto statistics = GetStatistics((SchedulePriority)i);
+        if (statistics.run_count > 0 || statistics.depth > 0) {
+            ESP_LOGI(TAG, "%-5s: run %lu (%lld ms), depth %u/%u, max latency %lld ms, overflow %lu",
+                kPriorityNames[i], (unsigned long)statistics.run_count, (long long)statistics.run_time_us / 1000,
+                (unsigned)statistics.depth, (unsigned)statistics.max_depth,
+                (long long)statistics.max_latency_us / 1000, (unsigned long)statistics.overflow_count);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& queue = queues_[i];
+        queue.statistics = MainTaskStatistics();
+        queue.statistics.max_depth = queue.count + queue.overflow.size();
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef MAIN_TASK_SCHEDULER_H
+#define MAIN_TASK_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Closures are stored inline, a lambda capturing more than this fails to compile
+#define MAIN_TASK_INLINE_SIZE 64
+// Tasks per priority class that can wait without allocating
+#define MAIN_TASK_QUEUE_SIZE 16
+
+/*
+ * Priority classes of the tasks scheduled to the main task, highest first.
+ */
+enum SchedulePriority {
+    kSchedulePriorityState,     // Device state transitions
+    kSchedulePriorityAudio,     // Audio channel and playback control
+    kSchedulePriorityMcp,       // MCP tool calls and replies
+    kSchedulePriorityUi,        // Display updates
+    kSchedulePriorityCount,
+};
+
+// Counters of one priority class since the last PrintStatistics()
+struct MainTaskStatistics {
+    size_t depth = 0;               // Tasks waiting now
+    size_t max_depth = 0;
+    int64_t max_latency_us = 0;     // Longest time from Push() to the start of a task
+    int64_t run_time_us = 0;
+    uint32_t run_count = 0;
+    uint32_t overflow_count = 0;    // Pushes that went to the overflow list
+};
+
+/*
+ * A move-only void() callable kept in inline storage, so scheduling it never allocates.
+ */
+class MainTask {
+public:
+    MainTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, MainTask>>>
+    MainTask(F&& callback) {
+        using T = std::decay_t<F>;
+        static_assert(sizeof(T) <= MAIN_TASK_INLINE_SIZE, "Callback captures too much for MainTask, capture by pointer");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Callback alignment not supported by MainTask");
+        new (storage_) T(std::forward<F>(callback));
+        ops_ = &kOps<T>;
+    }
+
+    MainTask(MainTask&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    MainTask& operator=(MainTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    MainTask(const MainTask&) = delete;
+    MainTask& operator=(const MainTask&) = delete;
+
+    ~MainTask() {
+        Reset();
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()() {
+        ops_->invoke(storage_);
+    }
+
+    void Reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* callback);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* callback);
+    };
+
+    template <typename T>
+    static constexpr Ops kOps = {
+        [](void* callback) { (*static_cast<T*>(callback))(); },
+        [](void* dst, void* src) {
+            new (dst) T(std::move(*static_cast<T*>(src)));
+            static_cast<T*>(src)->~T();
+        },
+        [](void* callback) { static_cast<T*>(callback)->~T(); },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[MAIN_TASK_INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+
+    void MoveFrom(MainTask& other) {
+        if (other.ops_ != nullptr) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+/*
+ * Runs the tasks scheduled to the main task by priority class.
+ *
+ * RunPending() always starts the highest priority task that is waiting, so a state change is not
+ * stuck behind a burst of UI updates. Each class has a run time budget per call; once a class used
+ * its budget, its remaining tasks wait for the next call and lower classes get their turn.
+ * Each class has a fixed ring of MAIN_TASK_QUEUE_SIZE tasks. Tasks beyond that go to an overflow
+ * list (this allocates) instead of blocking the caller or being dropped, FIFO order is kept.
+ */
+class MainTaskScheduler {
+public:
+    void Push(SchedulePriority priority, MainTask&& task);
+
+    // Returns true if tasks are still waiting because their class used up its budget
+    bool RunPending();
+
+    MainTaskStatistics GetStatistics(SchedulePriority priority);
+
+    // Log queue depth, dispatch latency and run count per class since the last call, then reset them
+    void PrintStatistics();
+
+private:
+    struct Entry {
+        MainTask task;
+        int64_t enqueue_time_us = 0;
+    };
+
+    struct Queue {
+        Entry ring[MAIN_TASK_QUEUE_SIZE];
+        size_t head = 0;
+        size_t count = 0;
+        std::deque<Entry> overflow;
+        MainTaskStatistics statistics;
+    };
+
+    std::mutex mutex_;
+    Queue queues_[kSchedulePriorityCount];
+};
+
+#endif // MAIN_TASK_SCHEDULER_H
@@ -28,6 +28,7 @@ McpServer::~McpServer() {
         delete tool;
     }
     tools_.clear();
+    tool_index_.clear();
 }
 
 void McpServer::AddCommonTools() {
@@ -36,7 +37,13 @@ void McpServer::AddCommonTools() {
     // **重要** 为了提升响应速度，我们把常用的工具放在前面，利用 prompt cache 的特性。
 
     // Backup the original tools list and restore it after adding the common tools.
-    auto original_tools = std::move(tools_);
+    std::vector<McpTool*> original_tools;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        original_tools = std::move(tools_);
+        tools_.clear();
+        tool_index_.clear();
+    }
     auto& board = Board::GetInstance();
 
     // Do not add custom tools here.
@@ -122,7 +129,20 @@ void McpServer::AddCommonTools() {
 #endif
 
     // Restore the original tools list to the end of the tools list
+    std::lock_guard<std::mutex> lock(mutex_);
     tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+    RebuildToolIndex();
+    for (auto& pages : tools_list_pages_) {
+        pages.reset();
+    }
+}
+
+void McpServer::RebuildToolIndex() {
+    tool_index_.clear();
+    tool_index_.reserve(tools_.size());
+    for (size_t i = 0; i < tools_.size(); i++) {
+        tool_index_.emplace(tools_[i]->name(), i);
+    }
 }
 
 void McpServer::AddUserOnlyTools() {
@@ -144,7 +164,7 @@ void McpServer::AddUserOnlyTools() {
                 vTaskDelay(pdMS_TO_TICKS(1000));
 
                 app.Reboot();
-            });
+            }, kSchedulePriorityMcp);
             return true;
         });
 
@@ -163,7 +183,7 @@ void McpServer::AddUserOnlyTools() {
                 if (!success) {
                     ESP_LOGE(TAG, "Firmware upgrade failed");
                 }
-            });
+            }, kSchedulePriorityMcp);
             
             return true;
         });
@@ -301,14 +321,19 @@ void McpServer::AddUserOnlyTools() {
 }
 
 void McpServer::AddTool(McpTool* tool) {
+    std::lock_guard<std::mutex> lock(mutex_);
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    if (tool_index_.find(tool->name()) != tool_index_.end()) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
         return;
     }
 
     ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(), tool->user_only() ? " [user]" : "");
+    tool_index_.emplace(tool->name(), tools_.size());
     tools_.push_back(tool);
+    for (auto& pages : tools_list_pages_) {
+        pages.reset();
+    }
 }
 
 void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
@@ -436,7 +461,9 @@ void McpServer::ParseMessage(const cJSON* json) {
 }
 
 void McpServer::ReplyResult(int id, const std::string& result) {
-    std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
+    std::string payload;
+    payload.reserve(result.size() + 48);
+    payload = "{\"jsonrpc\":\"2.0\",\"id\":";
     payload += std::to_string(id) + ",\"result\":";
     payload += result;
     payload += "}";
@@ -453,38 +480,92 @@ void McpServer::ReplyError(int id, const std::string& message) {
 }
 
 void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools) {
+    auto pages = GetToolsListPages(list_user_only_tools);
+    for (const auto& page : *pages) {
+        if (page.cursor == cursor) {
+            if (page.ok) {
+                ReplyResult(id, page.result);
+            } else {
+                ReplyError(id, page.result);
+            }
+            return;
+        }
+    }
+
+    // The cursor is not one we handed out, build the page on demand
+    std::string result;
+    std::string next_cursor;
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ok = BuildToolsListPage(cursor, list_user_only_tools, result, next_cursor);
+    }
+    if (ok) {
+        ReplyResult(id, result);
+    } else {
+        ReplyError(id, result);
+    }
+}
+
+std::shared_ptr<const std::vector<McpServer::ToolsListPage>> McpServer::GetToolsListPages(bool list_user_only_tools) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& cached = tools_list_pages_[list_user_only_tools ? 1 : 0];
+    if (cached) {
+        return cached;
+    }
+
+    auto pages = std::make_shared<std::vector<ToolsListPage>>();
+    std::string cursor = "";
+    while (true) {
+        std::string next_cursor;
+        ToolsListPage page = { cursor, "", false };
+        page.ok = BuildToolsListPage(cursor, list_user_only_tools, page.result, next_cursor);
+        page.result.shrink_to_fit();
+        pages->push_back(std::move(page));
+        if (!pages->back().ok || next_cursor.empty()) {
+            break;
+        }
+        cursor = std::move(next_cursor);
+    }
+    ESP_LOGI(TAG, "tools/list: %u pages cached%s", pages->size(), list_user_only_tools ? " (with user tools)" : "");
+    cached = std::move(pages);
+    return cached;
+}
+
+bool McpServer::BuildToolsListPage(const std::string& cursor, bool list_user_only_tools, std::string& result, std::string& next_cursor) {
     const int max_payload_size = 8000;
     std::string json = "{\"tools\":[";
+    json.reserve(max_payload_size);
     
-    bool found_cursor = cursor.empty();
+    // 从cursor对应的tool开始
     auto it = tools_.begin();
-    std::string next_cursor = "";
+    if (!cursor.empty()) {
+        auto index = tool_index_.find(cursor);
+        if (index == tool_index_.end()) {
+            ESP_LOGE(TAG, "tools/list: Unknown cursor %s", cursor.c_str());
+            result = "Unknown cursor: " + cursor;
+            return false;
+        }
+        it = tools_.begin() + index->second;
+    }
+    next_cursor = "";
     
     while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
-                continue;
-            }
-        }
-
         if (!list_user_only_tools && (*it)->user_only()) {
             ++it;
             continue;
         }
         
         // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
-        if (json.length() + tool_json.length() + 30 > max_payload_size) {
+        std::string tool_json = (*it)->to_json();
+        if (json.length() + tool_json.length() + 1 + 30 > max_payload_size) {
             // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
             next_cursor = (*it)->name();
             break;
         }
         
         json += tool_json;
+        json += ',';
         ++it;
     }
     
@@ -495,8 +576,8 @@ void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_o
     if (json.back() == '[' && !tools_.empty()) {
         // 如果没有添加任何tool，返回错误
         ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
+        result = "Failed to add tool " + next_cursor + " because of payload size limit";
+        return false;
     }
 
     if (next_cursor.empty()) {
@@ -505,22 +586,27 @@ void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_o
         json += "],\"nextCursor\":\"" + next_cursor + "\"}";
     }
     
-    ReplyResult(id, json);
+    result = std::move(json);
+    return true;
 }
 
 void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
+    // Tools are never removed, the pointer stays valid after the lock is released
+    McpTool* tool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto index = tool_index_.find(tool_name);
+        if (index != tool_index_.end()) {
+            tool = tools_[index->second];
+        }
+    }
+    if (tool == nullptr) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
         ReplyError(id, "Unknown tool: " + tool_name);
         return;
     }
 
-    PropertyList arguments = (*tool_iter)->properties();
+    PropertyList arguments = tool->properties();
     try {
         for (auto& argument : arguments) {
             bool found = false;
@@ -552,12 +638,12 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
 
     // Use main thread to call the tool
     auto& app = Application::GetInstance();
-    app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+    app.Schedule([this, id, tool, arguments = std::move(arguments)]() {
         try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
+            ReplyResult(id, tool->Call(arguments));
         } catch (const std::exception& e) {
             ESP_LOGE(TAG, "tools/call: %s", e.what());
             ReplyError(id, e.what());
         }
-    });
+    }, kSchedulePriorityMcp);
 }
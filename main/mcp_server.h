@@ -4,11 +4,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
 #include <thread>
+#include <memory>
+#include <mutex>
 #include <mbedtls/base64.h>
 
 #include <cJSON.h>
@@ -120,7 +123,7 @@ public:
         value_ = value;
     }
 
-    std::string to_json() const {
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
         
         if (type_ == kPropertyTypeBoolean) {
@@ -145,7 +148,11 @@ public:
                 cJSON_AddStringToObject(json, "default", value<std::string>().c_str());
             }
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -188,14 +195,16 @@ public:
         return required;
     }
 
-    std::string to_json() const {
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
-        
         for (const auto& property : properties_) {
-            cJSON *prop_json = cJSON_Parse(property.to_json().c_str());
-            cJSON_AddItemToObject(json, property.name().c_str(), prop_json);
+            cJSON_AddItemToObject(json, property.name().c_str(), property.to_cjson());
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -239,8 +248,7 @@ public:
         cJSON *input_schema = cJSON_CreateObject();
         cJSON_AddStringToObject(input_schema, "type", "object");
         
-        cJSON *properties = cJSON_Parse(properties_.to_json().c_str());
-        cJSON_AddItemToObject(input_schema, "properties", properties);
+        cJSON_AddItemToObject(input_schema, "properties", properties_.to_cjson());
         
         if (!required.empty()) {
             cJSON *required_array = cJSON_CreateArray();
@@ -335,10 +343,30 @@ private:
     void ReplyResult(int id, const std::string& result);
     void ReplyError(int id, const std::string& message);
 
+    // A tools/list result, or the error message when a single tool exceeds the payload size
+    struct ToolsListPage {
+        std::string cursor;
+        std::string result;
+        bool ok;
+    };
+
     void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
+    // BuildToolsListPage and RebuildToolIndex are called with mutex_ held
+    bool BuildToolsListPage(const std::string& cursor, bool list_user_only_tools, std::string& result, std::string& next_cursor);
+    std::shared_ptr<const std::vector<ToolsListPage>> GetToolsListPages(bool list_user_only_tools);
     void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
+    void RebuildToolIndex();
 
+    // Guards tools_, tool_index_ and tools_list_pages_: tools are added from the main and board
+    // init code while the network task serves tools/list and tools/call
+    std::mutex mutex_;
     std::vector<McpTool*> tools_;
+    // Position of each tool in tools_ by name, for tools/call and tools/list cursors
+    std::unordered_map<std::string, size_t> tool_index_;
+    // The tool set is fixed after initialization, so the tools/list pages are serialized once
+    // per listing mode (index 1 includes the user only tools) and dropped when a tool is added.
+    // A reply keeps its own reference, so dropping the pages never frees one that is being sent.
+    std::shared_ptr<const std::vector<ToolsListPage>> tools_list_pages_[2];
 };
 
 #endif // MCP_SERVER_H
@@ -0,0 +1,131 @@
+#include "incoming_message.h"
+
+#include <array>
+#include <iterator>
+#include <cstdint>
+
+namespace {
+
+struct MessageKind {
+    std::string_view name;
+    IncomingMessageType type;
+};
+
+constexpr MessageKind kMessageKinds[] = {
+    {"hello", kIncomingMessageHello},
+    {"goodbye", kIncomingMessageGoodbye},
+    {"tts", kIncomingMessageTts},
+    {"stt", kIncomingMessageStt},
+    {"llm", kIncomingMessageLlm},
+    {"mcp", kIncomingMessageMcp},
+    {"system", kIncomingMessageSystem},
+    {"alert", kIncomingMessageAlert},
+    {"custom", kIncomingMessageCustom},
+};
+
+// Perfect hash of the message types above, checked at compile time
+constexpr size_t kMessageKindTableSize = 16;
+
+constexpr size_t HashMessageType(std::string_view name) {
+    if (name.size() < 2) {
+        return 0;
+    }
+    return ((uint8_t)name[0] * 2 + (uint8_t)name[1] + name.size()) % kMessageKindTableSize;
+}
+
+constexpr std::array<const MessageKind*, kMessageKindTableSize> BuildMessageKindTable() {
+    std::array<const MessageKind*, kMessageKindTableSize> table{};
+    for (const auto& kind : kMessageKinds) {
+        table[HashMessageType(kind.name)] = &kind;
+    }
+    return table;
+}
+
+constexpr auto kMessageKindTable = BuildMessageKindTable();
+
+constexpr bool MessageKindTableIsPerfect() {
+    for (const auto& kind : kMessageKinds) {
+        if (kMessageKindTable[HashMessageType(kind.name)] != &kind) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(MessageKindTableIsPerfect(), "Message type hash has collisions, adjust HashMessageType");
+
+IncomingMessageType LookupMessageType(const JsonString& name) {
+    if (name.escaped) {
+        return kIncomingMessageUnknown;
+    }
+    auto kind = kMessageKindTable[HashMessageType(name.raw)];
+    return kind != nullptr && kind->name == name.raw ? kind->type : kIncomingMessageUnknown;
+}
+
+TtsState LookupTtsState(const JsonString& state) {
+    if (state.Equals("sentence_start")) return kTtsStateSentenceStart;
+    if (state.Equals("sentence_end")) return kTtsStateSentenceEnd;
+    if (state.Equals("start")) return kTtsStateStart;
+    if (state.Equals("stop")) return kTtsStateStop;
+    return kTtsStateUnknown;
+}
+
+// String members copied into IncomingMessage, a null field is the raw "payload"
+struct StringField {
+    std::string_view key;
+    JsonString IncomingMessage::*field;
+};
+
+constexpr StringField kStringFields[] = {
+    {"type", &IncomingMessage::type_name},
+    {"state", &IncomingMessage::state},
+    {"text", &IncomingMessage::text},
+    {"emotion", &IncomingMessage::emotion},
+    {"command", &IncomingMessage::command},
+    {"status", &IncomingMessage::status},
+    {"message", &IncomingMessage::message},
+    {"session_id", &IncomingMessage::session_id},
+    {"payload", nullptr},
+};
+
+} // namespace
+
+bool ParseIncomingMessage(const char* data, size_t size, IncomingMessage* message) {
+    *message = IncomingMessage();
+    message->json = std::string_view(data, size);
+
+    JsonReader reader(data, size);
+    if (!reader.BeginObject()) {
+        return false;
+    }
+
+    // Like cJSON_GetObjectItem, the first member with a name wins
+    uint32_t seen = 0;
+    std::string_view key;
+    while (reader.NextMember(&key)) {
+        size_t index = 0;
+        while (index < std::size(kStringFields) && kStringFields[index].key != key) {
+            index++;
+        }
+        if (index < std::size(kStringFields) && (seen & (1u << index)) == 0) {
+            seen |= 1u << index;
+            if (kStringFields[index].field == nullptr) {
+                reader.SkipValue(&message->payload);
+                continue;
+            }
+            // Members that are not strings are treated as missing
+            if (reader.ReadString(&(message->*kStringFields[index].field))) {
+                continue;
+            }
+        }
+        reader.SkipValue();
+    }
+    if (!reader.ok()) {
+        return false;
+    }
+
+    message->type = LookupMessageType(message->type_name);
+    if (message->type == kIncomingMessageTts) {
+        message->tts_state = LookupTtsState(message->state);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef INCOMING_MESSAGE_H
+#define INCOMING_MESSAGE_H
+
+#include "json_reader.h"
+
+#include <cstddef>
+#include <string_view>
+
+enum IncomingMessageType {
+    kIncomingMessageUnknown,
+    kIncomingMessageHello,
+    kIncomingMessageGoodbye,
+    kIncomingMessageTts,
+    kIncomingMessageStt,
+    kIncomingMessageLlm,
+    kIncomingMessageMcp,
+    kIncomingMessageSystem,
+    kIncomingMessageAlert,
+    kIncomingMessageCustom,
+};
+
+enum TtsState {
+    kTtsStateUnknown,
+    kTtsStateStart,
+    kTtsStateStop,
+    kTtsStateSentenceStart,
+    kTtsStateSentenceEnd,
+};
+
+/*
+ * A JSON text message from the server, read in one pass without building a cJSON tree.
+ * All views point into the received frame and are only valid during the callback.
+ */
+struct IncomingMessage {
+    IncomingMessageType type = kIncomingMessageUnknown;
+    TtsState tts_state = kTtsStateUnknown;
+
+    JsonString type_name;
+    JsonString state;
+    JsonString text;
+    JsonString emotion;
+    JsonString command;
+    JsonString status;
+    JsonString message;
+    JsonString session_id;
+    // Raw JSON of the "payload" member (mcp, custom), parse it with cJSON_ParseWithLength if needed
+    std::string_view payload;
+    // The whole frame, for the rare messages that need a full parse (hello)
+    std::string_view json;
+
+    bool payload_is_object() const { return !payload.empty() && payload.front() == '{'; }
+};
+
+// Returns false if the frame is not a valid JSON object
+bool ParseIncomingMessage(const char* data, size_t size, IncomingMessage* message);
+
+#endif // INCOMING_MESSAGE_H
@@ -0,0 +1,337 @@
+#include "json_reader.h"
+
+#include <cstdint>
+#include <cstring>
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parse the 4 hex digits after "\u", -1 if they are invalid
+static int ParseHex4(const char* p, const char* end) {
+    if (end - p < 4) {
+        return -1;
+    }
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = HexValue(p[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+static void AppendUtf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out.push_back((char)code_point);
+    } else if (code_point < 0x800) {
+        out.push_back((char)(0xC0 | (code_point >> 6)));
+        out.push_back((char)(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out.push_back((char)(0xE0 | (code_point >> 12)));
+        out.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (code_point & 0x3F)));
+    } else {
+        out.push_back((char)(0xF0 | (code_point >> 18)));
+        out.push_back((char)(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (code_point & 0x3F)));
+    }
+}
+
+std::string JsonString::ToString() const {
+    if (!escaped) {
+        return std::string(raw);
+    }
+
+    std::string out;
+    out.reserve(raw.size());
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    while (p < end) {
+        if (*p != '\\') {
+            out.push_back(*p++);
+            continue;
+        }
+        // The reader only accepts strings whose escapes are complete
+        p++;
+        switch (*p++) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t code_point = ParseHex4(p, end);
+                p += 4;
+                // Combine a surrogate pair, a lone surrogate becomes U+FFFD
+                if (code_point >= 0xD800 && code_point < 0xDC00) {
+                    int low = (end - p >= 6 && p[0] == '\\' && p[1] == 'u') ? ParseHex4(p + 2, end) : -1;
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        code_point = 0xFFFD;
+                    }
+                } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+                    code_point = 0xFFFD;
+                }
+                AppendUtf8(out, code_point);
+                break;
+            }
+            default:
+                // \" \\ \/
+                out.push_back(p[-1]);
+                break;
+        }
+    }
+    return out;
+}
+
+bool JsonReader::Fail() {
+    error_ = true;
+    pos_ = end_;
+    return false;
+}
+
+void JsonReader::SkipWhitespace() {
+    while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+        pos_++;
+    }
+}
+
+bool JsonReader::ScanString(std::string_view* raw, bool* escaped) {
+    // pos_ is at the opening quote
+    const char* start = ++pos_;
+    bool has_escape = false;
+    while (pos_ < end_) {
+        char c = *pos_;
+        if (c == '"') {
+            if (raw != nullptr) {
+                *raw = std::string_view(start, pos_ - start);
+            }
+            if (escaped != nullptr) {
+                *escaped = has_escape;
+            }
+            pos_++;
+            return true;
+        }
+        if (c == '\\') {
+            has_escape = true;
+            if (end_ - pos_ < 2) {
+                return Fail();
+            }
+            char e = pos_[1];
+            if (e == 'u') {
+                if (ParseHex4(pos_ + 2, end_) < 0) {
+                    return Fail();
+                }
+                pos_ += 6;
+            } else if (e == '"' || e == '\\' || e == '/' || e == 'b' || e == 'f' || e == 'n' || e == 'r' || e == 't') {
+                pos_ += 2;
+            } else {
+                return Fail();
+            }
+            continue;
+        }
+        if ((unsigned char)c < 0x20) {
+            // Control characters must be escaped
+            return Fail();
+        }
+        pos_++;
+    }
+    return Fail();
+}
+
+bool JsonReader::ScanKey() {
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != '"' || !ScanString(nullptr, nullptr)) {
+        return Fail();
+    }
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != ':') {
+        return Fail();
+    }
+    pos_++;
+    return true;
+}
+
+bool JsonReader::ScanLiteral() {
+    static const char* const literals[] = { "true", "false", "null" };
+    for (const char* literal : literals) {
+        size_t length = strlen(literal);
+        if ((size_t)(end_ - pos_) >= length && memcmp(pos_, literal, length) == 0) {
+            pos_ += length;
+            return true;
+        }
+    }
+    return Fail();
+}
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+bool JsonReader::ScanNumber() {
+    auto digits = [this]() {
+        const char* start = pos_;
+        while (pos_ < end_ && *pos_ >= '0' && *pos_ <= '9') {
+            pos_++;
+        }
+        return pos_ - start;
+    };
+
+    if (pos_ < end_ && *pos_ == '-') {
+        pos_++;
+    }
+    if (pos_ < end_ && *pos_ == '0') {
+        pos_++;
+    } else if (digits() == 0) {
+        return Fail();
+    }
+    if (pos_ < end_ && *pos_ == '.') {
+        pos_++;
+        if (digits() == 0) {
+            return Fail();
+        }
+    }
+    if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+        pos_++;
+        if (pos_ < end_ && (*pos_ == '+' || *pos_ == '-')) {
+            pos_++;
+        }
+        if (digits() == 0) {
+            return Fail();
+        }
+    }
+    return true;
+}
+
+bool JsonReader::BeginObject() {
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != '{') {
+        return Fail();
+    }
+    pos_++;
+    first_member_ = true;
+    return true;
+}
+
+bool JsonReader::NextMember(std::string_view* key) {
+    if (error_) {
+        return false;
+    }
+    SkipWhitespace();
+    if (pos_ < end_ && *pos_ == '}') {
+        pos_++;
+        return false;
+    }
+    if (!first_member_) {
+        if (pos_ >= end_ || *pos_ != ',') {
+            return Fail();
+        }
+        pos_++;
+        SkipWhitespace();
+    }
+    first_member_ = false;
+    if (pos_ >= end_ || *pos_ != '"' || !ScanString(key, nullptr)) {
+        return Fail();
+    }
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != ':') {
+        return Fail();
+    }
+    pos_++;
+    SkipWhitespace();
+    return true;
+}
+
+bool JsonReader::ReadString(JsonString* value) {
+    SkipWhitespace();
+    if (error_ || pos_ >= end_ || *pos_ != '"') {
+        return false;
+    }
+    return ScanString(&value->raw, &value->escaped);
+}
+
+bool JsonReader::SkipValue(std::string_view* raw) {
+    SkipWhitespace();
+    if (error_ || pos_ >= end_) {
+        return Fail();
+    }
+
+    // Containers are tracked with one bit per level (1 = object) instead of recursion
+    uint8_t objects[JSON_READER_MAX_DEPTH / 8];
+    size_t depth = 0;
+    auto in_object = [&]() { return (objects[(depth - 1) / 8] >> ((depth - 1) % 8)) & 1; };
+
+    const char* start = pos_;
+    while (true) {
+        // Expecting a value
+        SkipWhitespace();
+        if (pos_ >= end_) {
+            return Fail();
+        }
+        char c = *pos_;
+        if (c == '{' || c == '[') {
+            if (depth == JSON_READER_MAX_DEPTH) {
+                return Fail();
+            }
+            uint8_t bit = 1 << (depth % 8);
+            objects[depth / 8] = c == '{' ? (objects[depth / 8] | bit) : (objects[depth / 8] & ~bit);
+            depth++;
+            pos_++;
+            SkipWhitespace();
+            if (pos_ < end_ && *pos_ == (c == '{' ? '}' : ']')) {
+                pos_++;
+                depth--;
+            } else {
+                if (c == '{' && !ScanKey()) {
+                    return false;
+                }
+                continue;
+            }
+        } else if (c == '"') {
+            if (!ScanString(nullptr, nullptr)) {
+                return false;
+            }
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!ScanNumber()) {
+                return false;
+            }
+        } else if (!ScanLiteral()) {
+            return false;
+        }
+
+        // After a value: close the containers that end here, then expect the next element
+        while (depth > 0) {
+            SkipWhitespace();
+            if (pos_ >= end_) {
+                return Fail();
+            }
+            if (*pos_ == (in_object() ? '}' : ']')) {
+                pos_++;
+                depth--;
+                continue;
+            }
+            if (*pos_ != ',') {
+                return Fail();
+            }
+            pos_++;
+            if (in_object() && !ScanKey()) {
+                return false;
+            }
+            break;
+        }
+        if (depth == 0) {
+            break;
+        }
+    }
+
+    if (raw != nullptr) {
+        *raw = std::string_view(start, pos_ - start);
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Nesting limit of the values skipped by JsonReader::SkipValue
+#define JSON_READER_MAX_DEPTH 1024
+
+/*
+ * A JSON string value as it appears in the input, escapes not yet decoded.
+ * Views point into the parsed buffer and are only valid while it is.
+ */
+struct JsonString {
+    std::string_view raw;
+    bool escaped = false;
+
+    // False when the member was missing or not a string
+    bool present() const { return raw.data() != nullptr; }
+    bool Equals(std::string_view text) const { return !escaped && raw == text; }
+    // Decode the escapes (including \uXXXX to UTF-8)
+    std::string ToString() const;
+};
+
+/*
+ * Pull-based JSON reader working in place on a buffer, it never allocates.
+ *
+ *     JsonReader reader(data, size);
+ *     std::string_view key;
+ *     if (reader.BeginObject()) {
+ *         while (reader.NextMember(&key)) {
+ *             if (key == "text" && reader.ReadString(&text)) continue;
+ *             reader.SkipValue();
+ *         }
+ *     }
+ *     if (!reader.ok()) ...
+ *
+ * The input must be strict JSON: bracket types must match, literals and numbers follow the
+ * grammar and control characters in strings must be escaped. Nested values are validated
+ * and skipped without recursion, so malformed or deeply nested input cannot exhaust the stack.
+ */
+class JsonReader {
+public:
+    JsonReader(const char* data, size_t size) : end_(data + size), pos_(data) {}
+
+    // Consume the '{' of an object
+    bool BeginObject();
+    // Move to the next member of the current object, false at the closing '}' or on error
+    bool NextMember(std::string_view* key);
+    // Read the value if it is a string, otherwise leave it for SkipValue()
+    bool ReadString(JsonString* value);
+    // Skip any value, optionally returning its raw text
+    bool SkipValue(std::string_view* raw = nullptr);
+
+    bool ok() const { return !error_; }
+
+private:
+    const char* end_;
+    const char* pos_;
+    bool first_member_ = true;
+    bool error_ = false;
+
+    void SkipWhitespace();
+    bool ScanString(std::string_view* raw, bool* escaped);
+    bool ScanKey();
+    bool ScanLiteral();
+    bool ScanNumber();
+    bool Fail();
+};
+
+#endif // JSON_READER_H
@@ -1,11 +1,87 @@
 #include "protocol.h"
+#include "object_pool.h"
+#include "settings.h"
 
 #include <esp_log.h>
+#include <arpa/inet.h>
+#include <cstring>
 
 #define TAG "Protocol"
 
-void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
-    on_incoming_json_ = callback;
+static ObjectPool<AudioStreamPacket, AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE>& GetDownlinkPacketPool() {
+    static ObjectPool<AudioStreamPacket, AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE> pool;
+    return pool;
+}
+
+static ObjectPool<AudioStreamPacket, AUDIO_STREAM_UPLINK_PACKET_POOL_SIZE>& GetUplinkPacketPool() {
+    static ObjectPool<AudioStreamPacket, AUDIO_STREAM_UPLINK_PACKET_POOL_SIZE> pool;
+    return pool;
+}
+
+std::unique_ptr<AudioStreamPacket> AudioStreamPacket::Acquire(AudioStreamPacketPool pool) {
+    if (pool == kAudioStreamPacketPoolUplink) {
+        return GetUplinkPacketPool().Acquire();
+    }
+    return GetDownlinkPacketPool().Acquire();
+}
+
+void AudioStreamPacket::Reset() {
+    sample_rate = 0;
+    frame_duration = 0;
+    timestamp = 0;
+    sequence = 0;
+    payload.clear();
+    headroom = 0;
+    payload_view = nullptr;
+    payload_view_size = 0;
+}
+
+void AudioStreamPacket::operator delete(AudioStreamPacket* packet, std::destroying_delete_t) {
+    auto& uplink_pool = GetUplinkPacketPool();
+    if (uplink_pool.Owns(packet)) {
+        uplink_pool.Release(packet);
+    } else {
+        // Also frees the heap packets of both pools
+        GetDownlinkPacketPool().Release(packet);
+    }
+}
+
+static_assert(sizeof(BinaryProtocol2) <= AUDIO_STREAM_PACKET_HEADROOM, "Headroom too small for BinaryProtocol2");
+static_assert(sizeof(BinaryProtocol3) <= AUDIO_STREAM_PACKET_HEADROOM, "Headroom too small for BinaryProtocol3");
+
+const uint8_t* FrameBinaryProtocol(AudioStreamPacket& packet, int version, size_t* frame_size) {
+    size_t payload_size = packet.PayloadSize();
+    size_t header_size = version == 2 ? sizeof(BinaryProtocol2) : version == 3 ? sizeof(BinaryProtocol3) : 0;
+    if (packet.headroom < header_size || packet.payload_view != nullptr) {
+        // Packets that were not produced by the encoder (e.g. wake word audio) have no headroom
+        std::vector<uint8_t> frame(header_size + payload_size);
+        memcpy(frame.data() + header_size, packet.PayloadData(), payload_size);
+        packet.payload.swap(frame);
+        packet.headroom = header_size;
+        packet.payload_view = nullptr;
+    }
+
+    // Write the header right in front of the payload, the frame is sent from the packet as is
+    uint8_t* header = packet.payload.data() + packet.headroom - header_size;
+    if (version == 2) {
+        auto bp2 = (BinaryProtocol2*)header;
+        bp2->version = htons(version);
+        bp2->type = 0;
+        bp2->reserved = 0;
+        bp2->timestamp = htonl(packet.timestamp);
+        bp2->payload_size = htonl(payload_size);
+    } else if (version == 3) {
+        auto bp3 = (BinaryProtocol3*)header;
+        bp3->type = 0;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(payload_size);
+    }
+    *frame_size = header_size + payload_size;
+    return header;
+}
+
+void Protocol::OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback) {
+    on_incoming_message_ = callback;
 }
 
 void Protocol::OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback) {
@@ -32,6 +108,37 @@ void Protocol::OnDisconnected(std::function<void()> callback) {
     on_disconnected_ = callback;
 }
 
+static bool IsValidUplinkFrameDuration(int frame_duration) {
+    return frame_duration == 20 || frame_duration == 40 || frame_duration == 60;
+}
+
+void Protocol::AddUplinkAudioParams(cJSON* audio_params) {
+    Settings settings("audio", false);
+    int frame_duration = settings.GetInt("frame_duration", CONFIG_OPUS_UPLINK_FRAME_DURATION);
+    uplink_frame_duration_ = IsValidUplinkFrameDuration(frame_duration) ? frame_duration : CONFIG_OPUS_UPLINK_FRAME_DURATION;
+    uplink_bitrate_ = settings.GetInt("bitrate", CONFIG_OPUS_UPLINK_BITRATE);
+    cJSON_AddNumberToObject(audio_params, "frame_duration", uplink_frame_duration_);
+    if (uplink_bitrate_ > 0) {
+        cJSON_AddNumberToObject(audio_params, "bitrate", uplink_bitrate_);
+    }
+}
+
+void Protocol::ParseUplinkAudioParams(const cJSON* audio_params) {
+    // The server may pick other uplink parameters than the ones we proposed
+    auto frame_duration = cJSON_GetObjectItem(audio_params, "uplink_frame_duration");
+    if (cJSON_IsNumber(frame_duration)) {
+        if (IsValidUplinkFrameDuration(frame_duration->valueint)) {
+            uplink_frame_duration_ = frame_duration->valueint;
+        } else {
+            ESP_LOGW(TAG, "Unsupported uplink frame duration: %d", frame_duration->valueint);
+        }
+    }
+    auto bitrate = cJSON_GetObjectItem(audio_params, "uplink_bitrate");
+    if (cJSON_IsNumber(bitrate) && bitrate->valueint >= 0) {
+        uplink_bitrate_ = bitrate->valueint;
+    }
+}
+
 void Protocol::SetError(const std::string& message) {
     error_occurred_ = true;
     if (on_network_error_ != nullptr) {
@@ -6,12 +6,47 @@
 #include <functional>
 #include <chrono>
 #include <vector>
+#include <memory>
+#include <new>
+
+#include "incoming_message.h"
+
+// Packets recycled through two pools, so a congested uplink cannot take the packets of the
+// downlink. Downlink: a full decode queue (40 frames of 60 ms) plus the jitter buffer's largest
+// target and the packets in flight. Uplink: a full send queue (120 frames of 20 ms) plus the
+// packets being encoded and sent. audio_service.h checks both against its queue limits. The
+// audio testing queue holds 10 s of uplink audio and takes the rest from the heap.
+#define AUDIO_STREAM_DOWNLINK_PACKET_POOL_SIZE 48
+#define AUDIO_STREAM_UPLINK_PACKET_POOL_SIZE 124
+
+// Bytes the encoder reserves in front of the payload, so the transport can write its header in place
+#define AUDIO_STREAM_PACKET_HEADROOM 16
+
+enum AudioStreamPacketPool {
+    kAudioStreamPacketPoolDownlink,
+    kAudioStreamPacketPoolUplink,
+};
 
 struct AudioStreamPacket {
     int sample_rate = 0;
     int frame_duration = 0;
     uint32_t timestamp = 0;
+    // Transport sequence number, 0 when the transport is not sequenced (WebSocket)
+    uint32_t sequence = 0;
+    // The first `headroom` bytes are reserved for the transport header, the Opus data follows
     std::vector<uint8_t> payload;
+    size_t headroom = 0;
+    // Read-only view used instead of `payload` when the data outlives the packet (sound assets in flash)
+    const uint8_t* payload_view = nullptr;
+    size_t payload_view_size = 0;
+
+    const uint8_t* PayloadData() const { return payload_view ? payload_view : payload.data() + headroom; }
+    size_t PayloadSize() const { return payload_view ? payload_view_size : payload.size() - headroom; }
+
+    // Get a packet from a packet pool, it goes back to its pool (keeping the payload capacity) when destroyed
+    static std::unique_ptr<AudioStreamPacket> Acquire(AudioStreamPacketPool pool = kAudioStreamPacketPoolDownlink);
+    void Reset();
+    void operator delete(AudioStreamPacket* packet, std::destroying_delete_t);
 };
 
 struct BinaryProtocol2 {
@@ -30,6 +65,11 @@ struct BinaryProtocol3 {
     uint8_t payload[];
 } __attribute__((packed));
 
+// Writes the binary protocol header of `version` (1: none, 2: BinaryProtocol2, 3: BinaryProtocol3)
+// right in front of the payload and returns the frame to send. Encoder packets have the header in
+// their headroom; other packets (wake word audio, sound assets) are copied to a new payload once.
+const uint8_t* FrameBinaryProtocol(AudioStreamPacket& packet, int version, size_t* frame_size);
+
 enum AbortReason {
     kAbortReasonNone,
     kAbortReasonWakeWordDetected
@@ -54,9 +94,15 @@ public:
     inline const std::string& session_id() const {
         return session_id_;
     }
+    inline int uplink_frame_duration() const {
+        return uplink_frame_duration_;
+    }
+    inline int uplink_bitrate() const {
+        return uplink_bitrate_;
+    }
 
     void OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback);
-    void OnIncomingJson(std::function<void(const cJSON* root)> callback);
+    void OnIncomingMessage(std::function<void(const IncomingMessage& message)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
@@ -75,7 +121,7 @@ public:
     virtual void SendMcpMessage(const std::string& message);
 
 protected:
-    std::function<void(const cJSON* root)> on_incoming_json_;
+    std::function<void(const IncomingMessage& message)> on_incoming_message_;
     std::function<void(std::unique_ptr<AudioStreamPacket> packet)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
@@ -85,11 +131,15 @@ protected:
 
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
+    int uplink_frame_duration_ = 60;
+    int uplink_bitrate_ = 0;  // 0: decided by the encoder
     bool error_occurred_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
 
     virtual bool SendText(const std::string& text) = 0;
+    void AddUplinkAudioParams(cJSON* audio_params);
+    void ParseUplinkAudioParams(const cJSON* audio_params);
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
@@ -0,0 +1,60 @@
+#include "udp_audio_cipher.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+
+UdpAudioCipher::UdpAudioCipher() {
+    mbedtls_aes_init(&aes_ctx_);
+}
+
+UdpAudioCipher::~UdpAudioCipher() {
+    mbedtls_aes_free(&aes_ctx_);
+}
+
+bool UdpAudioCipher::SetKey(const std::string& key, const std::string& nonce) {
+    if (key.size() != 16 || nonce.size() != MQTT_UDP_NONCE_SIZE ||
+        mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)key.data(), 128) != 0) {
+        nonce_.clear();
+        return false;
+    }
+    nonce_ = nonce;
+    return true;
+}
+
+const std::string* UdpAudioCipher::Encrypt(const AudioStreamPacket& packet, uint32_t sequence) {
+    // Nonce header followed by the encrypted payload
+    size_t payload_size = packet.PayloadSize();
+    send_buffer_.resize(MQTT_UDP_NONCE_SIZE + payload_size);
+    auto datagram = (uint8_t*)send_buffer_.data();
+    memcpy(datagram, nonce_.data(), MQTT_UDP_NONCE_SIZE);
+    *(uint16_t*)&datagram[2] = htons(payload_size);
+    *(uint32_t*)&datagram[8] = htonl(packet.timestamp);
+    *(uint32_t*)&datagram[12] = htonl(sequence);
+
+    // mbedtls advances the counter block, so it works on a copy of the header
+    uint8_t nonce_counter[MQTT_UDP_NONCE_SIZE];
+    memcpy(nonce_counter, datagram, sizeof(nonce_counter));
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    if (mbedtls_aes_crypt_ctr(&aes_ctx_, payload_size, &nc_off, nonce_counter, stream_block,
+        packet.PayloadData(), datagram + MQTT_UDP_NONCE_SIZE) != 0) {
+        return nullptr;
+    }
+    return &send_buffer_;
+}
+
+bool UdpAudioCipher::Decrypt(const std::string& datagram, AudioStreamPacket& packet) {
+    if (datagram.size() < MQTT_UDP_NONCE_SIZE) {
+        return false;
+    }
+    size_t payload_size = datagram.size() - MQTT_UDP_NONCE_SIZE;
+    // The received buffer is read-only, mbedtls advances its own copy of the counter block
+    uint8_t nonce_counter[MQTT_UDP_NONCE_SIZE];
+    memcpy(nonce_counter, datagram.data(), sizeof(nonce_counter));
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    packet.payload.resize(payload_size);
+    packet.headroom = 0;
+    return mbedtls_aes_crypt_ctr(&aes_ctx_, payload_size, &nc_off, nonce_counter, stream_block,
+        (const uint8_t*)datagram.data() + MQTT_UDP_NONCE_SIZE, packet.payload.data()) == 0;
+}
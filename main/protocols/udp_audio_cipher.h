@@ -0,0 +1,40 @@
+#ifndef UDP_AUDIO_CIPHER_H
+#define UDP_AUDIO_CIPHER_H
+
+#include "protocol.h"
+
+#include <mbedtls/aes.h>
+#include <string>
+
+// The UDP audio header doubles as the AES-CTR nonce counter block
+#define MQTT_UDP_NONCE_SIZE 16
+
+/*
+ * AES-CTR of one MQTT UDP audio channel. Outgoing datagrams are built in a buffer that keeps its
+ * capacity across frames, incoming payloads are decrypted straight into the packet buffer.
+ *
+ * UDP Encrypted OPUS Packet Format:
+ * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
+ * |payload payload_len|
+ */
+class UdpAudioCipher {
+public:
+    UdpAudioCipher();
+    ~UdpAudioCipher();
+
+    // Takes the decoded key and nonce of the server hello, the cipher is not ready when they are invalid
+    bool SetKey(const std::string& key, const std::string& nonce);
+    bool IsReady() const { return nonce_.size() == MQTT_UDP_NONCE_SIZE; }
+
+    // Returns the datagram of a packet, valid until the next call, or nullptr when encryption fails
+    const std::string* Encrypt(const AudioStreamPacket& packet, uint32_t sequence);
+    // Decrypts the payload of a received datagram into the packet's payload buffer
+    bool Decrypt(const std::string& datagram, AudioStreamPacket& packet);
+
+private:
+    mbedtls_aes_context aes_ctx_;
+    std::string nonce_;
+    std::string send_buffer_;
+};
+
+#endif // UDP_AUDIO_CIPHER_H
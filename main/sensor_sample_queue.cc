@@ -0,0 +1,77 @@
+#include "sensor_sample_queue.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#define TAG "SensorSampleQueue"
+
+#define SENSOR_SAMPLE_QUEUE_VERSION 1
+
+void SensorSampleQueue::Push(const SensorSample& sample) {
+    if (count_ == samples_.size()) {
+        head_ = (head_ + 1) % samples_.size();
+        count_--;
+        dropped_++;
+    }
+    samples_[(head_ + count_) % samples_.size()] = sample;
+    count_++;
+}
+
+const SensorSample& SensorSampleQueue::At(size_t index) const {
+    return samples_[(head_ + index) % samples_.size()];
+}
+
+void SensorSampleQueue::PopFront(size_t count) {
+    count = std::min(count, count_);
+    head_ = (head_ + count) % samples_.size();
+    count_ -= count;
+    if (count_ == 0) {
+        head_ = 0;
+    }
+}
+
+void SensorSampleQueue::Save() {
+    Settings settings("sensor_upload", true);
+    if (count_ == 0) {
+        if (saved_) {
+            settings.EraseKey("backlog");
+            saved_ = false;
+        }
+        return;
+    }
+
+    // [0] version, [1-3] reserved, then the newest samples from oldest to newest
+    size_t count = std::min<size_t>(count_, SENSOR_SAMPLE_QUEUE_SAVE_SAMPLES);
+    std::vector<uint8_t> blob(4 + count * sizeof(SensorSample));
+    blob[0] = SENSOR_SAMPLE_QUEUE_VERSION;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(blob.data() + 4 + i * sizeof(SensorSample), &At(count_ - count + i), sizeof(SensorSample));
+    }
+    if (settings.SetBlob("backlog", blob.data(), blob.size())) {
+        saved_ = true;
+        ESP_LOGI(TAG, "Saved %u samples", (unsigned)count);
+    }
+}
+
+void SensorSampleQueue::Load() {
+    Settings settings("sensor_upload");
+    auto blob = settings.GetBlob("backlog");
+    if (blob.size() < 4) {
+        return;
+    }
+    saved_ = true;
+    size_t samples = (blob.size() - 4) / sizeof(SensorSample);
+    if (blob[0] != SENSOR_SAMPLE_QUEUE_VERSION || blob.size() != 4 + samples * sizeof(SensorSample)) {
+        ESP_LOGW(TAG, "Invalid backlog (%u bytes), discarded", (unsigned)blob.size());
+        return;
+    }
+    for (size_t i = 0; i < samples; i++) {
+        SensorSample sample;
+        memcpy(&sample, blob.data() + 4 + i * sizeof(SensorSample), sizeof(SensorSample));
+        Push(sample);
+    }
+    ESP_LOGI(TAG, "Loaded %u samples", (unsigned)samples);
+}
@@ -0,0 +1,50 @@
+#ifndef SENSOR_SAMPLE_QUEUE_H
+#define SENSOR_SAMPLE_QUEUE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 约40分钟的10秒采样
+#define SENSOR_SAMPLE_QUEUE_CAPACITY 160
+// 保存到NVS的最新采样数（约2.4KB），与温湿度历史的快照共用NVS预算（见sensor_history.cc）
+#define SENSOR_SAMPLE_QUEUE_SAVE_SAMPLES 100
+
+struct SensorSample {
+    int64_t timestamp;      // 采样时间（Unix毫秒）；time_synced为false时是开机后的毫秒数
+    float temperature;
+    float humidity;
+    int32_t status;
+    bool time_synced;       // 采样时系统时间是否已通过SNTP同步
+};
+
+/*
+ * 待上传的温湿度采样环形缓冲区（存储转发）
+ *
+ * 上传失败的采样保留在这里，网络恢复后按顺序补传。缓冲区满时丢弃最旧的采样。
+ * Save()/Load()把缓冲区保存到NVS，重启后不会丢失积压的数据。
+ * 不是线程安全的，只在上传任务中使用。
+ */
+class SensorSampleQueue {
+public:
+    void Push(const SensorSample& sample);
+    // index 0 是最旧的采样
+    const SensorSample& At(size_t index) const;
+    void PopFront(size_t count);
+    size_t Size() const { return count_; }
+    bool Empty() const { return count_ == 0; }
+    uint32_t dropped() const { return dropped_; }
+
+    // 保存到NVS；队列为空时删除已保存的数据
+    void Save();
+    void Load();
+
+private:
+    std::array<SensorSample, SENSOR_SAMPLE_QUEUE_CAPACITY> samples_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    uint32_t dropped_ = 0;
+    bool saved_ = false;
+};
+
+#endif // SENSOR_SAMPLE_QUEUE_H
@@ -1,36 +1,74 @@
 #include "sensor_upload.h"
 #include <esp_log.h>
-#include <cJSON.h>
 #include <cstring>
 #include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <sys/time.h>
 
 #define TAG "SensorUpload"
 #define DEFAULT_UPLOAD_INTERVAL 300 // 默认5分钟上传一次
 
+// 积压的数据可能在重启或长时间断网后才补传，所以用系统时间（Unix毫秒）作为采样时间；
+// SNTP同步前系统时间无效，只能用开机后的毫秒数，并标记为时间未同步
+static SensorSample MakeSample(float temperature, float humidity, int status) {
+    SensorSample sample = {};
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    struct tm tm;
+    localtime_r(&tv.tv_sec, &tm);
+    sample.time_synced = tm.tm_year >= 2025 - 1900;
+    sample.timestamp = sample.time_synced ? (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 : esp_timer_get_time() / 1000;
+    sample.temperature = temperature;
+    sample.humidity = humidity;
+    sample.status = status;
+    return sample;
+}
+
 SensorDataUploader::SensorDataUploader()
     : upload_interval_seconds_(DEFAULT_UPLOAD_INTERVAL)
     , upload_timer_(nullptr)
-    , is_running_(false)
-    , last_temperature_(0)
-    , last_humidity_(0)
-    , has_last_data_(false) {
+    , is_running_(false) {
+    upload_queue_ = xQueueCreate(SENSOR_UPLOAD_QUEUE_SIZE, sizeof(UploadRequest));
+    upload_task_exited_ = xSemaphoreCreateBinary();
+    // esp_http_client_perform在这个任务中运行，https的TLS握手（mbedtls）还要占用几KB栈，
+    // 第一次上传后打印剩余的栈空间（uxTaskGetStackHighWaterMark）
+    xTaskCreate([](void* arg) {
+        SensorDataUploader* uploader = (SensorDataUploader*)arg;
+        uploader->UploadTask();
+        xSemaphoreGive(uploader->upload_task_exited_);
+        vTaskDelete(NULL);
+    }, "sensor_upload", 8192, this, 2, &upload_task_handle_);
 }
 
 SensorDataUploader::~SensorDataUploader() {
     Stop();
+
+    // 等待正在进行的上传完成后再释放资源
+    UploadRequest request = {};
+    request.stop = true;
+    xQueueReset(upload_queue_);
+    xQueueSend(upload_queue_, &request, portMAX_DELAY);
+    xSemaphoreTake(upload_task_exited_, portMAX_DELAY);
+    vSemaphoreDelete(upload_task_exited_);
+    vQueueDelete(upload_queue_);
+    CloseHttpClient();
 }
 
 void SensorDataUploader::SetUploadUrl(const std::string& url) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
     upload_url_ = url;
     ESP_LOGI(TAG, "Upload URL set to: %s", url.c_str());
 }
 
 void SensorDataUploader::SetApiKey(const std::string& api_key) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
     api_key_ = api_key;
     ESP_LOGI(TAG, "API Key set");
 }
 
 void SensorDataUploader::SetDeviceId(const std::string& device_id) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
     device_id_ = device_id;
     ESP_LOGI(TAG, "Device ID set to: %s", device_id.c_str());
 }
@@ -40,7 +78,18 @@ void SensorDataUploader::SetUploadInterval(int interval_seconds) {
     ESP_LOGI(TAG, "Upload interval set to: %d seconds", interval_seconds);
 }
 
+void SensorDataUploader::SetBatchSize(int batch_size) {
+    batch_size_ = std::clamp(batch_size, 1, SENSOR_UPLOAD_MAX_BATCH);
+    ESP_LOGI(TAG, "Batch size set to: %d", batch_size_.load());
+}
+
+void SensorDataUploader::SetBatchMaxLatency(int latency_ms) {
+    batch_max_latency_ms_ = std::max(latency_ms, 0);
+    ESP_LOGI(TAG, "Batch max latency set to: %d ms", batch_max_latency_ms_.load());
+}
+
 void SensorDataUploader::SetUploadCallback(UploadCallback callback) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
     callback_ = callback;
 }
 
@@ -54,123 +103,251 @@ bool SensorDataUploader::UploadSensorData(float temperature, float humidity, int
         return false;
     }
 
-    // 注释掉去重逻辑，确保定时上传
-    // 温湿度稳定时也需要上传数据，避免网页显示离线
-    /*
-    if (has_last_data_ &&
-        std::abs(temperature - last_temperature_) < 0.1f &&
-        std::abs(humidity - last_humidity_) < 1.0f) {
-        ESP_LOGD(TAG, "Sensor data unchanged, skipping upload");
+    // 手动上传不经过上传策略（SensorUploadPolicy），总是立即上传
+    // 构建JSON数据
+    SensorSample sample = MakeSample(temperature, humidity, status);
+    std::string device_id;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        device_id = device_id_;
+    }
+    char buffer[256];
+    TelemetryWriter writer(buffer);
+    WriteSample(writer, sample, device_id);
+    if (!writer.ok()) {
+        ESP_LOGE(TAG, "Sensor data does not fit in %u bytes", (unsigned)sizeof(buffer));
         if (callback) {
-            callback(true, "Data unchanged");
+            callback(false, "Sensor data too large");
         }
-        return true;
+        return false;
     }
-    */
-
-    // 构建JSON数据
-    std::string json_data = BuildJson(temperature, humidity, status);
+    ESP_LOGD(TAG, "Built JSON: %s", writer.data());
 
     // 上传数据
-    bool success = PostData(json_data, callback);
-
-    // 保存数据
-    last_temperature_ = temperature;
-    last_humidity_ = humidity;
-    has_last_data_ = true;
+    bool success = PostData(writer.data(), writer.size(), callback);
 
     return success;
 }
 
-std::string SensorDataUploader::BuildJson(float temperature, float humidity, int status) {
-    cJSON* root = cJSON_CreateObject();
-    if (root == nullptr) {
-        ESP_LOGE(TAG, "Failed to create JSON object");
-        return "";
+bool SensorDataUploader::UploadSensorDataAsync(float temperature, float humidity, int status) {
+    if (std::isnan(temperature) || std::isnan(humidity)) {
+        ESP_LOGW(TAG, "Invalid sensor data: temp=%f, humi=%f", temperature, humidity);
+        return false;
     }
 
-    // 添加设备ID
-    if (!device_id_.empty()) {
-        cJSON_AddStringToObject(root, "device_id", device_id_.c_str());
+    UploadRequest request = { MakeSample(temperature, humidity, status), false };
+    if (xQueueSend(upload_queue_, &request, 0) != pdTRUE) {
+        // 队列已满（服务器响应慢），丢弃最旧的数据，保留最新的
+        UploadRequest oldest;
+        if (xQueueReceive(upload_queue_, &oldest, 0) == pdTRUE) {
+            dropped_count_++;
+            ESP_LOGW(TAG, "Upload queue full, dropped oldest sample (%lu dropped)", (unsigned long)dropped_count_);
+        }
+        if (xQueueSend(upload_queue_, &request, 0) != pdTRUE) {
+            return false;
+        }
     }
+    return true;
+}
 
-    // 添加温湿度数据
-    cJSON_AddNumberToObject(root, "temperature", temperature);
-    cJSON_AddNumberToObject(root, "humidity", humidity);
-
-    // 添加时间戳
-    cJSON_AddNumberToObject(root, "timestamp", esp_timer_get_time() / 1000);
-
-    // 添加设备状态（0=待机, 1=唤醒中, 2=录音中, 3=播放中, 4=配置中）
-    cJSON_AddNumberToObject(root, "device_status", status);
+void SensorDataUploader::UploadTask() {
+    // 上次未上传的数据（例如断网期间重启）
+    backlog_.Load();
+    if (!backlog_.Empty()) {
+        oldest_sample_time_us_ = esp_timer_get_time();
+    }
 
-    // 转换为字符串
-    char* json_str = cJSON_PrintUnformatted(root);
-    std::string result = json_str ? json_str : "";
+    UploadRequest request;
+    while (true) {
+        TickType_t wait = portMAX_DELAY;
+        if (!backlog_.Empty()) {
+            int64_t delay_us = GetNextFlushTime() - esp_timer_get_time();
+            wait = delay_us > 0 ? pdMS_TO_TICKS(delay_us / 1000) + 1 : 0;
+        }
+        if (xQueueReceive(upload_queue_, &request, wait) == pdTRUE) {
+            if (request.stop) {
+                break;
+            }
+            // 数据没有变化时不上传（死区、心跳、限速）
+            if (!policy_.Accept(request.sample, esp_timer_get_time())) {
+                ESP_LOGD(TAG, "Sample unchanged, skipped (%lu uploaded, %lu skipped)",
+                    (unsigned long)policy_.accepted_count(), (unsigned long)policy_.suppressed_count());
+                continue;
+            }
+            if (backlog_.Empty()) {
+                oldest_sample_time_us_ = esp_timer_get_time();
+            }
+            backlog_.Push(request.sample);
+        }
+        FlushBacklog();
+    }
 
-    // 清理
-    free(json_str);
-    cJSON_Delete(root);
+    // 保存尚未上传的数据，下次启动后补传
+    backlog_.Save();
+}
 
-    ESP_LOGI(TAG, "Built JSON: %s", result.c_str());
-    return result;
+int64_t SensorDataUploader::GetNextFlushTime() const {
+    if (retry_time_us_ != 0) {
+        return retry_time_us_;
+    }
+    if (backlog_.Size() >= (size_t)batch_size_) {
+        return 0;
+    }
+    return oldest_sample_time_us_ + (int64_t)batch_max_latency_ms_ * 1000;
 }
 
-bool SensorDataUploader::PostData(const std::string& json_data, UploadCallback callback) {
-    if (upload_url_.empty()) {
-        ESP_LOGE(TAG, "Upload URL not configured");
-        if (callback) {
-            callback(false, "Upload URL not configured");
-        }
-        return false;
+void SensorDataUploader::FlushBacklog() {
+    int64_t now = esp_timer_get_time();
+    if (backlog_.Empty() || GetNextFlushTime() > now) {
+        return;
     }
 
-    esp_http_client_config_t config = {};
-    config.url = upload_url_.c_str();
-    config.method = HTTP_METHOD_POST;
-    config.timeout_ms = 2000;
-    config.buffer_size = 4096;
-    config.buffer_size_tx = 4096;
+    // 不合并上传时每次只发一条（服务器按单条JSON对象接收）
+    size_t count = batch_size_ > 1 ? std::min(backlog_.Size(), (size_t)SENSOR_UPLOAD_MAX_BATCH) : 1;
+    size_t size = BuildBatchJson(count);
+    if (size == 0) {
+        // 单条数据都放不下（设备ID过长），无法上传
+        ESP_LOGE(TAG, "Sensor data does not fit in the request buffer, dropped");
+        backlog_.PopFront(1);
+        return;
+    }
+    UploadCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        callback = callback_;
+    }
+    bool success = PostData(request_buffer_, size, callback);
+    if (!stack_logged_) {
+        stack_logged_ = true;
+        ESP_LOGI(TAG, "Upload task remain stack size=%d", (int)uxTaskGetStackHighWaterMark(nullptr));
+    }
+    if (success) {
+        backlog_.PopFront(count);
+        retry_time_us_ = 0;
+        retry_delay_ms_ = SENSOR_UPLOAD_RETRY_MIN_MS;
+        if (backlog_.Empty()) {
+            // 已保存到NVS的积压数据已全部补传
+            backlog_.Save();
+        }
+        return;
+    }
 
-    // 设置API Key头部
-    char auth_header[256];
-    if (!api_key_.empty()) {
-        snprintf(auth_header, sizeof(auth_header), "Bearer %s", api_key_.c_str());
-        config.user_agent = auth_header;
+    // 上传失败，保留数据并稍后重试（指数退避）
+    retry_time_us_ = now + (int64_t)retry_delay_ms_ * 1000;
+    retry_delay_ms_ = std::min(retry_delay_ms_ * 2, SENSOR_UPLOAD_RETRY_MAX_MS);
+    ESP_LOGW(TAG, "%u samples pending, retry in %d ms", (unsigned)backlog_.Size(), (int)((retry_time_us_ - now) / 1000));
+    // 限制写NVS的频率，减少Flash磨损
+    if (last_save_time_us_ == 0 || now - last_save_time_us_ >= (int64_t)SENSOR_UPLOAD_SAVE_INTERVAL_MS * 1000) {
+        backlog_.Save();
+        last_save_time_us_ = now;
     }
+}
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+void SensorDataUploader::WriteSample(TelemetryWriter& writer, const SensorSample& sample, const std::string& device_id) {
+    writer.BeginObject();
+    // 添加设备ID
+    if (!device_id.empty()) {
+        writer.Field("device_id", device_id.c_str());
+    }
+    // 添加温湿度数据
+    writer.Field("temperature", sample.temperature);
+    writer.Field("humidity", sample.humidity);
+    // 添加时间戳（采样时间，Unix毫秒）；服务器可以按device_id和timestamp去掉重复上传的数据
+    writer.Field("timestamp", sample.timestamp);
+    if (!sample.time_synced) {
+        // 系统时间未同步，timestamp是开机后的毫秒数
+        writer.Field("time_synced", false);
+    }
+    // 添加设备状态（0=待机, 1=唤醒中, 2=录音中, 3=播放中, 4=配置中）
+    writer.Field("device_status", sample.status);
+    writer.EndObject();
+}
 
-    // 设置请求体
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    if (!api_key_.empty()) {
-        esp_http_client_set_header(client, "Authorization", auth_header);
+size_t SensorDataUploader::BuildBatchJson(size_t& count) {
+    std::string device_id;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        device_id = device_id_;
     }
-    esp_http_client_set_post_field(client, json_data.c_str(), json_data.length());
+    // 单条数据保持原有的JSON对象格式，多条数据合并为JSON数组；缓冲区放不下时减少条数
+    for (; count > 0; count /= 2) {
+        TelemetryWriter writer(request_buffer_);
+        if (count > 1) {
+            writer.BeginArray();
+        }
+        for (size_t i = 0; i < count; i++) {
+            WriteSample(writer, backlog_.At(i), device_id);
+        }
+        if (count > 1) {
+            writer.EndArray();
+        }
+        if (writer.ok()) {
+            ESP_LOGD(TAG, "Built JSON: %s", writer.data());
+            return writer.size();
+        }
+    }
+    return 0;
+}
 
-    // 执行请求
-    esp_err_t err = esp_http_client_perform(client);
+bool SensorDataUploader::PostData(const char* data, size_t size, UploadCallback callback) {
+    std::string url, api_key;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        url = upload_url_;
+        api_key = api_key_;
+    }
+    if (url.empty()) {
+        ESP_LOGE(TAG, "Upload URL not configured");
+        if (callback) {
+            callback(false, "Upload URL not configured");
+        }
+        return false;
+    }
 
-    bool success = (err == ESP_OK);
+    std::lock_guard<std::mutex> lock(http_mutex_);
+    esp_err_t err = ESP_FAIL;
     int status_code = 0;
+    // 服务器可能已关闭空闲连接，连接或发送失败时重新建立连接再试一次。
+    // 请求发出后才失败（例如等待响应超时）时服务器可能已经收到数据，不立即重发，
+    // 数据留在积压队列中按退避时间补传，服务器按timestamp去重
+    for (int attempt = 0; attempt < 2; attempt++) {
+        esp_http_client_handle_t client = GetHttpClient(url, api_key);
+        if (client == nullptr) {
+            err = ESP_ERR_NO_MEM;
+            break;
+        }
+        esp_http_client_set_post_field(client, data, size);
+        err = esp_http_client_perform(client);
+        if (err == ESP_OK) {
+            status_code = esp_http_client_get_status_code(client);
+            ESP_LOGI(TAG, "HTTP POST Status = %d, content_length = %lld",
+                     status_code, (long long)esp_http_client_get_content_length(client));
+            break;
+        }
+        CloseHttpClient();
+        if (err != ESP_ERR_HTTP_CONNECT && err != ESP_ERR_HTTP_WRITE_DATA) {
+            break;
+        }
+        ESP_LOGW(TAG, "HTTP POST request failed: %s, reconnecting", esp_err_to_name(err));
+    }
 
-    if (success) {
-        status_code = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "HTTP POST Status = %d, content_length = %lld",
-                 status_code, esp_http_client_get_content_length(client));
-    } else {
+    // 只有2xx表示服务器已收到数据，其他状态码的数据保留在积压队列中稍后重试
+    bool success = (err == ESP_OK && status_code >= 200 && status_code < 300);
+    if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP POST request failed: %s", esp_err_to_name(err));
+    } else if (!success) {
+        ESP_LOGE(TAG, "HTTP POST rejected with status %d", status_code);
     }
 
-    // 清理
-    esp_http_client_cleanup(client);
-
     // 调用回调
     if (callback) {
         char message[256];
         if (success) {
             snprintf(message, sizeof(message), "Upload success, HTTP %d", status_code);
             callback(true, message);
+        } else if (err == ESP_OK) {
+            snprintf(message, sizeof(message), "Upload failed, HTTP %d", status_code);
+            callback(false, message);
         } else {
             snprintf(message, sizeof(message), "Upload failed: %s", esp_err_to_name(err));
             callback(false, message);
@@ -180,6 +357,50 @@ bool SensorDataUploader::PostData(const std::string& json_data, UploadCallback c
     return success;
 }
 
+esp_http_client_handle_t SensorDataUploader::GetHttpClient(const std::string& url, const std::string& api_key) {
+    if (http_client_ != nullptr && http_client_url_ == url && http_client_api_key_ == api_key) {
+        return http_client_;
+    }
+    CloseHttpClient();
+
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.method = HTTP_METHOD_POST;
+    config.timeout_ms = 2000;
+    config.buffer_size = 4096;
+    config.buffer_size_tx = 4096;
+    config.keep_alive_enable = true;
+
+    // 设置API Key头部
+    char auth_header[256];
+    if (!api_key.empty()) {
+        snprintf(auth_header, sizeof(auth_header), "Bearer %s", api_key.c_str());
+        config.user_agent = auth_header;
+    }
+
+    http_client_ = esp_http_client_init(&config);
+    if (http_client_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create HTTP client");
+        return nullptr;
+    }
+    esp_http_client_set_header(http_client_, "Content-Type", "application/json");
+    if (!api_key.empty()) {
+        esp_http_client_set_header(http_client_, "Authorization", auth_header);
+    }
+    http_client_url_ = url;
+    http_client_api_key_ = api_key;
+    connection_count_++;
+    ESP_LOGD(TAG, "HTTP client created (%lu so far)", (unsigned long)connection_count_);
+    return http_client_;
+}
+
+void SensorDataUploader::CloseHttpClient() {
+    if (http_client_ != nullptr) {
+        esp_http_client_cleanup(http_client_);
+        http_client_ = nullptr;
+    }
+}
+
 void SensorDataUploader::Start() {
     if (is_running_) {
         ESP_LOGW(TAG, "Uploader already running");
@@ -1,11 +1,28 @@
 #ifndef SENSOR_UPLOAD_H
 #define SENSOR_UPLOAD_H
 
+#include "sensor_sample_queue.h"
+#include "sensor_upload_policy.h"
+#include "telemetry_writer.h"
+
 #include <esp_http_client.h>
 #include <esp_timer.h>
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <string>
+#include <atomic>
 #include <functional>
+#include <mutex>
+
+#define SENSOR_UPLOAD_QUEUE_SIZE 4
+#define SENSOR_UPLOAD_MAX_BATCH 32
+#define SENSOR_UPLOAD_BUFFER_SIZE 4096
+#define SENSOR_UPLOAD_RETRY_MIN_MS 5000
+#define SENSOR_UPLOAD_RETRY_MAX_MS 60000
+#define SENSOR_UPLOAD_SAVE_INTERVAL_MS (10 * 60 * 1000)
 
 class SensorDataUploader {
 public:
@@ -20,6 +37,10 @@ public:
     void SetApiKey(const std::string& api_key);
     void SetDeviceId(const std::string& device_id);
     void SetUploadInterval(int interval_seconds);
+    // 合并上传：积累batch_size条数据或最旧的数据等待超过max_latency_ms后上传一次（JSON数组）
+    // 默认batch_size为1，每条数据单独上传
+    void SetBatchSize(int batch_size);
+    void SetBatchMaxLatency(int latency_ms);
 
     // 启动/停止自动上传
     void Start();
@@ -29,31 +50,70 @@ public:
     // status: 设备状态（0=待机, 1=唤醒中, 2=录音中, 3=播放中, 4=配置中）
     bool UploadSensorData(float temperature, float humidity, int status = 0, UploadCallback callback = nullptr);
 
+    // 异步上传：只把数据放入队列，由上传任务执行HTTP请求，不阻塞调用者（可在esp_timer回调中调用）
+    // 按上传策略过滤没有变化的数据；上传失败的数据保留在积压队列（保存到NVS）中，网络恢复后补传
+    // 结果通过SetUploadCallback设置的回调通知
+    bool UploadSensorDataAsync(float temperature, float humidity, int status = 0);
+
     // 设置上传回调
     void SetUploadCallback(UploadCallback callback);
 
 private:
+    // 配置可以在任意任务中修改，上传任务在config_mutex_保护下复制后使用
+    std::mutex config_mutex_;
     std::string upload_url_;
     std::string api_key_;
     std::string device_id_;
+    UploadCallback callback_;
+    std::atomic<int> batch_size_ = 1;
+    std::atomic<int> batch_max_latency_ms_ = 0;
     int upload_interval_seconds_;
     esp_timer_handle_t upload_timer_;
     bool is_running_;
-    UploadCallback callback_;
 
-    // 上一次的温湿度数据，用于去重
-    float last_temperature_;
-    float last_humidity_;
-    bool has_last_data_;
+    struct UploadRequest {
+        SensorSample sample;
+        bool stop;
+    };
+    QueueHandle_t upload_queue_ = nullptr;
+    TaskHandle_t upload_task_handle_ = nullptr;
+    SemaphoreHandle_t upload_task_exited_ = nullptr;
+    uint32_t dropped_count_ = 0;
+
+    bool stack_logged_ = false;
+    // 上传策略、积压队列和重试状态只在上传任务中访问
+    SensorUploadPolicy policy_;
+    SensorSampleQueue backlog_;
+    char request_buffer_[SENSOR_UPLOAD_BUFFER_SIZE];
+    int64_t oldest_sample_time_us_ = 0;
+    int64_t retry_time_us_ = 0;
+    int retry_delay_ms_ = SENSOR_UPLOAD_RETRY_MIN_MS;
+    int64_t last_save_time_us_ = 0;
+
+    // 长连接HTTP客户端（keep-alive），URL或API Key变化、请求失败时重建
+    std::mutex http_mutex_;
+    esp_http_client_handle_t http_client_ = nullptr;
+    std::string http_client_url_;
+    std::string http_client_api_key_;
+    uint32_t connection_count_ = 0;
 
     // 定时器回调
     static void TimerCallback(void* arg);
 
+    // 上传任务，串行执行队列中的上传请求
+    void UploadTask();
+    int64_t GetNextFlushTime() const;
+    void FlushBacklog();
+
     // 执行HTTP POST请求
-    bool PostData(const std::string& json_data, UploadCallback callback);
+    bool PostData(const char* data, size_t size, UploadCallback callback);
+    esp_http_client_handle_t GetHttpClient(const std::string& url, const std::string& api_key);
+    void CloseHttpClient();
 
     // 构建JSON数据
-    std::string BuildJson(float temperature, float humidity, int status = 0);
+    static void WriteSample(TelemetryWriter& writer, const SensorSample& sample, const std::string& device_id);
+    // 把积压队列中最旧的count条数据写入request_buffer_，返回长度；放不下时count会减少
+    size_t BuildBatchJson(size_t& count);
 };
 
 #endif // SENSOR_UPLOAD_H
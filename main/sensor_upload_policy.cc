@@ -0,0 +1,51 @@
+#include "sensor_upload_policy.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <cmath>
+
+#define TAG "SensorUploadPolicy"
+
+SensorUploadPolicy::SensorUploadPolicy() {
+    Settings settings("sensor_upload");
+    config_.temperature_deadband_x100 = settings.GetInt("temp_deadband", config_.temperature_deadband_x100);
+    config_.humidity_deadband_x100 = settings.GetInt("humi_deadband", config_.humidity_deadband_x100);
+    config_.heartbeat_seconds = settings.GetInt("heartbeat", config_.heartbeat_seconds);
+    config_.min_interval_seconds = settings.GetInt("min_interval", config_.min_interval_seconds);
+    ESP_LOGI(TAG, "Deadband: %d.%02d°C / %d.%02d%%, heartbeat: %ds, min interval: %ds",
+        config_.temperature_deadband_x100 / 100, config_.temperature_deadband_x100 % 100,
+        config_.humidity_deadband_x100 / 100, config_.humidity_deadband_x100 % 100,
+        config_.heartbeat_seconds, config_.min_interval_seconds);
+}
+
+bool SensorUploadPolicy::Accept(const SensorSample& sample, int64_t now_us) {
+    bool accept;
+    if (!has_last_ || sample.status != last_.status) {
+        // 第一个采样和设备状态变化立即上传
+        accept = true;
+    } else {
+        int64_t elapsed_us = now_us - last_time_us_;
+        // 死区用定点数比较，避免浮点误差（0.1°C 的变化算作超过 0.1°C 死区）
+        int temperature_change = std::abs((int)lroundf((sample.temperature - last_.temperature) * 100));
+        int humidity_change = std::abs((int)lroundf((sample.humidity - last_.humidity) * 100));
+        bool changed = temperature_change >= config_.temperature_deadband_x100 ||
+            humidity_change >= config_.humidity_deadband_x100;
+        if (elapsed_us >= (int64_t)config_.heartbeat_seconds * 1000000) {
+            accept = true;
+        } else if (elapsed_us < (int64_t)config_.min_interval_seconds * 1000000) {
+            accept = false;
+        } else {
+            accept = changed;
+        }
+    }
+
+    if (!accept) {
+        suppressed_count_++;
+        return false;
+    }
+    accepted_count_++;
+    has_last_ = true;
+    last_ = sample;
+    last_time_us_ = now_us;
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef SENSOR_UPLOAD_POLICY_H
+#define SENSOR_UPLOAD_POLICY_H
+
+#include "sensor_sample_queue.h"
+
+#include <cstdint>
+
+/*
+ * 温湿度上传策略：只在数据有变化时上传
+ *
+ * - 设备状态变化时立即上传
+ * - 温度或湿度与上次上传的值相差超过死区时上传，但两次上传至少间隔min_interval
+ * - 超过heartbeat没有上传时无论是否变化都上传一次，避免网页显示离线
+ *
+ * 参数从NVS的sensor_upload命名空间读取，见SENSOR_UPLOAD_README.md
+ */
+class SensorUploadPolicy {
+public:
+    struct Config {
+        int temperature_deadband_x100 = 10;   // 0.1°C
+        int humidity_deadband_x100 = 100;     // 1%
+        int heartbeat_seconds = 60;
+        int min_interval_seconds = 5;
+    };
+
+    SensorUploadPolicy();
+
+    void SetConfig(const Config& config) { config_ = config; }
+    const Config& config() const { return config_; }
+
+    // 返回true表示这个采样需要上传，同时把它记为最近一次上传的值
+    bool Accept(const SensorSample& sample, int64_t now_us);
+
+    uint32_t accepted_count() const { return accepted_count_; }
+    uint32_t suppressed_count() const { return suppressed_count_; }
+
+private:
+    Config config_;
+    bool has_last_ = false;
+    SensorSample last_ = {};
+    int64_t last_time_us_ = 0;
+    uint32_t accepted_count_ = 0;
+    uint32_t suppressed_count_ = 0;
+};
+
+#endif // SENSOR_UPLOAD_POLICY_H
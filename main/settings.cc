@@ -88,6 +88,36 @@ void Settings::SetBool(const std::string& key, bool value) {
     }
 }
 
+std::vector<uint8_t> Settings::GetBlob(const std::string& key) {
+    std::vector<uint8_t> value;
+    if (nvs_handle_ == 0) {
+        return value;
+    }
+
+    size_t length = 0;
+    if (nvs_get_blob(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
+        return value;
+    }
+    value.resize(length);
+    ESP_ERROR_CHECK(nvs_get_blob(nvs_handle_, key.c_str(), value.data(), &length));
+    return value;
+}
+
+// Blobs can be large, so running out of NVS space is reported instead of aborting
+bool Settings::SetBlob(const std::string& key, const void* data, size_t size) {
+    if (!read_write_) {
+        ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return false;
+    }
+    esp_err_t ret = nvs_set_blob(nvs_handle_, key.c_str(), data, size);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write blob %s (%u bytes): %s", key.c_str(), size, esp_err_to_name(ret));
+        return false;
+    }
+    dirty_ = true;
+    return true;
+}
+
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
         auto ret = nvs_erase_key(nvs_handle_, key.c_str());
@@ -0,0 +1,142 @@
+#ifndef TELEMETRY_WRITER_H
+#define TELEMETRY_WRITER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+/*
+ * 把遥测数据直接序列化为JSON写入调用者提供的缓冲区，不分配堆内存
+ *
+ *   char buffer[256];
+ *   TelemetryWriter writer(buffer);
+ *   writer.BeginObject();
+ *   writer.Field("device_id", "pcroom-esp32");
+ *   writer.Field("temperature", 23.5f);
+ *   writer.EndObject();
+ *   if (writer.ok()) { use writer.data(), writer.size() }
+ *
+ * 新的传感器字段直接调用Field()添加；字段类型在编译期选择格式：
+ * 整数原样输出，浮点数保留2位小数（NaN/Inf输出null），字符串转义后加引号。
+ * 缓冲区不够时ok()返回false，内容被截断，不能使用。
+ */
+class TelemetryWriter {
+public:
+    TelemetryWriter(char* buffer, size_t size) : buffer_(buffer), capacity_(size) {
+        if (capacity_ > 0) {
+            buffer_[0] = '\0';
+        }
+    }
+
+    template <size_t N>
+    explicit TelemetryWriter(char (&buffer)[N]) : TelemetryWriter(buffer, N) {}
+
+    void BeginObject() { Separator(); Append('{'); first_ = true; }
+    void EndObject() { Append('}'); first_ = false; }
+    void BeginArray() { Separator(); Append('['); first_ = true; }
+    void EndArray() { Append(']'); first_ = false; }
+
+    template <typename T>
+    void Field(const char* key, T value) {
+        Separator();
+        AppendString(key);
+        Append(':');
+        first_ = true;
+        Value(value);
+    }
+
+    // 数组元素或单独的值
+    template <typename T>
+    void Value(T value) {
+        Separator();
+        if constexpr (std::is_same_v<T, bool>) {
+            AppendRaw(value ? "true" : "false");
+        } else if constexpr (std::is_integral_v<T>) {
+            if constexpr (std::is_signed_v<T>) {
+                AppendFormat("%lld", (long long)value);
+            } else {
+                AppendFormat("%llu", (unsigned long long)value);
+            }
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if (std::isfinite(value)) {
+                AppendFormat("%.2f", (double)value);
+            } else {
+                AppendRaw("null");
+            }
+        } else {
+            static_assert(std::is_convertible_v<T, const char*>, "Unsupported telemetry field type");
+            AppendString(value);
+        }
+    }
+
+    bool ok() const { return !overflow_; }
+    const char* data() const { return buffer_; }
+    size_t size() const { return size_; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    bool overflow_ = false;
+    bool first_ = true;
+
+    void Separator() {
+        if (!first_) {
+            Append(',');
+        }
+        first_ = false;
+    }
+
+    // 始终保留结尾的'\0'
+    void Append(char c) {
+        if (size_ + 1 >= capacity_) {
+            overflow_ = true;
+            return;
+        }
+        buffer_[size_++] = c;
+        buffer_[size_] = '\0';
+    }
+
+    void AppendRaw(const char* str) {
+        while (*str) {
+            Append(*str++);
+        }
+    }
+
+    template <typename... Args>
+    void AppendFormat(const char* format, Args... args) {
+        size_t available = capacity_ > size_ ? capacity_ - size_ : 0;
+        int length = snprintf(buffer_ + size_, available, format, args...);
+        if (length < 0 || (size_t)length >= available) {
+            overflow_ = true;
+            if (available > 0) {
+                buffer_[size_] = '\0';
+            }
+            return;
+        }
+        size_ += length;
+    }
+
+    void AppendString(const char* str) {
+        static const char hex[] = "0123456789abcdef";
+        Append('"');
+        for (; *str; str++) {
+            char c = *str;
+            if (c == '"' || c == '\\') {
+                Append('\\');
+                Append(c);
+            } else if ((unsigned char)c < 0x20) {
+                AppendRaw("\\u00");
+                Append(hex[(c >> 4) & 0x0f]);
+                Append(hex[c & 0x0f]);
+            } else {
+                Append(c);
+            }
+        }
+        Append('"');
+    }
+};
+
+#endif // TELEMETRY_WRITER_H
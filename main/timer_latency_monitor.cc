@@ -0,0 +1,62 @@
+#include "timer_latency_monitor.h"
+
+#include <esp_log.h>
+
+#define TAG "TimerLatency"
+
+// Callbacks delayed by more than this are counted as late
+#define TIMER_LATENCY_LATE_US 50000
+
+TimerLatencyMonitor::TimerLatencyMonitor() {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            static_cast<TimerLatencyMonitor*>(arg)->OnTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "latency_monitor",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&timer_args, &timer_);
+}
+
+TimerLatencyMonitor::~TimerLatencyMonitor() {
+    if (timer_ != nullptr) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+    }
+}
+
+void TimerLatencyMonitor::Start() {
+    expected_time_us_ = esp_timer_get_time() + TIMER_LATENCY_MONITOR_PERIOD_US;
+    esp_timer_start_periodic(timer_, TIMER_LATENCY_MONITOR_PERIOD_US);
+}
+
+void TimerLatencyMonitor::OnTimer() {
+    int64_t now = esp_timer_get_time();
+    int64_t latency = now - expected_time_us_;
+    // Missed periods are skipped (skip_unhandled_events), not replayed
+    while (expected_time_us_ <= now) {
+        expected_time_us_ += TIMER_LATENCY_MONITOR_PERIOD_US;
+    }
+    if (latency < 0) {
+        return;
+    }
+    if (latency > window_max_us_.load(std::memory_order_relaxed)) {
+        window_max_us_.store(latency, std::memory_order_relaxed);
+    }
+    if (latency > max_us_.load(std::memory_order_relaxed)) {
+        max_us_.store(latency, std::memory_order_relaxed);
+    }
+    if (latency >= TIMER_LATENCY_LATE_US) {
+        late_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TimerLatencyMonitor::Print() {
+    int64_t window_max = window_max_us_.exchange(0, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "esp_timer latency: max %lld us (since boot %lld us), %lu callbacks late by >= %d ms",
+        (long long)window_max, (long long)max_us_.load(std::memory_order_relaxed),
+        (unsigned long)late_count_.load(std::memory_order_relaxed),
+        TIMER_LATENCY_LATE_US / 1000);
+}
@@ -0,0 +1,36 @@
+#ifndef TIMER_LATENCY_MONITOR_H
+#define TIMER_LATENCY_MONITOR_H
+
+#include <esp_timer.h>
+#include <atomic>
+#include <cstdint>
+
+#define TIMER_LATENCY_MONITOR_PERIOD_US 100000
+
+/*
+ * Measures how late callbacks run on the shared esp_timer task.
+ * A 100ms periodic timer records the delay between its expected and actual dispatch time;
+ * a callback that blocks the esp_timer task shows up as a spike in this delay.
+ */
+class TimerLatencyMonitor {
+public:
+    TimerLatencyMonitor();
+    ~TimerLatencyMonitor();
+
+    void Start();
+    // Log the max latency since the last call and since boot
+    void Print();
+    int64_t max_latency_us() const { return max_us_.load(std::memory_order_relaxed); }
+    uint32_t late_count() const { return late_count_.load(std::memory_order_relaxed); }
+
+private:
+    esp_timer_handle_t timer_ = nullptr;
+    int64_t expected_time_us_ = 0;
+    std::atomic<int64_t> window_max_us_{0};
+    std::atomic<int64_t> max_us_{0};
+    std::atomic<uint32_t> late_count_{0};
+
+    void OnTimer();
+};
+
+#endif // TIMER_LATENCY_MONITOR_H